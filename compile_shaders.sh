@@ -15,3 +15,7 @@ for f in ./Executable/Shaders/*.frag; do
     rm $f
 done
 
+for f in ./Executable/Shaders/*.comp; do
+    ./glslc $f -o $f.spv
+    rm $f
+done
@@ -4,5 +4,6 @@ rm -r ./Executable/
 mkdir ./Executable/
 cp -r ./Resources/ ./Executable/
 cp ./Bin/XOblivion ./Executable/
+cp ./Bin/XOblivionBenchmark ./Executable/
 ./compile_shaders.sh
 
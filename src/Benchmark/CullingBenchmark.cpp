@@ -0,0 +1,77 @@
+#include <Oblivion.h>
+#include "../Graphics/Utils/FrustumCulling.h"
+#include "../Gameplay/FirstPersonCamera.h"
+
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstring>
+
+constexpr const uint32_t CULLING_DEFAULT_OBJECTS = 100000;
+constexpr const uint32_t CULLING_DEFAULT_ITERATIONS = 200;
+
+// Frustum culling microbenchmark: random boxes and spheres around a camera, every compiled kernel timed on the same
+// data and checked against the scalar one
+int main(int argc, char** argv)
+{
+    uint32_t objects = CULLING_DEFAULT_OBJECTS;
+    uint32_t iterations = CULLING_DEFAULT_ITERATIONS;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--objects") && i + 1 < argc)
+            objects = (uint32_t)std::stoul(argv[++i]);
+        else if (!strcmp(argv[i], "--iterations") && i + 1 < argc)
+            iterations = (uint32_t)std::stoul(argv[++i]);
+    }
+
+    FirstPersonCamera camera(glm::radians(60.f), 4.f / 3.f, 0.1f, 1000.f);
+    camera.construct();
+    Frustum frustum = camera.getFrustum();
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> size(0.1f, 5.0f);
+    FrustumCulling::BoxBounds boxes;
+    FrustumCulling::SphereBounds spheres;
+    boxes.resize(objects);
+    spheres.resize(objects);
+    for (uint32_t i = 0; i < objects; ++i)
+    {
+        glm::vec3 center(position(random), position(random), position(random));
+        boxes.set(i, center, glm::vec3(size(random), size(random), size(random)));
+        spheres.set(i, center, size(random));
+    }
+
+    std::vector<uint32_t> reference(objects), visible(objects);
+    uint32_t referenceBoxes = FrustumCulling::cullBoxes(frustum, boxes, reference.data(), FrustumCulling::Kernel::eScalar);
+
+    int result = 0;
+    printf("%u objects, %u iterations, %u boxes visible\n", objects, iterations, referenceBoxes);
+    for (auto kernel : { FrustumCulling::Kernel::eScalar, FrustumCulling::Kernel::eSSE, FrustumCulling::Kernel::eAVX })
+    {
+        if (!FrustumCulling::isKernelAvailable(kernel))
+        {
+            printf("%-8s not available\n", FrustumCulling::getKernelName(kernel));
+            continue;
+        }
+
+        uint32_t visibleBoxes = 0, visibleSpheres = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < iterations; ++i)
+            visibleBoxes = FrustumCulling::cullBoxes(frustum, boxes, visible.data(), kernel);
+        double boxMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+        bool matches = visibleBoxes == referenceBoxes && std::equal(reference.begin(), reference.begin() + referenceBoxes, visible.begin());
+
+        start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < iterations; ++i)
+            visibleSpheres = FrustumCulling::cullSpheres(frustum, spheres, visible.data(), kernel);
+        double sphereMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+        printf("%-8s boxes: %10.0f objects/ms   spheres: %10.0f objects/ms   (%u spheres visible)%s\n",
+            FrustumCulling::getKernelName(kernel), objects / boxMilliseconds, objects / sphereMilliseconds, visibleSpheres,
+            matches ? "" : "   MISMATCH");
+        if (!matches)
+            result = 1;
+    }
+    return result;
+}
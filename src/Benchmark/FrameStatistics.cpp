@@ -0,0 +1,105 @@
+#include "FrameStatistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+namespace
+{
+    double percentile(const std::vector<double>& sorted, double p)
+    { // Nearest-rank on an already sorted sample set
+        if (sorted.empty())
+            return 0.0;
+        size_t rank = (size_t)std::ceil(p / 100.0 * (double)sorted.size());
+        rank = std::min(std::max(rank, (size_t)1), sorted.size());
+        return sorted[rank - 1];
+    }
+
+    boost::property_tree::ptree summaryTree(const FrameStatistics::Summary& summary)
+    {
+        boost::property_tree::ptree tree;
+        tree.put("samples", summary.samples);
+        tree.put("mean", summary.mean);
+        tree.put("min", summary.min);
+        tree.put("max", summary.max);
+        tree.put("p50", summary.p50);
+        tree.put("p95", summary.p95);
+        tree.put("p99", summary.p99);
+        return tree;
+    }
+}
+
+FrameStatistics::FrameStatistics(uint32_t totalFrames) :
+    m_cpuTimes(totalFrames), m_gpuTimes(totalFrames)
+{
+}
+
+auto FrameStatistics::addCpuSample(uint32_t frame, double milliseconds) -> void
+{
+    if (frame < m_cpuTimes.size())
+        m_cpuTimes[frame] = milliseconds;
+}
+
+auto FrameStatistics::addGpuSample(uint32_t frame, double milliseconds) -> void
+{
+    if (frame < m_gpuTimes.size())
+        m_gpuTimes[frame] = milliseconds;
+}
+
+auto FrameStatistics::summarize(const std::vector<std::optional<double>>& samples) -> Summary
+{
+    std::vector<double> sorted;
+    sorted.reserve(samples.size());
+    for (const auto& it : samples)
+    {
+        if (it)
+            sorted.push_back(*it);
+    }
+
+    Summary summary;
+    if (sorted.empty())
+        return summary;
+
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0.0;
+    for (auto it : sorted)
+        total += it;
+
+    summary.samples = sorted.size();
+    summary.mean = total / (double)sorted.size();
+    summary.min = sorted.front();
+    summary.max = sorted.back();
+    summary.p50 = percentile(sorted, 50.0);
+    summary.p95 = percentile(sorted, 95.0);
+    summary.p99 = percentile(sorted, 99.0);
+    return summary;
+}
+
+auto FrameStatistics::dumpJson(std::ostream& stream, const std::string& name,
+    uint32_t width, uint32_t height) const -> void
+{
+    boost::property_tree::ptree root;
+    root.put("name", name);
+    root.put("frames", m_cpuTimes.size());
+    root.put("width", width);
+    root.put("height", height);
+    root.add_child("cpu", summaryTree(summarize(m_cpuTimes)));
+    root.add_child("gpu", summaryTree(summarize(m_gpuTimes)));
+
+    boost::property_tree::ptree frames;
+    for (size_t i = 0; i < m_cpuTimes.size(); ++i)
+    {
+        boost::property_tree::ptree frame;
+        frame.put("frame", i);
+        if (m_cpuTimes[i])
+            frame.put("cpu", *m_cpuTimes[i]);
+        if (m_gpuTimes[i])
+            frame.put("gpu", *m_gpuTimes[i]);
+        frames.push_back(std::make_pair("", frame));
+    }
+    root.add_child("perFrame", frames);
+
+    boost::property_tree::write_json(stream, root);
+}
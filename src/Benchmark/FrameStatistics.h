@@ -0,0 +1,37 @@
+#pragma once
+
+
+#include <Oblivion.h>
+
+
+class FrameStatistics
+{
+public:
+    struct Summary
+    {
+        double      mean = 0.0;
+        double      min = 0.0;
+        double      max = 0.0;
+        double      p50 = 0.0;
+        double      p95 = 0.0;
+        double      p99 = 0.0;
+        size_t      samples = 0;
+    };
+
+public:
+    FrameStatistics(uint32_t totalFrames);
+
+public:
+    auto                                addCpuSample(uint32_t frame, double milliseconds) -> void;
+    auto                                addGpuSample(uint32_t frame, double milliseconds) -> void;
+
+    auto                                dumpJson(std::ostream& stream, const std::string& name,
+                                            uint32_t width, uint32_t height) const -> void;
+
+public:
+    static auto                         summarize(const std::vector<std::optional<double>>& samples) -> Summary;
+
+private:
+    std::vector<std::optional<double>>  m_cpuTimes;
+    std::vector<std::optional<double>>  m_gpuTimes;
+};
@@ -0,0 +1,319 @@
+#include <Oblivion.h>
+#include "../Core/JobSystem.h"
+#include "../Graphics/Utils/VertexWelder.h"
+#include "../Graphics/Utils/MeshOptimizer.h"
+#include "../Graphics/Utils/MeshSimplifier.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <set>
+#include <tuple>
+
+#include <random>
+#include <string>
+#include <map>
+#include <unordered_map>
+#include <cstring>
+
+constexpr const uint32_t MESH_CHECKS_DEFAULT_SEED = 42;
+constexpr const uint32_t MESH_CHECKS_GRID_SIZE = 300;    // Quads per side, 180k triangles
+
+namespace
+{
+    uint32_t failures = 0;
+
+    auto check(bool condition, const char* what) -> void
+    {
+        if (!condition)
+        {
+            printf("    FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+
+    // Sequential first occurrence weld on the raw bits, what VertexWelder::weld promises to match
+    auto referenceWeld(const std::vector<PositionColorVertex>& corners,
+        std::vector<PositionColorVertex>& vertices, std::vector<uint32_t>& indices) -> void
+    {
+        std::unordered_map<std::string, uint32_t> unique;
+        vertices.clear();
+        indices.clear();
+        for (const auto& corner : corners)
+        {
+            std::string key(reinterpret_cast<const char*>(&corner), sizeof(PositionColorVertex));
+            auto it = unique.emplace(key, (uint32_t)vertices.size());
+            if (it.second)
+                vertices.push_back(corner);
+            indices.push_back(it.first->second);
+        }
+    }
+
+    using Corner = std::tuple<float, float, float, float>;
+    using Triangle = std::array<Corner, 3>;
+
+    // Triangles by the content of their corners, rotated to start at the smallest one so the winding is kept.
+    // Equal lists draw the same surface whatever the triangle order and vertex numbering
+    auto getTriangles(const std::vector<PositionColorVertex>& vertices, const std::vector<uint32_t>& indices) -> std::vector<Triangle>
+    {
+        std::vector<Triangle> triangles(indices.size() / 3);
+        for (size_t i = 0; i < triangles.size(); ++i)
+        {
+            for (uint32_t corner = 0; corner < 3; ++corner)
+            {
+                const auto& position = vertices[indices[i * 3 + corner]].position;
+                triangles[i][corner] = Corner(position.x, position.y, position.z, position.w);
+            }
+            std::rotate(triangles[i].begin(), std::min_element(triangles[i].begin(), triangles[i].end()), triangles[i].end());
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    // A flat grid of quads whose triangles are shuffled, so the input has no locality at all
+    auto createShuffledGrid(std::mt19937& random, std::vector<PositionColorVertex>& vertices, std::vector<uint32_t>& indices) -> void
+    {
+        const uint32_t size = MESH_CHECKS_GRID_SIZE;
+        vertices.clear();
+        for (uint32_t y = 0; y <= size; ++y)
+        {
+            for (uint32_t x = 0; x <= size; ++x)
+                vertices.emplace_back((float)x, (float)y, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f);
+        }
+
+        std::vector<std::array<uint32_t, 3>> triangles;
+        for (uint32_t y = 0; y < size; ++y)
+        {
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                uint32_t corner = y * (size + 1) + x;
+                triangles.push_back({ corner, corner + 1, corner + size + 2 });
+                triangles.push_back({ corner, corner + size + 2, corner + size + 1 });
+            }
+        }
+        std::shuffle(triangles.begin(), triangles.end(), random);
+        indices.clear();
+        for (const auto& it : triangles)
+            indices.insert(indices.end(), it.begin(), it.end());
+    }
+
+    auto checkOptimizer(std::mt19937& random) -> void
+    {
+        std::vector<PositionColorVertex> gridVertices;
+        std::vector<uint32_t> gridIndices;
+        createShuffledGrid(random, gridVertices, gridIndices);
+        auto reference = getTriangles(gridVertices, gridIndices);
+
+        for (float threshold : { 1.05f, 0.0f })
+        {
+            printf("MeshOptimizer::optimize, shuffled %u triangle grid, overdraw threshold %.2f\n",
+                (uint32_t)gridIndices.size() / 3, threshold);
+            auto vertices = gridVertices;
+            auto indices = gridIndices;
+            auto stats = MeshOptimizer::optimize(vertices, indices, threshold);
+            printf("    ACMR %.3f -> %.3f, %u clusters\n", stats.m_acmrBefore, stats.m_acmrAfter, stats.m_clusters);
+
+            check(stats.m_acmrAfter < stats.m_acmrBefore, "ACMR improves");
+            check(indices.size() == gridIndices.size(), "same number of triangles");
+            check(getTriangles(vertices, indices) == reference, "same triangles with the same winding");
+
+            // optimizeVertexFetch: vertices numbered in order of first use, none left unreferenced
+            uint32_t nextVertex = 0;
+            bool firstUseOrder = true;
+            for (uint32_t index : indices)
+            {
+                if (index == nextVertex)
+                    ++nextVertex;
+                else if (index > nextVertex)
+                    firstUseOrder = false;
+            }
+            check(firstUseOrder, "vertices numbered in order of first use");
+            check(nextVertex == vertices.size(), "no unreferenced vertex");
+        }
+    }
+
+    // Edges used by a single triangle, as (from, to) in winding order
+    auto getOpenEdges(const std::vector<uint32_t>& indices) -> std::set<std::pair<uint32_t, uint32_t>>
+    {
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> uses;
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                uint32_t a = indices[i + k], b = indices[i + (k + 1) % 3];
+                ++uses[std::make_pair(std::min(a, b), std::max(a, b))];
+            }
+        }
+        std::set<std::pair<uint32_t, uint32_t>> result;
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                uint32_t a = indices[i + k], b = indices[i + (k + 1) % 3];
+                if (uses[std::make_pair(std::min(a, b), std::max(a, b))] == 1)
+                    result.emplace(a, b);
+            }
+        }
+        return result;
+    }
+
+    auto getNormal(const std::vector<PositionColorVertex>& vertices, const uint32_t* triangle) -> glm::vec3
+    {
+        glm::vec3 a(vertices[triangle[0]].position), b(vertices[triangle[1]].position), c(vertices[triangle[2]].position);
+        return glm::cross(b - a, c - a);
+    }
+
+    // Runs the simplifier and checks what MeshSimplifier.h promises. outward gives the expected facing of a
+    // triangle from its centroid, no kept triangle may point against it
+    template <typename Outward>
+    auto checkSimplify(const char* name, const std::vector<PositionColorVertex>& vertices, const std::vector<uint32_t>& indices,
+        float targetError, Outward outward) -> void
+    {
+        uint32_t targetIndexCount = (uint32_t)indices.size() / 10 / 3 * 3;
+        printf("MeshSimplifier::simplify, %s, %u -> %u indices at most, target error %.3f\n",
+            name, (uint32_t)indices.size(), targetIndexCount, targetError);
+
+        float error = 0.0f;
+        auto simplified = MeshSimplifier::simplify(indices, vertices.data(), (uint32_t)vertices.size(), targetIndexCount, targetError, &error);
+        printf("    %u indices, error %.5f\n", (uint32_t)simplified.size(), error);
+
+        check(simplified.size() < indices.size() && simplified.size() % 3 == 0, "fewer whole triangles");
+        check(error <= targetError, "reported error within targetError");
+        // Border and seam vertices are locked, so every open edge is kept as is and no new one appears
+        check(getOpenEdges(simplified) == getOpenEdges(indices), "same open edges, borders and seams untouched");
+
+        bool flipped = false;
+        for (size_t i = 0; i < simplified.size(); i += 3)
+        {
+            glm::vec3 centroid = (glm::vec3(vertices[simplified[i]].position) + glm::vec3(vertices[simplified[i + 1]].position) +
+                glm::vec3(vertices[simplified[i + 2]].position)) / 3.0f;
+            flipped |= glm::dot(getNormal(vertices, &simplified[i]), outward(centroid)) <= 0.0f;
+        }
+        check(!flipped, "no triangle flipped");
+    }
+
+    auto checkSimplifier() -> void
+    {
+        // Plane with an open border, split along x = size / 2 by a seam: the two halves have their own copies of
+        // the seam vertices, with another colour
+        const uint32_t size = 64;
+        std::vector<PositionColorVertex> vertices;
+        std::vector<uint32_t> indices;
+        for (uint32_t half = 0; half < 2; ++half)
+        {
+            uint32_t first = (uint32_t)vertices.size();
+            uint32_t columns = size / 2 + 1;
+            for (uint32_t y = 0; y <= size; ++y)
+            {
+                for (uint32_t x = 0; x < columns; ++x)
+                {
+                    vertices.emplace_back((float)(half * size / 2 + x) / size, (float)y / size, 0.0f, 1.0f,
+                        (float)half, 0.0f, 0.0f, 1.0f);
+                }
+            }
+            for (uint32_t y = 0; y < size; ++y)
+            {
+                for (uint32_t x = 0; x + 1 < columns; ++x)
+                {
+                    uint32_t corner = first + y * columns + x;
+                    indices.insert(indices.end(), { corner, corner + 1, corner + columns + 1 });
+                    indices.insert(indices.end(), { corner, corner + columns + 1, corner + columns });
+                }
+            }
+        }
+        checkSimplify("plane with a border and a seam", vertices, indices, 0.01f,
+            [](const glm::vec3&) { return glm::vec3(0.0f, 0.0f, 1.0f); });
+
+        // Closed unit sphere, rings of latitude between two poles
+        const uint32_t rings = 48, segments = 96;
+        const float pi = 3.14159265358979f;
+        vertices.clear();
+        indices.clear();
+        vertices.emplace_back(0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f);
+        for (uint32_t ring = 1; ring < rings; ++ring)
+        {
+            float theta = pi * ring / rings;
+            for (uint32_t segment = 0; segment < segments; ++segment)
+            {
+                float phi = 2.0f * pi * segment / segments;
+                vertices.emplace_back(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi), 1.0f,
+                    1.0f, 1.0f, 1.0f, 1.0f);
+            }
+        }
+        vertices.emplace_back(0.0f, -1.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f);
+        uint32_t southPole = (uint32_t)vertices.size() - 1;
+        auto ringVertex = [&](uint32_t ring, uint32_t segment) { return 1 + (ring - 1) * segments + segment % segments; };
+        auto addTriangle = [&](uint32_t a, uint32_t b, uint32_t c)
+        { // Wound to face away from the center
+            glm::vec3 centroid = (glm::vec3(vertices[a].position) + glm::vec3(vertices[b].position) + glm::vec3(vertices[c].position)) / 3.0f;
+            uint32_t triangle[3] = { a, b, c };
+            if (glm::dot(getNormal(vertices, triangle), centroid) < 0.0f)
+                std::swap(b, c);
+            indices.insert(indices.end(), { a, b, c });
+        };
+        for (uint32_t segment = 0; segment < segments; ++segment)
+        {
+            addTriangle(0, ringVertex(1, segment), ringVertex(1, segment + 1));
+            addTriangle(southPole, ringVertex(rings - 1, segment), ringVertex(rings - 1, segment + 1));
+            for (uint32_t ring = 1; ring + 1 < rings; ++ring)
+            {
+                addTriangle(ringVertex(ring, segment), ringVertex(ring + 1, segment), ringVertex(ring + 1, segment + 1));
+                addTriangle(ringVertex(ring, segment), ringVertex(ring + 1, segment + 1), ringVertex(ring, segment + 1));
+            }
+        }
+        checkSimplify("closed sphere", vertices, indices, 0.02f, [](const glm::vec3& centroid) { return centroid; });
+    }
+
+    // Corners drawn from a small pool, so most of them are duplicates spread over every chunk of the welder
+    auto checkWelder(std::mt19937& random) -> void
+    {
+        for (uint32_t count : { 3u, 1000u, 5u * 65536u + 123u })
+        {
+            printf("VertexWelder::weld, %u corners\n", count);
+            std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+            std::vector<PositionColorVertex> pool(std::max(count / 16, 1u));
+            for (auto& it : pool)
+                it = PositionColorVertex(value(random), value(random), value(random), 1.0f, value(random), value(random), value(random), 1.0f);
+            // Equal as floats but not as bits, they must stay apart
+            pool[0] = PositionColorVertex(0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+            if (pool.size() > 1)
+                pool[1] = PositionColorVertex(-0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+
+            std::uniform_int_distribution<uint32_t> pick(0, (uint32_t)pool.size() - 1);
+            std::vector<PositionColorVertex> corners(count);
+            for (auto& it : corners)
+                it = pool[pick(random)];
+
+            std::vector<PositionColorVertex> vertices, referenceVertices;
+            std::vector<uint32_t> indices, referenceIndices;
+            VertexWelder::weld(corners, vertices, indices);
+            referenceWeld(corners, referenceVertices, referenceIndices);
+
+            check(vertices.size() == referenceVertices.size(), "same number of unique vertices");
+            check(vertices.size() == referenceVertices.size() &&
+                memcmp(vertices.data(), referenceVertices.data(), vertices.size() * sizeof(PositionColorVertex)) == 0,
+                "same vertices in first occurrence order");
+            check(indices == referenceIndices, "same indices");
+        }
+    }
+}
+
+// Self checking runs of the mesh processing on random input, every result compared with a plain reference
+int main(int argc, char** argv)
+{
+    uint32_t seed = MESH_CHECKS_DEFAULT_SEED;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            seed = (uint32_t)std::stoul(argv[++i]);
+    }
+
+    std::mt19937 random(seed);
+    checkWelder(random);
+    checkOptimizer(random);
+    checkSimplifier();
+
+    JobSystem::reset();
+    printf("%s, seed %u\n", failures == 0 ? "All checks passed" : "Some checks FAILED", seed);
+    return failures == 0 ? 0 : 1;
+}
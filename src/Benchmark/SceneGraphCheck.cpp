@@ -0,0 +1,190 @@
+#include <Oblivion.h>
+#include "../Scenes/SceneGraph.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <map>
+#include <random>
+#include <string>
+#include <cstring>
+
+constexpr const uint32_t SCENE_GRAPH_CHECK_DEFAULT_SEED = 42;
+constexpr const uint32_t SCENE_GRAPH_CHECK_DEFAULT_STEPS = 20000;
+
+namespace
+{
+    struct ReferenceNode
+    {
+        SceneGraph::NodeId parent;
+        glm::mat4 local;
+    };
+
+    using ReferenceHierarchy = std::map<SceneGraph::NodeId, ReferenceNode>;
+
+    auto getRandomTransform(std::mt19937& random) -> glm::mat4
+    {
+        std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+        glm::vec3 axis(offset(random), offset(random), offset(random));
+        if (glm::length(axis) < 0.01f)
+            axis = glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::mat4 translation = glm::translate(glm::mat4(1.0f), glm::vec3(offset(random), offset(random), offset(random)));
+        return glm::rotate(translation, angle(random), glm::normalize(axis));
+    }
+
+    // Walks the parent chain of the reference, memoized so a full check stays linear in the node count
+    auto getReferenceWorld(const ReferenceHierarchy& hierarchy, SceneGraph::NodeId node,
+        std::map<SceneGraph::NodeId, glm::mat4>& worlds) -> const glm::mat4&
+    {
+        auto found = worlds.find(node);
+        if (found != worlds.end())
+            return found->second;
+
+        const ReferenceNode& reference = hierarchy.at(node);
+        glm::mat4 world = reference.parent != SceneGraph::_invalidNode ?
+            getReferenceWorld(hierarchy, reference.parent, worlds) * reference.local : reference.local;
+        return worlds.emplace(node, world).first->second;
+    }
+
+    auto isClose(const glm::mat4& a, const glm::mat4& b) -> bool
+    {
+        for (int column = 0; column < 4; ++column)
+        {
+            for (int row = 0; row < 4; ++row)
+            {
+                float difference = std::fabs(a[column][row] - b[column][row]);
+                if (difference > 1e-4f * (1.0f + std::fabs(b[column][row])))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    auto checkGraph(SceneGraph& graph, const ReferenceHierarchy& hierarchy, uint32_t step) -> bool
+    {
+        graph.update();
+        if (graph.getNodeCount() != hierarchy.size())
+        {
+            printf("    FAILED at step %u: %u nodes, the reference has %u\n", step, graph.getNodeCount(), (uint32_t)hierarchy.size());
+            return false;
+        }
+
+        std::map<SceneGraph::NodeId, glm::mat4> worlds;
+        for (const auto& [node, reference] : hierarchy)
+        {
+            if (graph.getParent(node) != reference.parent)
+            {
+                printf("    FAILED at step %u: node %u has parent %u, the reference has %u\n", step, node, graph.getParent(node), reference.parent);
+                return false;
+            }
+            if (graph.getLocalTransform(node) != reference.local)
+            {
+                printf("    FAILED at step %u: local transform of node %u differs from the reference\n", step, node);
+                return false;
+            }
+            if (!isClose(graph.getWorldTransform(node), getReferenceWorld(hierarchy, node, worlds)))
+            {
+                printf("    FAILED at step %u: world transform of node %u differs from the reference\n", step, node);
+                return false;
+            }
+        }
+
+        // Nothing changed since, so a second update must not touch any node
+        graph.update();
+        if (graph.getUpdatedCount() != 0)
+        {
+            printf("    FAILED at step %u: an update without changes recomputed %u nodes\n", step, graph.getUpdatedCount());
+            return false;
+        }
+        return true;
+    }
+}
+
+// Randomized SceneGraph check: creates, modifies and destroys nodes, and after every few operations compares the
+// hierarchy and world transforms with a reference that recomputes every world matrix from its parent chain
+int main(int argc, char** argv)
+{
+    uint32_t seed = SCENE_GRAPH_CHECK_DEFAULT_SEED;
+    uint32_t steps = SCENE_GRAPH_CHECK_DEFAULT_STEPS;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            seed = (uint32_t)std::stoul(argv[++i]);
+        else if (!strcmp(argv[i], "--steps") && i + 1 < argc)
+            steps = (uint32_t)std::stoul(argv[++i]);
+    }
+
+    std::mt19937 random(seed);
+    SceneGraph graph;
+    ReferenceHierarchy hierarchy;
+    std::vector<SceneGraph::NodeId> alive;
+    uint32_t created = 0, modified = 0, destroyed = 0, checks = 0;
+    bool passed = true;
+
+    for (uint32_t step = 0; step < steps && passed; ++step)
+    {
+        uint32_t operation = random() % 10;
+        if (operation < 6 || alive.empty())
+        {
+            // A quarter of the new nodes are roots, the rest hang below any live node
+            SceneGraph::NodeId parent = alive.empty() || random() % 4 == 0 ? SceneGraph::_invalidNode : alive[random() % alive.size()];
+            glm::mat4 local = getRandomTransform(random);
+            SceneGraph::NodeId node = graph.createNode(parent, local);
+            if (hierarchy.count(node))
+            {
+                printf("    FAILED at step %u: node %u was handed out while still alive\n", step, node);
+                passed = false;
+                break;
+            }
+            hierarchy[node] = { parent, local };
+            alive.push_back(node);
+            ++created;
+        }
+        else if (operation < 9)
+        {
+            SceneGraph::NodeId node = alive[random() % alive.size()];
+            glm::mat4 local = getRandomTransform(random);
+            graph.setLocalTransform(node, local);
+            hierarchy[node].local = local;
+            ++modified;
+        }
+        else
+        {
+            // The graph drops the whole subtree, the reference collects it through the parent links
+            SceneGraph::NodeId node = alive[random() % alive.size()];
+            graph.destroyNode(node);
+
+            std::map<SceneGraph::NodeId, bool> removed;
+            for (const auto& entry : hierarchy)
+            {
+                SceneGraph::NodeId ancestor = entry.first;
+                while (ancestor != SceneGraph::_invalidNode && ancestor != node)
+                    ancestor = hierarchy.at(ancestor).parent;
+                removed[entry.first] = ancestor == node;
+            }
+            alive.clear();
+            for (const auto& [id, isRemoved] : removed)
+            {
+                if (isRemoved)
+                {
+                    hierarchy.erase(id);
+                    ++destroyed;
+                }
+                else
+                    alive.push_back(id);
+            }
+        }
+
+        if (random() % 7 == 0 || step + 1 == steps)
+        {
+            passed = checkGraph(graph, hierarchy, step);
+            ++checks;
+        }
+    }
+
+    printf("SceneGraph, %u created, %u modified, %u destroyed, %u checks, %u nodes left\n",
+        created, modified, destroyed, checks, graph.getNodeCount());
+    printf("%s, seed %u\n", passed ? "All checks passed" : "Some checks FAILED", seed);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+#include "../Game.h"
+#include "../Core/Window.h"
+#include "../Core/CpuProfiler.h"
+#include "../Graphics/VulkanRenderer.h"
+#include "../Graphics/Utils/GpuProfiler.h"
+#include "../Gameplay/CameraPath.h"
+
+#include "FrameStatistics.h"
+
+constexpr const uint32_t BENCHMARK_DEFAULT_FRAMES = 1000;
+constexpr const uint32_t BENCHMARK_DEFAULT_WARMUP = 30;
+
+int main(int argc, char** argv)
+{
+    bool headless = true;
+    uint32_t frames = BENCHMARK_DEFAULT_FRAMES;
+    uint32_t warmup = BENCHMARK_DEFAULT_WARMUP;
+    std::string output = "benchmark.json";
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--windowed"))
+            headless = false;
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+            frames = (uint32_t)std::stoul(argv[++i]);
+        else if (!strcmp(argv[i], "--warmup") && i + 1 < argc)
+            warmup = (uint32_t)std::stoul(argv[++i]);
+        else if (!strcmp(argv[i], "--output") && i + 1 < argc)
+            output = argv[++i];
+    }
+
+    int result = 0;
+    try
+    {
+        auto game = Game::Get(headless, frames);
+        auto path = CameraPath::createOrbit(glm::vec3(0.0f, 0.0f, 0.0f), 5.0f, 1.0f, frames);
+        game->getScene()->setCameraPath(&path);
+
+        // Warmup frames hold the camera at the start of the path, and run until the scene's assets are in
+        for (uint32_t i = 0; i < warmup || game->getScene()->isLoading(); ++i)
+        {
+            path.reset();
+            game->step();
+            if (!headless)
+                WindowObject::Get()->pollEvents();
+        }
+        path.reset();
+
+        // The renderer counts frames from its first submission, warmup included
+        uint64_t firstFrame = VulkanRenderer::Get()->getFrameNumber() + 1;
+        FrameStatistics statistics(frames);
+        auto addGpuSample = [&statistics, firstFrame]()
+        {
+            if (const auto& gpuTime = GpuProfiler::Get()->getFrameResult(); gpuTime && gpuTime->m_frame >= firstFrame)
+                statistics.addGpuSample((uint32_t)(gpuTime->m_frame - firstFrame), gpuTime->m_milliseconds);
+        };
+        for (uint32_t i = 0; i < frames; ++i)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            game->step();
+            auto end = std::chrono::high_resolution_clock::now();
+            statistics.addCpuSample(i, std::chrono::duration<double, std::milli>(end - start).count());
+
+            // GPU times arrive once the frame's fence was waited on, a couple of frames later
+            addGpuSample();
+
+            if (!headless)
+                WindowObject::Get()->pollEvents();
+        }
+        game->getScene()->setCameraPath(nullptr);
+
+        // The last in-flight frames were never waited on by an acquire, collect them oldest first
+        auto renderer = VulkanRenderer::Get();
+        renderer->wait();
+        for (uint32_t i = 0; i < VulkanRenderer::getMaxInFlightFrames(); ++i)
+        {
+            GpuProfiler::Get()->collect((renderer->getInFlightFrame() + i) % VulkanRenderer::getMaxInFlightFrames());
+            addGpuSample();
+        }
+
+        auto extent = VulkanRenderer::Get()->getVulkanSwapchainCreateInfo().m_extent;
+        std::ofstream stream(output);
+        statistics.dumpJson(stream, "SimpleScene", extent.width, extent.height);
+        stream.close();
+
+        game->reset();
+    }
+    catch (const std::exception& e)
+    {
+        ERROR(e.what());
+        result = 1;
+    }
+    catch (...)
+    {
+        ERROR("Unexpected error");
+        result = 1;
+    }
+
+    std::ofstream logs("logs.txt");
+    Logger::dumpJson(logs);
+    logs.close();
+
+    std::ofstream trace("trace.json");
+    CpuProfiler::dumpChromeTrace(trace);
+    trace.close();
+
+    return result;
+}
@@ -3,14 +3,18 @@
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
+#include <mutex>
+
 namespace Logger
 {
 	boost::property_tree::ptree logTree;
 
 	boost::property_tree::ptree notes, warnings, errors;
+	std::mutex logMutex; // Worker threads log too
 
 	void addLog(LogType type, const std::string& message)
 	{
+		std::lock_guard<std::mutex> lock(logMutex);
 		switch (type)
 		{
 		case LogType::NOTE:
@@ -29,6 +33,7 @@ namespace Logger
 
 	void dumpJson(std::ostream & stream)
 	{
+		std::lock_guard<std::mutex> lock(logMutex);
 		boost::property_tree::ptree logs;
 		logs.push_back(std::make_pair("Notes", notes));
 		logs.push_back(std::make_pair("Warnings", warnings));
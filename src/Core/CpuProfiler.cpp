@@ -0,0 +1,96 @@
+#include "CpuProfiler.h"
+
+#include <array>
+#include <atomic>
+#include <iomanip>
+#include <mutex>
+
+namespace CpuProfiler
+{
+    constexpr const uint32_t _threadBufferSize = 1 << 16;
+
+    struct Event
+    {
+        const char*             m_name;
+        uint64_t                m_begin;
+        uint64_t                m_end;
+    };
+
+    // Single producer (the owning thread) ring; the oldest events get overwritten once it's full
+    struct ThreadBuffer
+    {
+        std::array<Event, _threadBufferSize>    m_events;
+        std::atomic<uint64_t>                   m_head{ 0 };
+        uint32_t                                m_threadId;
+    };
+
+    const auto epoch = std::chrono::steady_clock::now();
+
+    std::mutex threadBuffersMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+
+    thread_local ThreadBuffer* currentThreadBuffer = nullptr;
+
+    ThreadBuffer* getThreadBuffer()
+    {
+        if (!currentThreadBuffer)
+        { // Only taken once per thread
+            std::lock_guard<std::mutex> lock(threadBuffersMutex);
+            auto buffer = std::make_unique<ThreadBuffer>();
+            buffer->m_threadId = (uint32_t)threadBuffers.size();
+            currentThreadBuffer = buffer.get();
+            threadBuffers.push_back(std::move(buffer));
+        }
+        return currentThreadBuffer;
+    }
+
+    Zone::Zone(const char* name) :
+        m_name(name), m_begin(now())
+    {
+    }
+
+    Zone::~Zone()
+    {
+        addZone(m_name, m_begin, now());
+    }
+
+    uint64_t now()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    void addZone(const char* name, uint64_t begin, uint64_t end)
+    {
+        auto buffer = getThreadBuffer();
+        uint64_t head = buffer->m_head.load(std::memory_order_relaxed);
+        buffer->m_events[head % _threadBufferSize] = { name, begin, end };
+        buffer->m_head.store(head + 1, std::memory_order_release);
+    }
+
+    void dumpChromeTrace(std::ostream& stream)
+    {
+        std::lock_guard<std::mutex> lock(threadBuffersMutex);
+
+        stream << std::fixed << std::setprecision(3);
+        stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        for (const auto& buffer : threadBuffers)
+        {
+            uint64_t head = buffer->m_head.load(std::memory_order_acquire);
+            uint64_t tail = head > _threadBufferSize ? head - _threadBufferSize : 0;
+            for (uint64_t i = tail; i < head; ++i)
+            {
+                const auto& event = buffer->m_events[i % _threadBufferSize];
+                if (!first)
+                    stream << ",";
+                first = false;
+
+                // trace_event timestamps are in microseconds
+                stream << "\n{\"name\":\"" << event.m_name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->m_threadId
+                    << ",\"ts\":" << event.m_begin / 1000.0
+                    << ",\"dur\":" << (event.m_end - event.m_begin) / 1000.0 << "}";
+            }
+        }
+        stream << "\n]}\n";
+    }
+}
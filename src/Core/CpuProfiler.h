@@ -0,0 +1,38 @@
+#pragma once
+
+#include <Oblivion.h>
+
+
+#define CPU_PROFILE_CONCAT_IMPL(a, b) a##b
+#define CPU_PROFILE_CONCAT(a, b) CPU_PROFILE_CONCAT_IMPL(a, b)
+#define CPU_PROFILE_ZONE(name) CpuProfiler::Zone CPU_PROFILE_CONCAT(_cpuProfileZone, __LINE__)(name)
+
+
+namespace CpuProfiler
+{
+    /// <summary>
+    ///     Records the time between its construction and destruction as one event of the calling thread.
+    ///     The name must outlive the profiler (string literals are fine).
+    /// </summary>
+    class Zone
+    {
+    public:
+        Zone(const char* name);
+        ~Zone();
+
+        Zone(const Zone&) = delete;
+        Zone& operator = (const Zone&) = delete;
+
+    private:
+        const char*     m_name;
+        uint64_t        m_begin;
+    };
+
+    // Nanoseconds since the profiler's epoch
+    uint64_t now();
+
+    void addZone(const char* name, uint64_t begin, uint64_t end);
+
+    // Writes every event still held in the thread buffers in Chrome's trace_event format
+    void dumpChromeTrace(std::ostream& stream);
+}
@@ -0,0 +1,147 @@
+#include "JobSystem.h"
+#include "CpuProfiler.h"
+
+
+namespace
+{
+    // Index of the worker running on this thread, -1 on any other thread
+    thread_local int32_t currentWorker = -1;
+}
+
+JobSystem::JobSystem(uint32_t workers)
+{
+    if (workers == 0)
+        workers = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+    m_workers.reserve(workers);
+    for (uint32_t i = 0; i < workers; ++i)
+        m_workers.push_back(std::make_unique<Worker>());
+    for (uint32_t i = 0; i < workers; ++i)
+        m_workers[i]->m_thread = std::thread(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    for (auto& it : m_workers)
+        it->m_thread.join();
+}
+
+auto JobSystem::submit(Job job) -> void
+{
+    uint32_t index = currentWorker >= 0 ? (uint32_t)currentWorker :
+        m_nextWorker.fetch_add(1, std::memory_order_relaxed) % (uint32_t)m_workers.size();
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        ++m_queuedJobs;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_workers[index]->m_mutex);
+        m_workers[index]->m_jobs.push_back(std::move(job));
+    }
+    m_wake.notify_one();
+}
+
+auto JobSystem::parallelFor(uint32_t count, uint32_t grain,
+    const std::function<void(uint32_t begin, uint32_t end)>& function) -> void
+{
+    if (count == 0)
+        return;
+    grain = std::max(grain, 1u);
+    uint32_t chunks = (count + grain - 1) / grain;
+    if (chunks == 1)
+    {
+        function(0, count);
+        return;
+    }
+
+    // Chunks are claimed from a shared counter, the calling thread takes part instead of blocking
+    std::atomic<uint32_t> nextChunk{ 0 };
+    std::atomic<uint32_t> doneChunks{ 0 };
+    auto run = [&]()
+    {
+        for (uint32_t chunk = nextChunk++; chunk < chunks; chunk = nextChunk++)
+        {
+            uint32_t begin = chunk * grain;
+            function(begin, std::min(begin + grain, count));
+            ++doneChunks;
+        }
+    };
+
+    uint32_t helpers = std::min(chunks - 1, getWorkerCount());
+    std::atomic<uint32_t> runningHelpers{ helpers };
+    for (uint32_t i = 0; i < helpers; ++i)
+    {
+        submit([&]()
+        {
+            run();
+            --runningHelpers;
+        });
+    }
+    run();
+
+    // Helpers reference this frame, so wait for every one of them and not only for the chunks
+    Job job;
+    while (runningHelpers.load() != 0)
+    {
+        if (currentWorker >= 0 && popJob((uint32_t)currentWorker, job))
+            job();
+        else
+            std::this_thread::yield();
+    }
+}
+
+auto JobSystem::workerLoop(uint32_t index) -> void
+{
+    currentWorker = (int32_t)index;
+    Job job;
+    while (true)
+    {
+        if (popJob(index, job))
+        {
+            CPU_PROFILE_ZONE("JobSystem::job");
+            job();
+            job = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wake.wait(lock, [&]() { return m_quit || m_queuedJobs.load() != 0; });
+        // Queued jobs still run after the quit request, their futures and promises would break otherwise
+        if (m_quit && m_queuedJobs.load() == 0)
+            return;
+    }
+}
+
+auto JobSystem::popJob(uint32_t index, Job& job) -> bool
+{
+    { // Own jobs, newest first
+        auto& worker = *m_workers[index];
+        std::lock_guard<std::mutex> lock(worker.m_mutex);
+        if (!worker.m_jobs.empty())
+        {
+            job = std::move(worker.m_jobs.back());
+            worker.m_jobs.pop_back();
+            --m_queuedJobs;
+            return true;
+        }
+    }
+
+    for (uint32_t i = 1; i < m_workers.size(); ++i)
+    { // Steal the oldest job of someone else
+        auto& victim = *m_workers[(index + i) % m_workers.size()];
+        std::lock_guard<std::mutex> lock(victim.m_mutex);
+        if (!victim.m_jobs.empty())
+        {
+            job = std::move(victim.m_jobs.front());
+            victim.m_jobs.pop_front();
+            --m_queuedJobs;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <Oblivion.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <thread>
+
+
+/// <summary>
+///     Work-stealing thread pool. Every worker owns a deque: it pops its own jobs from the back and,
+///     once it runs dry, steals from the front of the others. Jobs submitted from a worker go to its
+///     own deque, the others are spread round-robin.
+/// </summary>
+class JobSystem : public ISingletone<JobSystem>
+{
+public:
+    using Job = std::function<void()>;
+
+public:
+    /// <param name = "workers">Number of worker threads, 0 uses one less than the hardware threads</param>
+    JobSystem(uint32_t workers = 0);
+    // Runs every job still queued, including the ones they submit, before joining the workers
+    ~JobSystem();
+
+public:
+    auto                                submit(Job job) -> void;
+
+    template <typename Function>
+    auto                                async(Function&& function) -> std::future<decltype(function())>
+    {
+        auto task = std::make_shared<std::packaged_task<decltype(function())()>>(std::forward<Function>(function));
+        auto future = task->get_future();
+        submit([task]() { (*task)(); });
+        return future;
+    }
+
+    /// <summary>
+    ///     Calls function(begin, end) over [0, count) in chunks of grain, on the workers and the calling thread.
+    ///     Returns once every chunk finished.
+    /// </summary>
+    auto                                parallelFor(uint32_t count, uint32_t grain,
+                                            const std::function<void(uint32_t begin, uint32_t end)>& function) -> void;
+
+    auto                                getWorkerCount() const -> uint32_t { return (uint32_t)m_workers.size(); };
+
+private:
+    struct Worker
+    {
+        std::mutex                      m_mutex;
+        std::deque<Job>                 m_jobs;
+        std::thread                     m_thread;
+    };
+
+    auto                                workerLoop(uint32_t index) -> void;
+    auto                                popJob(uint32_t index, Job& job) -> bool;
+
+private:
+    std::vector<std::unique_ptr<Worker>> m_workers;
+
+    std::mutex                          m_sleepMutex;
+    std::condition_variable             m_wake;
+    std::atomic<uint32_t>               m_queuedJobs{ 0 };
+    std::atomic<uint32_t>               m_nextWorker{ 0 };
+    std::atomic<bool>                   m_quit{ false };
+};
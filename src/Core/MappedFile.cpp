@@ -0,0 +1,73 @@
+#include "MappedFile.h"
+
+#ifdef _WINDOWS_
+#undef _WINDOWS_ // platform.h's define is also windows.h's include guard
+#include <windows.h>
+#define _WINDOWS_
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+MappedFile::MappedFile(const std::string& path)
+{
+#ifdef _WINDOWS_
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        CloseHandle(file);
+        return;
+    }
+    m_data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_data)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return;
+    }
+    m_file = file;
+    m_mapping = mapping;
+    m_size = (size_t)size.QuadPart;
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        return;
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size == 0)
+    {
+        close(file);
+        return;
+    }
+    void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file); // The mapping keeps the file referenced
+    if (data == MAP_FAILED)
+        return;
+    m_data = static_cast<const uint8_t*>(data);
+    m_size = (size_t)info.st_size;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    if (!m_data)
+        return;
+#ifdef _WINDOWS_
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mapping);
+    CloseHandle(m_file);
+#else
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+}
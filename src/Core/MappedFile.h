@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Oblivion.h>
+
+
+/// <summary>
+///     Read only memory mapping of a whole file, unmapped on destruction
+/// </summary>
+class MappedFile
+{
+public:
+    MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator = (const MappedFile&) = delete;
+
+public:
+    auto                        isOpen() const -> bool { return m_data != nullptr; };
+    auto                        getData() const -> const uint8_t* { return m_data; };
+    auto                        getSize() const -> size_t { return m_size; };
+
+private:
+    const uint8_t*              m_data = nullptr;
+    size_t                      m_size = 0;
+#ifdef _WINDOWS_
+    void*                       m_file = nullptr;
+    void*                       m_mapping = nullptr;
+#endif
+};
@@ -45,6 +45,11 @@ public:
         }
     }
 
+    void pollEvents()
+    {
+        glfwPollEvents();
+    }
+
     void toggleMouse()
     {
         if (m_mouseEnabled)
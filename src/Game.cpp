@@ -1,9 +1,12 @@
 #include "Game.h"
 #include "Core/Window.h"
+#include "Core/CpuProfiler.h"
+#include "Core/JobSystem.h"
 
 #include "Graphics/VulkanRenderer.h"
 
-Game::Game()
+Game::Game(bool headless, uint32_t headlessFrames) :
+    m_headless(headless), m_headlessFrames(headlessFrames)
 {
     InitCore();
     InitGraphics();
@@ -14,14 +17,20 @@ Game::~Game()
 {
     VulkanRenderer::Get()->wait();
     DeinitScenes();
+    JobSystem::reset();
     VulkanRenderer::Get()->reset();
-    WindowObject::Get()->reset();
+    if (!m_headless)
+        WindowObject::Get()->reset();
 }
 
 void Game::update()
 {
+    CPU_PROFILE_ZONE("Game::update");
     m_timer->update();
     m_simpleScene->update(m_timer->timeSinceLastFrame());
+    if (m_headless)
+        return;
+
     if (Input::Get()->getKeyState("ESCAPE") == Input::EKeyState::ePress)
     {
         WindowObject::Get()->toggleMouse();
@@ -33,11 +42,18 @@ void Game::update()
 
 void Game::render()
 {
+    CPU_PROFILE_ZONE("Game::render");
     VulkanRenderer::Get()->acquire();
     VulkanRenderer::Get()->render(m_simpleScene.get());
     VulkanRenderer::Get()->present();
 }
 
+void Game::step()
+{
+    update();
+    render();
+}
+
 void Game::onSize(uint32_t width, uint32_t height)
 {
     VulkanRenderer::Get()->onSize(width, height);
@@ -45,12 +61,22 @@ void Game::onSize(uint32_t width, uint32_t height)
 
 void Game::run()
 {
+    if (m_headless)
+    {
+        for (uint32_t i = 0; i < m_headlessFrames; ++i)
+            step();
+        return;
+    }
     WindowObject::Get()->run();
 }
 
 
 void Game::InitCore()
 {
+    m_timer = std::make_unique<HighResolutionTimer>();
+    if (m_headless)
+        return;
+
     WindowObject::Get(width, height);
 
 
@@ -58,8 +84,6 @@ void Game::InitCore()
     WindowObject::Get()->setRenderCallback(std::bind(&Game::render, this));
     WindowObject::Get()->setResizeCallback(std::bind(&Game::onSize, this,
         std::placeholders::_1, std::placeholders::_2));
-
-    m_timer = std::make_unique<HighResolutionTimer>();
 }
 
 void Game::InitGraphics()
@@ -83,14 +107,17 @@ void Game::InitVulkan()
     VulkanRenderer::Get()->addInstanceExtension("VK_EXT_debug_report");
 #endif
 
-    auto requiredExtensions = WindowObject::Get()->getWindowExtensions();
-
-    for (auto extension : requiredExtensions)
+    if (!m_headless)
     {
-        VulkanRenderer::Get()->addInstanceExtension(extension);
+        auto requiredExtensions = WindowObject::Get()->getWindowExtensions();
+
+        for (auto extension : requiredExtensions)
+        {
+            VulkanRenderer::Get()->addInstanceExtension(extension);
+        }
     }
 
-    VulkanRenderer::Get()->create(width, height);
+    VulkanRenderer::Get()->create(width, height, m_headless);
 
 }
 
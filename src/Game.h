@@ -10,11 +10,14 @@ class Game : public ISingletone<Game>
     static constexpr const uint32_t width = 800;
     static constexpr const uint32_t height = 600;
 public:
-    Game();
+    Game(bool headless = false, uint32_t headlessFrames = 0);
     ~Game();
 
 public:
     void run();
+    void step();
+
+    SimpleScene* getScene() { return m_simpleScene.get(); };
 
 private:
     void update();
@@ -36,4 +39,7 @@ private:
     std::unique_ptr<SimpleScene>            m_simpleScene;
     std::unique_ptr<HighResolutionTimer>    m_timer;
 
+    bool                                    m_headless;
+    uint32_t                                m_headlessFrames;
+
 };
\ No newline at end of file
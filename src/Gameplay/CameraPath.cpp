@@ -0,0 +1,52 @@
+#include "CameraPath.h"
+
+#include <glm/gtc/constants.hpp>
+
+CameraPath::CameraPath(const std::vector<Keyframe>& keyframes, uint32_t totalFrames) :
+    m_keyframes(keyframes), m_totalFrames(totalFrames)
+{
+    EVALUATE(m_keyframes.size(), 0, == , "A camera path needs at least one keyframe");
+}
+
+auto CameraPath::createOrbit(const glm::vec3& center, float radius, float height,
+    uint32_t totalFrames, uint32_t steps) -> CameraPath
+{
+    std::vector<Keyframe> keyframes;
+    keyframes.reserve(steps + 1);
+    for (uint32_t i = 0; i <= steps; ++i)
+    {
+        float angle = glm::two_pi<float>() * (float)i / (float)steps;
+        glm::vec3 offset = glm::vec3(glm::sin(angle) * radius, height, glm::cos(angle) * radius);
+        float pitch = glm::atan(height, radius);
+        keyframes.push_back({ center + offset, pitch, -angle });
+    }
+    return CameraPath(keyframes, totalFrames);
+}
+
+auto CameraPath::step(FirstPersonCamera* camera) -> void
+{
+    float progress = m_totalFrames > 1 ? (float)m_currentFrame / (float)(m_totalFrames - 1) : 0.0f;
+    auto keyframe = evaluate(glm::clamp(progress, 0.0f, 1.0f));
+    camera->setPosition(keyframe.position);
+    camera->setRotation(keyframe.pitch, keyframe.yaw);
+    m_currentFrame++;
+}
+
+auto CameraPath::evaluate(float progress) const -> Keyframe
+{
+    if (m_keyframes.size() == 1)
+        return m_keyframes[0];
+
+    float segment = progress * (float)(m_keyframes.size() - 1);
+    uint32_t first = std::min((uint32_t)segment, (uint32_t)m_keyframes.size() - 2);
+    float t = segment - (float)first;
+
+    const auto& a = m_keyframes[first];
+    const auto& b = m_keyframes[first + 1];
+    return Keyframe
+    {
+        glm::mix(a.position, b.position, t),
+        glm::mix(a.pitch, b.pitch, t),
+        glm::mix(a.yaw, b.yaw, t)
+    };
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+
+#include <Oblivion.h>
+#include <glm/glm.hpp>
+
+#include "FirstPersonCamera.h"
+
+
+class CameraPath
+{
+public:
+    struct Keyframe
+    {
+        glm::vec3   position;
+        float       pitch;
+        float       yaw;
+    };
+
+public:
+    CameraPath(const std::vector<Keyframe>& keyframes, uint32_t totalFrames);
+
+    static auto                         createOrbit(const glm::vec3& center, float radius, float height,
+                                            uint32_t totalFrames, uint32_t steps = 16) -> CameraPath;
+
+public:
+    // Places the camera at the next frame of the path, independent of the measured frame time
+    auto                                step(FirstPersonCamera* camera) -> void;
+    auto                                reset() -> void { m_currentFrame = 0; };
+    auto                                finished() const -> bool { return m_currentFrame >= m_totalFrames; };
+
+private:
+    auto                                evaluate(float progress) const -> Keyframe;
+
+private:
+    std::vector<Keyframe>               m_keyframes;
+    uint32_t                            m_totalFrames;
+    uint32_t                            m_currentFrame = 0;
+};
@@ -24,6 +24,7 @@ void FirstPersonCamera::construct()
     m_right = g_right * rotationMatrix;
     m_up = glm::cross(m_right, m_forward);
     m_view = glm::lookAt(m_position, m_position + m_forward, m_up);
+    m_frustum = Frustum(m_projection * m_view);
 }
 
 glm::mat4& FirstPersonCamera::getView()
@@ -36,6 +37,11 @@ glm::mat4& FirstPersonCamera::getProjection()
     return m_projection;
 }
 
+Frustum FirstPersonCamera::getFrustum()
+{
+    return m_frustum;
+}
+
 void FirstPersonCamera::setAspectRatio(float fov, float aspect, float near, float far)
 {
     m_projection = glm::perspective(fov, aspect, near, far);
@@ -90,3 +96,14 @@ void FirstPersonCamera::rotateDown(float frametime, float theta)
     rotateUp(frametime, -theta);
 }
 
+void FirstPersonCamera::setPosition(const glm::vec3& position)
+{
+    m_position = position;
+}
+
+void FirstPersonCamera::setRotation(float pitch, float yaw)
+{
+    m_pitch = pitch;
+    m_yaw = yaw;
+}
+
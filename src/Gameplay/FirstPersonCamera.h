@@ -15,6 +15,7 @@ public:
     virtual void construct() override;
     virtual glm::mat4& getView() override;
     virtual glm::mat4& getProjection() override;
+    virtual Frustum    getFrustum() override;
 
 
     void setAspectRatio(float fov, float aspect, float near, float far);
@@ -29,9 +30,13 @@ public:
     void rotateUp(float frametime, float theta);
     void rotateDown(float frametime, float theta);
 
+    void setPosition(const glm::vec3& position);
+    void setRotation(float pitch, float yaw);
+
 private:
     glm::mat4               m_view;
     glm::mat4               m_projection;
+    Frustum                 m_frustum;
 
     glm::vec3               m_forward;
     glm::vec3               m_right;
@@ -0,0 +1,42 @@
+#pragma once
+
+
+
+#include <glm/glm.hpp>
+
+/// <summary>
+///     Six normalized planes, pointing inwards: a point p is inside when dot(plane.xyz, p) + plane.w >= 0 for all.
+///     Extracted from a view projection matrix with 0..1 clip depth (Gribb and Hartmann)
+/// </summary>
+struct Frustum
+{
+    enum Plane
+    {
+        eLeft,
+        eRight,
+        eBottom,
+        eTop,
+        eNear,
+        eFar,
+        ePlaneCount
+    };
+
+    Frustum() = default;
+    Frustum(const glm::mat4& viewProjection)
+    {
+        glm::vec4 rows[4];
+        for (int i = 0; i < 4; ++i)
+            rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+        m_planes[eLeft] = rows[3] + rows[0];
+        m_planes[eRight] = rows[3] - rows[0];
+        m_planes[eBottom] = rows[3] + rows[1];
+        m_planes[eTop] = rows[3] - rows[1];
+        m_planes[eNear] = rows[2];
+        m_planes[eFar] = rows[3] - rows[2];
+        for (auto& plane : m_planes)
+            plane /= glm::length(glm::vec3(plane));
+    }
+
+    glm::vec4 m_planes[ePlaneCount];
+};
@@ -3,6 +3,7 @@
 
 
 #include <glm/glm.hpp>
+#include "../Frustum.h"
 
 class ICamera
 {
@@ -16,4 +17,7 @@ public:
     virtual glm::mat4& getView()         = 0;
     virtual glm::mat4& getProjection()   = 0;
 
+    // World space frustum of the last construct()
+    virtual Frustum    getFrustum()      { return Frustum(getProjection() * getView()); };
+
 };
\ No newline at end of file
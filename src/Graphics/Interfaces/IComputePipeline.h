@@ -0,0 +1,50 @@
+#pragma once
+
+
+#include "IPipelineLayout.h"
+#include "../Utils/PipelineCache.h"
+
+template <class PipelineLayoutType>
+class IComputePipeline : public IVulkanDeviceObject
+{
+#if defined SAFETY_CHECKS
+    static_assert(std::is_base_of<IPipelineLayout, PipelineLayoutType>::value,
+        "Pipeline Layout passed as an argument to Pipeline MUST be of IPipelineLayout");
+#endif
+public:
+    virtual void                updatePipeline(PipelineLayoutType* layout)
+    {
+        auto shaders = layout->getShadersCreateInfo();
+        EVALUATE(shaders.size(), 1, != , "A compute pipeline takes exactly one shader stage");
+        m_pipelineInfo.setLayout(layout->getPipelineLayout()).setStage(shaders[0]);
+
+        EVALUATE(m_pipeline = m_vulkanDevice.m_logicalDevice.createComputePipeline(PipelineCache::Get()->getPipelineCache(), m_pipelineInfo), nullptr,
+            == , "Couldn't create a compute pipeline");
+    }
+    virtual vk::Pipeline        getPipeline() const { return m_pipeline; };
+
+public:
+    IComputePipeline()
+    {
+        m_pipelineInfo.setBasePipelineHandle(nullptr).setBasePipelineIndex(0);
+    }
+
+    virtual ~IComputePipeline()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        if (m_pipeline)
+        {
+            m_vulkanDevice.m_logicalDevice.destroyPipeline(m_pipeline);
+            m_pipeline = nullptr;
+        }
+    }
+
+protected:
+    vk::Pipeline                                m_pipeline;
+    vk::ComputePipelineCreateInfo               m_pipelineInfo;
+
+};
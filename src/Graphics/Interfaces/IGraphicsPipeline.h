@@ -2,6 +2,7 @@
 
 
 #include "IPipelineLayout.h"
+#include "../Utils/PipelineRegistry.h"
 #include <HasMethod.h>
 
 #if defined SAFETY_CHECKS
@@ -27,16 +28,17 @@ class IGraphicsPipeline : public IVulkanDeviceObject
         "Vertex Type MUST have a getVertexInputStateCreateInfo static member function");
 #endif
 public:
-    virtual void                updatePipeline(PipelineLayoutType* layout, vk::RenderPass renderPass, uint32_t subpass)
+    // Pipelines with the same state share one vk::Pipeline through the PipelineRegistry. An async one is created
+    // on a JobSystem worker, getPipeline() returns null until it's ready
+    virtual void                updatePipeline(PipelineLayoutType* layout, vk::RenderPass renderPass, uint32_t subpass, bool async = false)
     {
         auto shaders = layout->getShadersCreateInfo();
         m_pipelineInfo.setLayout(layout->getPipelineLayout()).setRenderPass(renderPass).setSubpass(subpass)
             .setPStages(shaders.data()).setStageCount((uint32_t)shaders.size());
 
-        EVALUATE(m_pipeline = m_vulkanDevice.m_logicalDevice.createGraphicsPipeline(nullptr, m_pipelineInfo), nullptr,
-            == , "Couldn't create a pipeline");
+        m_pipeline = PipelineRegistry::Get()->acquire(m_pipelineInfo, async);
     }
-    virtual vk::Pipeline        getPipeline() const { return m_pipeline; };
+    virtual vk::Pipeline        getPipeline() const { return m_pipeline ? m_pipeline->get() : vk::Pipeline(); };
 
 public:
     IGraphicsPipeline()
@@ -50,8 +52,9 @@ public:
         // depth state
         m_depthState.setDepthTestEnable(VK_FALSE).setStencilTestEnable(VK_FALSE);
 
-        // dynamic state
-        m_dynamicState.setDynamicStateCount(0).setPDynamicStates(nullptr);
+        // dynamic state, viewport and scissor are set at record time so resizes don't rebuild the pipeline
+        m_dynamicStates = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
+        m_dynamicState.setDynamicStateCount((uint32_t)m_dynamicStates.size()).setPDynamicStates(m_dynamicStates.data());
 
         // IA state
         m_inputState.setTopology(vk::PrimitiveTopology::eTriangleList).setPrimitiveRestartEnable(VK_FALSE);
@@ -70,9 +73,9 @@ public:
         // Tesselation state
         m_tesselationState.setPatchControlPoints(0);
 
-        // Viewport state
-        m_viewportState.setViewportCount(1).setPViewports(&m_viewport)
-            .setScissorCount(1).setPScissors(&m_scissor);
+        // Viewport state, only the counts, the rest is dynamic
+        m_viewportState.setViewportCount(1).setPViewports(nullptr)
+            .setScissorCount(1).setPScissors(nullptr);
 
         // Pipeline Info
         m_vertexInputState = VertexType::getVertexInputStateCreateInfo();
@@ -93,29 +96,25 @@ public:
         reset();
     }
 
+    // Destroyed once no other pipeline with the same state holds it
     void reset()
     {
-        if (m_pipeline)
-        {
-            m_vulkanDevice.m_logicalDevice.destroyPipeline(m_pipeline);
-            m_pipeline = nullptr;
-        }
+        m_pipeline.reset();
     }
 
 protected:
-    vk::Pipeline                                m_pipeline;
+    std::shared_ptr<PipelineRegistry::Pipeline> m_pipeline;
     vk::GraphicsPipelineCreateInfo              m_pipelineInfo;
 
     vk::PipelineColorBlendAttachmentState       m_blendAttachment;
     vk::PipelineColorBlendStateCreateInfo       m_blendState;
     vk::PipelineDepthStencilStateCreateInfo     m_depthState;
     vk::PipelineDynamicStateCreateInfo          m_dynamicState;
+    std::array<vk::DynamicState, 2>             m_dynamicStates;
     vk::PipelineInputAssemblyStateCreateInfo    m_inputState;
     vk::PipelineMultisampleStateCreateInfo      m_msaaState;
     vk::PipelineRasterizationStateCreateInfo    m_rasterizerState;
     
-    vk::Viewport                                m_viewport;
-    vk::Rect2D                                  m_scissor;
     vk::PipelineViewportStateCreateInfo         m_viewportState;
 
     vk::PipelineTessellationStateCreateInfo     m_tesselationState;
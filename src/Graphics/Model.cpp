@@ -1,28 +1,33 @@
 #include "Model.h"
 
 #include "Utils/ObjLoader.h"
+#include "Utils/MeshCache.h"
+#include "Utils/MeshOptimizer.h"
+#include "Utils/MeshSimplifier.h"
+#include "Utils/VertexWelder.h"
 #include "Utils/VulkanAllocators.h"
+#include "../Core/JobSystem.h"
+#include "../Core/CpuProfiler.h"
 
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
+#include <limits>
 
 
-namespace std
+namespace
 {
-    template <>
-    struct hash<PositionColorVertex>
-    {
-        size_t operator()(const PositionColorVertex& t) const
-        {
-            return (hash<glm::vec4>()(t.position) << 2) ^
-                (hash<glm::vec4>()(t.color) >> 1);
-        }
-    };
+    constexpr uint32_t _minLodTriangles = 64;
+    constexpr float _maxLodError = 0.1f;    // Of the bounds diagonal, beyond that a level is not worth drawing
+}
+
+
+
+Model::Model(const char* path, VertexFormat format)
+{
+    createFromMesh(loadMesh(path), format);
 }
 
-Model::Model(const char* path)
+Model::Model(MeshData&& mesh, VertexFormat format)
 {
-    createFromPath(path);
+    createFromMesh(std::move(mesh), format);
 }
 
 Model::~Model()
@@ -46,11 +51,29 @@ auto Model::bind(vk::CommandBuffer commands) -> void
     std::array<vk::Buffer, 1> vertexBuffers = { m_vertexBuffer.m_buffer };
     std::array<vk::DeviceSize, 1> vertexBuffersOffsets = { 0 };
     commands.bindVertexBuffers(0, vertexBuffers, vertexBuffersOffsets);
-    commands.bindIndexBuffer(m_indexBuffer.m_buffer, 0, vk::IndexType::eUint32);
+    commands.bindIndexBuffer(m_indexBuffer.m_buffer, 0, m_indexType);
 }
 
-auto Model::createFromPath(const char* path) -> void
+auto Model::draw(vk::CommandBuffer commands, uint32_t lod, uint32_t instanceCount, uint32_t firstInstance) -> void
 {
+    const auto& range = m_lods[lod];
+    commands.drawIndexed(range.m_indexCount, instanceCount, range.m_indexOffset, 0, firstInstance);
+}
+
+auto Model::getVertexTransform() const -> glm::mat4
+{
+    if (m_vertexFormat == VertexFormat::ePackedPositionUV)
+        return PackedPositionUVVertex::getDequantizeTransform(m_boundsMin, m_boundsMax);
+    return glm::mat4(1.0f);
+}
+
+auto Model::loadMesh(const char* path) -> MeshData
+{
+    MeshData mesh;
+    std::string cachePath = MeshCache::getCachePath(path);
+    if (MeshCache::read(path, cachePath, mesh))
+        return mesh;
+
     tinyobj::attrib_t attrib;
     std::vector<tinyobj::material_t> materials;
     std::vector<tinyobj::shape_t> shapes;
@@ -58,66 +81,178 @@ auto Model::createFromPath(const char* path) -> void
     EVALUATE(tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path), false,
         == , "Couldn't load model from path %s", path);
 
-    std::unordered_map<PositionColorVertex, uint32_t> uniqueVertices = {};
+    // Expand every shape into one vertex per corner, then weld bitwise identical corners
+    std::vector<PositionColorVertex> corners;
+    size_t cornerCount = 0;
+    for (const auto& shape : shapes)
+        cornerCount += shape.mesh.indices.size();
+    corners.resize(cornerCount);
+
+    size_t shapeOffset = 0;
     for (const auto& shape : shapes)
     {
-        for (const auto& index : shape.mesh.indices)
+        JobSystem::Get()->parallelFor((uint32_t)shape.mesh.indices.size(), 1u << 16, [&](uint32_t begin, uint32_t end)
         {
-            PositionColorVertex vertex;
-            vertex.position =
-            {
-                attrib.vertices[3 * index.vertex_index + 0],
-                attrib.vertices[3 * index.vertex_index + 1],
-                attrib.vertices[3 * index.vertex_index + 2],
-                1.0f
-            };
-
-            if (index.texcoord_index >= 0)
+            for (uint32_t i = begin; i < end; ++i)
             {
-                vertex.color =
+                const auto& index = shape.mesh.indices[i];
+                PositionColorVertex& vertex = corners[shapeOffset + i];
+                vertex.position =
                 {
-                    attrib.texcoords[2 * index.texcoord_index + 0],
-                    1.f - attrib.texcoords[2 * index.texcoord_index + 1],
-                    0.0f,
+                    attrib.vertices[3 * index.vertex_index + 0],
+                    attrib.vertices[3 * index.vertex_index + 1],
+                    attrib.vertices[3 * index.vertex_index + 2],
                     1.0f
                 };
-            }
-            else
-            {
-                vertex.color =
+
+                if (index.texcoord_index >= 0)
                 {
-                    attrib.colors[2 * index.vertex_index + 0],
-                    attrib.colors[2 * index.vertex_index + 1],
-                    attrib.colors[2 * index.vertex_index + 2],
-                    1.0f
-                };
+                    vertex.color =
+                    {
+                        attrib.texcoords[2 * index.texcoord_index + 0],
+                        1.f - attrib.texcoords[2 * index.texcoord_index + 1],
+                        0.0f,
+                        1.0f
+                    };
+                }
+                else
+                {
+                    vertex.color =
+                    {
+                        attrib.colors[3 * index.vertex_index + 0],
+                        attrib.colors[3 * index.vertex_index + 1],
+                        attrib.colors[3 * index.vertex_index + 2],
+                        1.0f
+                    };
+                }
             }
+        });
+        shapeOffset += shape.mesh.indices.size();
+    }
 
-            if (uniqueVertices.count(vertex) == 0)
-            {
-                uniqueVertices[vertex] = (uint32_t)m_vertices.size();
-                m_vertices.push_back(vertex);
-            }
+    auto stats = VertexWelder::weld(corners, mesh.m_vertices, mesh.m_indices);
+    NOTE(appendToString("Welded ", path, ": ", stats.m_corners, " corners into ", stats.m_uniqueVertices,
+        " vertices in ", stats.m_milliseconds, " ms (", stats.getCornersPerSecond() / 1.0e6, " M corners/s)"));
+
+    auto optimizeStats = MeshOptimizer::optimize(mesh.m_vertices, mesh.m_indices);
+    NOTE(appendToString("Optimized ", path, ": ACMR ", optimizeStats.m_acmrBefore, " -> ", optimizeStats.m_acmrAfter,
+        ", ", optimizeStats.m_clusters, " overdraw clusters"));
 
-            m_indices.push_back(uniqueVertices[vertex]);
+    if (!mesh.m_vertices.empty())
+    {
+        mesh.m_boundsMin = mesh.m_boundsMax = glm::vec3(mesh.m_vertices[0].position);
+        for (const auto& it : mesh.m_vertices)
+        {
+            mesh.m_boundsMin = glm::min(mesh.m_boundsMin, glm::vec3(it.position));
+            mesh.m_boundsMax = glm::max(mesh.m_boundsMax, glm::vec3(it.position));
         }
     }
 
-    uint32_t numVertices = (uint32_t)m_vertices.size();
-
-    m_vertexBuffer = BufferUtils::createBuffer(vk::BufferUsageFlagBits::eVertexBuffer,
-        vk::MemoryPropertyFlagBits::eDeviceLocal, {},
-        &m_vulkanDevice.m_families.graphicsIndex, 1,
-        numVertices * PositionColorVertex::getVertexSize(),
-        m_vulkanDevice.m_logicalDevice, m_vulkanDevice.m_queues.graphicsQueue,
-        m_vulkanDevice.m_families.graphicsIndex,
-        (void*)m_vertices.data());
-
-    uint32_t numIndices = (uint32_t)m_indices.size();
-    m_indexBuffer = BufferUtils::createBuffer(vk::BufferUsageFlagBits::eIndexBuffer,
-        vk::MemoryPropertyFlagBits::eDeviceLocal, {},
-        &m_vulkanDevice.m_families.graphicsIndex, 1,
-        numIndices * sizeof(m_indices[0]),
-        m_vulkanDevice.m_logicalDevice, m_vulkanDevice.m_queues.graphicsQueue,
-        m_vulkanDevice.m_families.graphicsIndex, (void*)m_indices.data());
+    // Each level halves the previous one, until the simplifier gets stuck or the error grows too large.
+    // Errors add up, as each level only measures its deviation from the one before it
+    mesh.m_lods.push_back({ 0, (uint32_t)mesh.m_indices.size(), 0.0f });
+    std::vector<uint32_t> lodIndices = mesh.m_indices;
+    float maxError = glm::length(mesh.m_boundsMax - mesh.m_boundsMin) * _maxLodError;
+    while (mesh.m_lods.size() < _maxLods && lodIndices.size() / 3 > _minLodTriangles * 2)
+    {
+        float error;
+        float remainingError = maxError - mesh.m_lods.back().m_error;
+        if (remainingError <= 0.0f)
+            break;
+        auto simplified = MeshSimplifier::simplify(lodIndices, mesh.m_vertices.data(), (uint32_t)mesh.m_vertices.size(),
+            (uint32_t)lodIndices.size() / 6 * 3, remainingError, &error);
+        if (simplified.size() > lodIndices.size() * 9 / 10)
+            break;
+
+        MeshOptimizer::optimizeVertexCache(simplified, (uint32_t)mesh.m_vertices.size());
+        mesh.m_lods.push_back({ (uint32_t)mesh.m_indices.size(), (uint32_t)simplified.size(), mesh.m_lods.back().m_error + error });
+        mesh.m_indices.insert(mesh.m_indices.end(), simplified.begin(), simplified.end());
+        lodIndices = std::move(simplified);
+    }
+    NOTE(appendToString("Simplified ", path, ": ", mesh.m_lods.size(), " levels, coarsest ",
+        mesh.m_lods.back().m_indexCount / 3, " triangles"));
+
+    if (!MeshCache::write(path, cachePath, mesh))
+        WARNING(appendToString("Couldn't write the mesh cache ", cachePath));
+
+    return mesh;
+}
+
+auto Model::packMesh(MeshData& mesh, VertexFormat format) -> void
+{
+    CPU_PROFILE_ZONE("Model::packMesh");
+    uint32_t vertexCount = mesh.getVertexCount();
+    uint32_t indexCount = mesh.getIndexCount();
+
+    mesh.m_packedVertices.clear();
+    if (format == VertexFormat::ePackedPositionUV)
+    {
+        const PositionColorVertex* vertices = mesh.getVertexData();
+        mesh.m_packedVertices.resize(vertexCount);
+        for (uint32_t i = 0; i < vertexCount; ++i)
+            mesh.m_packedVertices[i] = PackedPositionUVVertex(vertices[i], mesh.m_boundsMin, mesh.m_boundsMax);
+    }
+
+    mesh.m_shortIndices.clear();
+    if (vertexCount <= std::numeric_limits<uint16_t>::max() + 1u)
+    {
+        const uint32_t* indices = mesh.getIndexData();
+        mesh.m_shortIndices.resize(indexCount);
+        for (uint32_t i = 0; i < indexCount; ++i)
+            mesh.m_shortIndices[i] = (uint16_t)indices[i];
+    }
+
+    mesh.m_packed = true;
+    mesh.m_packedFormat = format;
+}
+
+auto Model::createFromMesh(MeshData&& mesh, VertexFormat format) -> void
+{
+    // The data is staged right away, so neither the vectors nor the mapping have to outlive this call
+    m_vertexFormat = format;
+    m_vertexCount = mesh.getVertexCount();
+    m_indexCount = mesh.getIndexCount();
+    m_boundsMin = mesh.m_boundsMin;
+    m_boundsMax = mesh.m_boundsMax;
+    m_lods = mesh.m_lods;
+    if (m_lods.empty())
+        m_lods.push_back({ 0, m_indexCount, 0.0f });
+
+    // AssetLoader packs on a worker, only meshes handed straight to the constructor are packed here
+    if (!mesh.m_packed || mesh.m_packedFormat != format)
+        packMesh(mesh, format);
+
+    if (format == VertexFormat::ePackedPositionUV)
+    {
+        m_vertexBuffer = BufferUtils::createBuffer(vk::BufferUsageFlagBits::eVertexBuffer,
+            vk::MemoryPropertyFlagBits::eDeviceLocal, {},
+            &m_vulkanDevice.m_families.graphicsIndex, 1,
+            m_vertexCount * PackedPositionUVVertex::getVertexSize(),
+            (void*)mesh.m_packedVertices.data());
+    }
+    else
+    {
+        m_vertexBuffer = BufferUtils::createBuffer(vk::BufferUsageFlagBits::eVertexBuffer,
+            vk::MemoryPropertyFlagBits::eDeviceLocal, {},
+            &m_vulkanDevice.m_families.graphicsIndex, 1,
+            m_vertexCount * PositionColorVertex::getVertexSize(),
+            (void*)mesh.getVertexData());
+    }
+
+    if (m_vertexCount <= std::numeric_limits<uint16_t>::max() + 1u)
+    {
+        m_indexType = vk::IndexType::eUint16;
+        m_indexBuffer = BufferUtils::createBuffer(vk::BufferUsageFlagBits::eIndexBuffer,
+            vk::MemoryPropertyFlagBits::eDeviceLocal, {},
+            &m_vulkanDevice.m_families.graphicsIndex, 1,
+            m_indexCount * sizeof(uint16_t), (void*)mesh.m_shortIndices.data());
+    }
+    else
+    {
+        m_indexType = vk::IndexType::eUint32;
+        m_indexBuffer = BufferUtils::createBuffer(vk::BufferUsageFlagBits::eIndexBuffer,
+            vk::MemoryPropertyFlagBits::eDeviceLocal, {},
+            &m_vulkanDevice.m_families.graphicsIndex, 1,
+            m_indexCount * sizeof(uint32_t), (void*)mesh.getIndexData());
+    }
 }
@@ -5,27 +5,105 @@
 #include "Utils/BufferUtils.h"
 
 #include "Vertex/PositionColorVertex.h"
+#include "Vertex/PackedPositionUVVertex.h"
+#include "../Core/MappedFile.h"
 
 
 class Model : public IVulkanDeviceObject
 {
 public:
-    Model(const char* path);
+    static constexpr const uint32_t     _maxLods = 6;       // Including the full mesh, culling.comp relies on it
+
+    // Layout of the vertex buffer, the pipeline drawing the model must use the matching vertex type
+    enum class VertexFormat
+    {
+        ePositionColor,     // PositionColorVertex, 32 bytes
+        ePackedPositionUV   // PackedPositionUVVertex, 12 bytes
+    };
+
+    // Range of the index buffer drawing one level of detail. Every level indexes the same vertices
+    struct Lod
+    {
+        uint32_t                        m_indexOffset = 0;
+        uint32_t                        m_indexCount = 0;
+        float                           m_error = 0.0f;     // Object space deviation from the full mesh, see selectLod in culling.comp
+    };
+
+    struct MeshData
+    {
+        std::vector<PositionColorVertex> m_vertices;
+        std::vector<uint32_t>           m_indices;
+        glm::vec3                       m_boundsMin = glm::vec3(0.0f);
+        glm::vec3                       m_boundsMax = glm::vec3(0.0f);
+        std::vector<Lod>                m_lods;             // Finest first, m_indices holds all of them back to back
+
+        // Set when the streams are read straight from a mapped mesh cache instead of the vectors
+        std::unique_ptr<MappedFile>     m_mappedFile;
+        const PositionColorVertex*      m_mappedVertices = nullptr;
+        const uint32_t*                 m_mappedIndices = nullptr;
+        uint32_t                        m_mappedVertexCount = 0;
+        uint32_t                        m_mappedIndexCount = 0;
+
+        // Filled by packMesh in the layout of the GPU buffers, the streams above are staged as is when these are empty
+        bool                            m_packed = false;
+        VertexFormat                    m_packedFormat = VertexFormat::ePositionColor;
+        std::vector<PackedPositionUVVertex> m_packedVertices;   // Only for ePackedPositionUV
+        std::vector<uint16_t>           m_shortIndices;         // Only when every vertex fits a 16-bit index
+
+        auto getVertexData() const -> const PositionColorVertex* { return m_mappedFile ? m_mappedVertices : m_vertices.data(); };
+        auto getIndexData() const -> const uint32_t* { return m_mappedFile ? m_mappedIndices : m_indices.data(); };
+        auto getVertexCount() const -> uint32_t { return m_mappedFile ? m_mappedVertexCount : (uint32_t)m_vertices.size(); };
+        auto getIndexCount() const -> uint32_t { return m_mappedFile ? m_mappedIndexCount : (uint32_t)m_indices.size(); };
+    };
+
+public:
+    Model(const char* path, VertexFormat format = VertexFormat::ePositionColor);
+    Model(MeshData&& mesh, VertexFormat format = VertexFormat::ePositionColor);
     ~Model();
 
+    /// <summary>
+    ///     Maps the mesh cache of path, or parses, welds and simplifies the mesh at path and writes its cache.
+    ///     Touches no Vulkan object, so it can run on any thread
+    /// </summary>
+    static auto                         loadMesh(const char* path) -> MeshData;
+    /// <summary>
+    ///     Quantizes the vertices to format and narrows the indices when they fit 16 bits, ahead of the constructor.
+    ///     Touches no Vulkan object, so it can run on any thread
+    /// </summary>
+    static auto                         packMesh(MeshData& mesh, VertexFormat format) -> void;
+
 public:
     auto                                bind(vk::CommandBuffer) -> void;
-    auto                                getVertexCount() -> uint32_t { return (uint32_t)m_vertices.size(); };
-    auto                                getIndexCount() -> uint32_t { return (uint32_t)m_indices.size(); };
+    /// <summary>
+    ///     Draws one level of detail. Instances are read from whatever the pipeline's instance binding holds
+    /// </summary>
+    auto                                draw(vk::CommandBuffer, uint32_t lod, uint32_t instanceCount = 1, uint32_t firstInstance = 0) -> void;
+    auto                                getVertexCount() -> uint32_t { return m_vertexCount; };
+    auto                                getIndexCount() -> uint32_t { return m_indexCount; };     // In indices of getIndexType()
+    auto                                getBoundsMin() const -> const glm::vec3& { return m_boundsMin; };
+    auto                                getBoundsMax() const -> const glm::vec3& { return m_boundsMax; };
+    auto                                getVertexFormat() const -> VertexFormat { return m_vertexFormat; };
+    auto                                getIndexType() const -> vk::IndexType { return m_indexType; };
+    auto                                getLodCount() const -> uint32_t { return (uint32_t)m_lods.size(); };
+    auto                                getLod(uint32_t lod) const -> const Lod& { return m_lods[lod]; };
+    /// <summary>
+    ///     Object space transform of the vertex buffer positions, to prepend to the world matrix
+    /// </summary>
+    auto                                getVertexTransform() const -> glm::mat4;
 
 private:
-    auto                                createFromPath(const char* path) -> void;
+    auto                                createFromMesh(MeshData&& mesh, VertexFormat format) -> void;
 
 
 private:
     BufferUtils::Buffer                 m_vertexBuffer;
     BufferUtils::Buffer                 m_indexBuffer;
 
-    std::vector<PositionColorVertex>    m_vertices;
-    std::vector<uint32_t>               m_indices;
+    VertexFormat                        m_vertexFormat = VertexFormat::ePositionColor;
+    std::vector<Lod>                    m_lods;
+    uint32_t                            m_vertexCount = 0;
+    uint32_t                            m_indexCount = 0;
+    vk::IndexType                       m_indexType = vk::IndexType::eUint32;   // eUint16 whenever the vertices fit
+    glm::vec3                           m_boundsMin;
+    glm::vec3                           m_boundsMax;
 };
\ No newline at end of file
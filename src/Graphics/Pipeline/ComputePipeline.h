@@ -0,0 +1,21 @@
+#pragma once
+
+
+
+#include "../Interfaces/IComputePipeline.h"
+
+/// <summary>
+///     Compute pipelines don't depend on the swapchain, so unlike the graphics ones they're built once, on creation
+/// </summary>
+template <class PipelineLayoutType>
+class ComputePipeline :
+    public IComputePipeline<PipelineLayoutType>
+{
+public:
+    ComputePipeline(PipelineLayoutType* pipelineLayout)
+    {
+        this->updatePipeline(pipelineLayout);
+    };
+    ~ComputePipeline() {};
+
+};
@@ -0,0 +1,145 @@
+#include "CullingLayout.h"
+
+#include "../../VulkanRenderer.h"
+#include "../../Utils/Samplers.h"
+
+CullingLayout::CullingLayout() :
+    m_computeShader("Shaders/culling.comp.spv")
+{
+    std::array<vk::DescriptorSetLayoutBinding, eBindingCount> bindings;
+    for (uint32_t i = 0; i < eBindingCount; ++i)
+    {
+        bindings[i].setBinding(i).setDescriptorCount(1)
+            .setDescriptorType(getDescriptorType(i))
+            .setStageFlags(vk::ShaderStageFlagBits::eCompute);
+    }
+
+    vk::DescriptorSetLayoutCreateInfo computeShaderLayout;
+    computeShaderLayout.setBindingCount((uint32_t)bindings.size())
+        .setPBindings(bindings.data());
+    m_descriptorLayout = m_vulkanDevice.m_logicalDevice.createDescriptorSetLayout(computeShaderLayout);
+    EVALUATE(m_descriptorLayout, nullptr, == , "Couldn't create descriptor layout for CullingLayout");
+
+    vk::PushConstantRange range;
+    range.setStageFlags(vk::ShaderStageFlagBits::eCompute)
+        .setSize(sizeof(uint32_t)).setOffset(0);
+
+    vk::PipelineLayoutCreateInfo pipelineLayoutInfo;
+    pipelineLayoutInfo.setSetLayoutCount(1).setPSetLayouts(&m_descriptorLayout)
+        .setPushConstantRangeCount(1).setPPushConstantRanges(&range);
+    m_layout = m_vulkanDevice.m_logicalDevice.createPipelineLayout(pipelineLayoutInfo);
+    EVALUATE(m_layout, nullptr, == , "Couldn't create layout for CullingLayout");
+
+    createDescriptorPools();
+    allocateDescriptorSets();
+}
+
+CullingLayout::~CullingLayout()
+{
+    if (m_descriptorPool)
+    {
+        m_vulkanDevice.m_logicalDevice.destroyDescriptorPool(m_descriptorPool);
+        m_descriptorPool = nullptr;
+    }
+    if (m_descriptorLayout)
+    {
+        m_vulkanDevice.m_logicalDevice.destroyDescriptorSetLayout(m_descriptorLayout);
+        m_descriptorLayout = nullptr;
+    }
+    if (m_layout)
+    {
+        m_vulkanDevice.m_logicalDevice.destroyPipelineLayout(m_layout);
+        m_layout = nullptr;
+    }
+}
+
+auto CullingLayout::setBuffers(uint32_t inFlightFrame, const BufferUtils::Buffer (&buffers)[_bufferCount]) -> void
+{
+    std::array<vk::DescriptorBufferInfo, _bufferCount> bufferInfos;
+    std::array<vk::WriteDescriptorSet, _bufferCount> writeSets;
+    for (uint32_t i = 0; i < _bufferCount; ++i)
+    {
+        bufferInfos[i].setBuffer(buffers[i].m_buffer)
+            .setOffset(0).setRange(buffers[i].m_size);
+        writeSets[i].setDescriptorCount(1)
+            .setDescriptorType(getDescriptorType(i))
+            .setDstArrayElement(0).setDstBinding(i).setDstSet(m_descriptorSets[inFlightFrame]).setPBufferInfo(&bufferInfos[i]);
+    }
+    m_vulkanDevice.m_logicalDevice.updateDescriptorSets((uint32_t)writeSets.size(), writeSets.data(), 0, nullptr);
+}
+
+auto CullingLayout::setDepthPyramid(vk::ImageView pyramid) -> void
+{
+    vk::DescriptorImageInfo imageInfo;
+    imageInfo.setImageLayout(vk::ImageLayout::eGeneral)
+        .setImageView(pyramid).setSampler(Samplers::Get()->getNearestClampSampler());
+    for (const auto descriptorSet : m_descriptorSets)
+    {
+        vk::WriteDescriptorSet writeSet;
+        writeSet.setDescriptorCount(1).setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+            .setDstArrayElement(0).setDstBinding(eDepthPyramid).setDstSet(descriptorSet).setPImageInfo(&imageInfo);
+        m_vulkanDevice.m_logicalDevice.updateDescriptorSets(1, &writeSet, 0, nullptr);
+    }
+}
+
+auto CullingLayout::setPhase(vk::CommandBuffer& commandBuffer, uint32_t phase) const -> void
+{
+    commandBuffer.pushConstants(m_layout, vk::ShaderStageFlagBits::eCompute,
+        0, sizeof(uint32_t), &phase);
+}
+
+auto CullingLayout::createDescriptorPools() -> void
+{
+    uint32_t frames = VulkanRenderer::getMaxInFlightFrames();
+    std::array<vk::DescriptorPoolSize, 3> descriptorPoolSizes;
+    descriptorPoolSizes[0].setDescriptorCount(frames);
+    descriptorPoolSizes[0].setType(vk::DescriptorType::eUniformBuffer);
+    descriptorPoolSizes[1].setDescriptorCount(frames * (_bufferCount - 1));
+    descriptorPoolSizes[1].setType(vk::DescriptorType::eStorageBuffer);
+    descriptorPoolSizes[2].setDescriptorCount(frames);
+    descriptorPoolSizes[2].setType(vk::DescriptorType::eCombinedImageSampler);
+
+    vk::DescriptorPoolCreateInfo descriptorPoolInfo = {};
+    descriptorPoolInfo.setMaxSets(frames)
+        .setPoolSizeCount((uint32_t)descriptorPoolSizes.size()).setPPoolSizes(descriptorPoolSizes.data());
+
+    m_descriptorPool = m_vulkanDevice.m_logicalDevice.createDescriptorPool(descriptorPoolInfo);
+    EVALUATE(m_descriptorPool, nullptr, == , "Couldn't create a valid descriptor pool");
+}
+
+auto CullingLayout::allocateDescriptorSets() -> void
+{
+    std::vector<vk::DescriptorSetLayout> layouts(VulkanRenderer::getMaxInFlightFrames(), m_descriptorLayout);
+    vk::DescriptorSetAllocateInfo allocationInfo;
+    allocationInfo.setDescriptorPool(m_descriptorPool);
+    allocationInfo.setDescriptorSetCount((uint32_t)layouts.size());
+    allocationInfo.setPSetLayouts(layouts.data());
+
+    m_descriptorSets = m_vulkanDevice.m_logicalDevice.allocateDescriptorSets(allocationInfo);
+    EVALUATE(m_descriptorSets.size(), 0, == , "Couldn't allocate descriptor sets");
+}
+
+auto CullingLayout::getDescriptorType(uint32_t binding) const -> vk::DescriptorType
+{
+    switch (binding)
+    {
+    case eParameters: return vk::DescriptorType::eUniformBuffer;
+    case eDepthPyramid: return vk::DescriptorType::eCombinedImageSampler;
+    default: return vk::DescriptorType::eStorageBuffer;
+    }
+}
+
+
+std::vector<vk::PipelineShaderStageCreateInfo> CullingLayout::getShadersCreateInfo() const
+{
+    return std::vector<vk::PipelineShaderStageCreateInfo>
+    {
+        m_computeShader.getShaderStageCreateInfo()
+    };
+}
+
+void CullingLayout::bindDescriptorSets(vk::CommandBuffer& commandBuffer) const
+{
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_layout,
+        0, 1, &m_descriptorSets[VulkanRenderer::Get()->getInFlightFrame()], 0, nullptr);
+}
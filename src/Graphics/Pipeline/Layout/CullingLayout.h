@@ -0,0 +1,67 @@
+#pragma once
+
+
+#include <Oblivion.h>
+
+#include "../../Interfaces/IPipelineLayout.h"
+
+#include "../../Utils/BufferUtils.h"
+#include "../../Utils/Shader.h"
+
+/// <summary>
+///     Layout of the culling compute shader: the culling parameters, the instances to test, the visible instances
+///     grouped by level of detail, the indirect draw commands counting them, the instances left for the late phase
+///     and the depth pyramid they're tested against. The phase is a push constant
+/// </summary>
+class CullingLayout :
+    public IPipelineLayout
+{
+public:
+    enum Binding
+    {
+        eParameters,
+        eInstances,
+        eVisibleInstances,
+        eDrawCommands,
+        eOccludedInstances,
+        eDepthPyramid,
+        eBindingCount
+    };
+    static constexpr const uint32_t _bufferCount = eDepthPyramid;     // Every binding before the pyramid is a buffer
+
+public:
+    CullingLayout();
+    ~CullingLayout();
+
+
+    virtual     void                        bindDescriptorSets(vk::CommandBuffer& commandBuffer) const;
+
+    virtual     std::vector<vk::PipelineShaderStageCreateInfo>
+                                            getShadersCreateInfo() const override;
+
+    virtual     vk::PipelineLayout          getPipelineLayout() const { return m_layout; };
+
+public:
+                // Points the set of the in-flight frame at its buffers, the GPU MUST be done with that frame
+                auto                        setBuffers(uint32_t inFlightFrame, const BufferUtils::Buffer (&buffers)[_bufferCount]) -> void;
+                // Sampled in eGeneral by every in-flight frame's set, so only while the device is idle
+                auto                        setDepthPyramid(vk::ImageView pyramid) -> void;
+                auto                        setPhase(vk::CommandBuffer& commandBuffer, uint32_t phase) const -> void;
+
+private:
+                auto                        createDescriptorPools() -> void;
+                auto                        allocateDescriptorSets() -> void;
+                auto                        getDescriptorType(uint32_t binding) const -> vk::DescriptorType;
+
+
+private:
+    vk::PipelineLayout                      m_layout;
+    vk::DescriptorSetLayout                 m_descriptorLayout;
+    vk::DescriptorPool                      m_descriptorPool;
+
+    // One set per in-flight frame, their buffers grow independently
+    std::vector<vk::DescriptorSet>          m_descriptorSets;
+
+    Shader                                  m_computeShader;
+
+};
@@ -0,0 +1,26 @@
+#include "DepthOnlyLayout.h"
+
+
+DepthOnlyLayout::DepthOnlyLayout(const TextureLayout* textureLayout, const char* vertexShader) :
+    m_textureLayout(textureLayout),
+    m_vertexShader(vertexShader)
+{
+}
+
+DepthOnlyLayout::~DepthOnlyLayout()
+{
+}
+
+void DepthOnlyLayout::bindDescriptorSets(vk::CommandBuffer& commandBuffer) const
+{
+    m_textureLayout->bindDescriptorSets(commandBuffer);
+}
+
+std::vector<vk::PipelineShaderStageCreateInfo> DepthOnlyLayout::getShadersCreateInfo() const
+{
+    // No fragment stage, the rasterizer only writes depth
+    return std::vector<vk::PipelineShaderStageCreateInfo>
+    {
+        m_vertexShader.getShaderStageCreateInfo()
+    };
+}
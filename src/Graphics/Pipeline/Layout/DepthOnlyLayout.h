@@ -0,0 +1,33 @@
+#pragma once
+
+
+#include <Oblivion.h>
+
+#include "../../Interfaces/IPipelineLayout.h"
+#include "../../Utils/Shader.h"
+#include "TextureLayout.h"
+
+/// <summary>
+///     Vertex only stages over a TextureLayout's pipeline layout and descriptor sets, for depth only pipelines.
+///     The TextureLayout keeps owning and updating them, it must outlive this one.
+/// </summary>
+class DepthOnlyLayout :
+    public IPipelineLayout
+{
+public:
+    DepthOnlyLayout(const TextureLayout* textureLayout, const char* vertexShader = "Shaders/depthonly.vert.spv");
+    ~DepthOnlyLayout();
+
+
+    virtual     void                        bindDescriptorSets(vk::CommandBuffer& commandBuffer) const override;
+
+    virtual     std::vector<vk::PipelineShaderStageCreateInfo>
+                                            getShadersCreateInfo() const override;
+
+    virtual     vk::PipelineLayout          getPipelineLayout() const override { return m_textureLayout->getPipelineLayout(); };
+
+private:
+    const TextureLayout*                    m_textureLayout;
+    Shader                                  m_vertexShader;
+
+};
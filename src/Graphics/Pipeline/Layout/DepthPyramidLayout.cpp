@@ -0,0 +1,115 @@
+#include "DepthPyramidLayout.h"
+
+#include "../../Utils/Samplers.h"
+
+DepthPyramidLayout::DepthPyramidLayout(const char* computeShader) :
+    m_computeShader(computeShader)
+{
+    // Descriptor pool
+    {
+        std::array<vk::DescriptorPoolSize, 2> poolSizes;
+        poolSizes[0].setDescriptorCount(_maxLevels).setType(vk::DescriptorType::eCombinedImageSampler);
+        poolSizes[1].setDescriptorCount(_maxLevels).setType(vk::DescriptorType::eStorageImage);
+        vk::DescriptorPoolCreateInfo poolInfo;
+        poolInfo.setMaxSets(_maxLevels).setPoolSizeCount((uint32_t)poolSizes.size()).setPPoolSizes(poolSizes.data());
+        EVALUATE(m_descriptorPool = m_vulkanDevice.m_logicalDevice.createDescriptorPool(poolInfo),
+            nullptr, == , "Unable to create a descriptor pool for DepthPyramidLayout");
+    }
+    // Descriptor layout
+    {
+        std::array<vk::DescriptorSetLayoutBinding, 2> bindings;
+        bindings[0].setBinding(0).setDescriptorCount(1)
+            .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+            .setStageFlags(vk::ShaderStageFlagBits::eCompute);
+        bindings[1].setBinding(1).setDescriptorCount(1)
+            .setDescriptorType(vk::DescriptorType::eStorageImage)
+            .setStageFlags(vk::ShaderStageFlagBits::eCompute);
+        vk::DescriptorSetLayoutCreateInfo layoutInfo;
+        layoutInfo.setBindingCount((uint32_t)bindings.size()).setPBindings(bindings.data());
+        EVALUATE(m_descriptorLayout = m_vulkanDevice.m_logicalDevice.createDescriptorSetLayout(layoutInfo),
+            nullptr, == , "Unable to create Descriptor Layout for DepthPyramidLayout");
+    }
+    // Pipeline layout
+    {
+        vk::PushConstantRange pushConstant;
+        pushConstant.setOffset(0).setSize(sizeof(PushConstants)).setStageFlags(vk::ShaderStageFlagBits::eCompute);
+        vk::PipelineLayoutCreateInfo layoutInfo;
+        layoutInfo.setPPushConstantRanges(&pushConstant).setPushConstantRangeCount(1)
+            .setSetLayoutCount(1).setPSetLayouts(&m_descriptorLayout);
+        EVALUATE(m_pipelineLayout = m_vulkanDevice.m_logicalDevice.createPipelineLayout(layoutInfo),
+            nullptr, == , "Unable to create Pipeline Layout for DepthPyramidLayout");
+    }
+    // Descriptor sets, written again whenever the pyramid is recreated
+    {
+        std::vector<vk::DescriptorSetLayout> layouts(_maxLevels, m_descriptorLayout);
+        vk::DescriptorSetAllocateInfo allocateInfo;
+        allocateInfo.setDescriptorPool(m_descriptorPool)
+            .setDescriptorSetCount((uint32_t)layouts.size()).setPSetLayouts(layouts.data());
+        m_descriptorSets = m_vulkanDevice.m_logicalDevice.allocateDescriptorSets(allocateInfo);
+        EVALUATE(m_descriptorSets.size(), 0, == , "Unable to allocate descriptor sets for DepthPyramidLayout");
+    }
+}
+
+DepthPyramidLayout::~DepthPyramidLayout()
+{
+    if (m_descriptorPool)
+    {
+        m_vulkanDevice.m_logicalDevice.destroyDescriptorPool(m_descriptorPool);
+        m_descriptorPool = nullptr;
+    }
+    if (m_descriptorLayout)
+    {
+        m_vulkanDevice.m_logicalDevice.destroyDescriptorSetLayout(m_descriptorLayout);
+        m_descriptorLayout = nullptr;
+    }
+    if (m_pipelineLayout)
+    {
+        m_vulkanDevice.m_logicalDevice.destroyPipelineLayout(m_pipelineLayout);
+        m_pipelineLayout = nullptr;
+    }
+}
+
+auto DepthPyramidLayout::setImages(uint32_t level, vk::ImageView source, vk::ImageLayout sourceLayout, vk::ImageView destination) -> void
+{
+    vk::DescriptorImageInfo sourceInfo;
+    sourceInfo.setImageLayout(sourceLayout)
+        .setImageView(source).setSampler(Samplers::Get()->getNearestClampSampler());
+    vk::DescriptorImageInfo destinationInfo;
+    destinationInfo.setImageLayout(vk::ImageLayout::eGeneral)
+        .setImageView(destination);
+
+    std::array<vk::WriteDescriptorSet, 2> writeSets;
+    writeSets[0].setDescriptorCount(1).setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+        .setDstArrayElement(0).setDstBinding(0).setDstSet(m_descriptorSets[level]).setPImageInfo(&sourceInfo);
+    writeSets[1].setDescriptorCount(1).setDescriptorType(vk::DescriptorType::eStorageImage)
+        .setDstArrayElement(0).setDstBinding(1).setDstSet(m_descriptorSets[level]).setPImageInfo(&destinationInfo);
+    m_vulkanDevice.m_logicalDevice.updateDescriptorSets((uint32_t)writeSets.size(), writeSets.data(), 0, nullptr);
+}
+
+auto DepthPyramidLayout::bindDescriptorSet(vk::CommandBuffer& commandBuffer, uint32_t level) const -> void
+{
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, 0, 1, &m_descriptorSets[level], 0, nullptr);
+}
+
+auto DepthPyramidLayout::setPushConstants(vk::CommandBuffer& commandBuffer, const PushConstants& constants) const -> void
+{
+    commandBuffer.pushConstants(m_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(PushConstants), &constants);
+}
+
+void DepthPyramidLayout::bindDescriptorSets(vk::CommandBuffer& commandBuffer) const
+{
+    bindDescriptorSet(commandBuffer, 0);
+}
+
+vk::PipelineLayout DepthPyramidLayout::getPipelineLayout() const
+{
+    return m_pipelineLayout;
+}
+
+std::vector<vk::PipelineShaderStageCreateInfo> DepthPyramidLayout::getShadersCreateInfo() const
+{
+    return std::vector<vk::PipelineShaderStageCreateInfo>
+    {
+        m_computeShader.getShaderStageCreateInfo()
+    };
+}
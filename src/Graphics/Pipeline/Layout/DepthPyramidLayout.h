@@ -0,0 +1,49 @@
+#pragma once
+
+
+#include "../../Interfaces/IPipelineLayout.h"
+#include "../../Utils/Shader.h"
+
+#include "glm/vec2.hpp"
+
+/// <summary>
+///     Layout of the depth pyramid reductions: one set per level, sampling the level above (or the depth image)
+///     and writing its own level as a storage image
+/// </summary>
+class DepthPyramidLayout :
+    public IPipelineLayout
+{
+public:
+    static constexpr const uint32_t _maxLevels = 16;
+
+    struct PushConstants
+    {
+        glm::uvec2 sourceSize;
+        glm::uvec2 size;
+        uint32_t samples;
+    };
+
+public:
+    DepthPyramidLayout(const char* computeShader);
+    ~DepthPyramidLayout();
+
+
+    auto                                setImages(uint32_t level, vk::ImageView source, vk::ImageLayout sourceLayout, vk::ImageView destination) -> void;
+    auto                                bindDescriptorSet(vk::CommandBuffer& commandBuffer, uint32_t level) const -> void;
+    auto                                setPushConstants(vk::CommandBuffer& commandBuffer, const PushConstants& constants) const -> void;
+
+    // Inherited via IPipelineLayout
+    virtual void bindDescriptorSets(vk::CommandBuffer& commandBuffer) const override;
+    virtual vk::PipelineLayout getPipelineLayout() const override;
+    virtual std::vector<vk::PipelineShaderStageCreateInfo> getShadersCreateInfo() const override;
+
+private:
+    vk::DescriptorPool                  m_descriptorPool;
+    vk::DescriptorSetLayout             m_descriptorLayout;
+    std::vector<vk::DescriptorSet>      m_descriptorSets;
+
+    vk::PipelineLayout                  m_pipelineLayout;
+
+    Shader                              m_computeShader;
+
+};
@@ -3,19 +3,24 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-TextureLayout::TextureLayout() :
-    m_vertexShader("Shaders/basic.vert.spv"),
+#include "../../VulkanRenderer.h"
+
+TextureLayout::TextureLayout(const char* vertexShader) :
+    m_vertexShader(vertexShader),
     m_fragmentShader("Shaders/basic.frag.spv")
 {
-    vk::DescriptorSetLayoutBinding bindingInfoUBO, bindingInfoTexture;
+    vk::DescriptorSetLayoutBinding bindingInfoUBO, bindingInfoTexture, bindingInfoInstances;
     bindingInfoUBO.setBinding(0).setDescriptorCount(1)
         .setDescriptorType(vk::DescriptorType::eUniformBuffer)
         .setStageFlags(vk::ShaderStageFlagBits::eVertex);
     bindingInfoTexture.setBinding(1).setDescriptorCount(1)
         .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
         .setStageFlags(vk::ShaderStageFlagBits::eFragment);
+    bindingInfoInstances.setBinding(2).setDescriptorCount(1)
+        .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+        .setStageFlags(vk::ShaderStageFlagBits::eVertex);
 
-    std::vector<vk::DescriptorSetLayoutBinding> bindings = { bindingInfoUBO, bindingInfoTexture };
+    std::vector<vk::DescriptorSetLayoutBinding> bindings = { bindingInfoUBO, bindingInfoTexture, bindingInfoInstances };
     vk::DescriptorSetLayoutCreateInfo vertexShaderLayout;
     vertexShaderLayout.setBindingCount((uint32_t)bindings.size())
         .setPBindings(bindings.data());
@@ -39,8 +44,11 @@ TextureLayout::TextureLayout() :
 
 TextureLayout::~TextureLayout()
 {
-    m_vulkanDevice.m_logicalDevice.destroyBuffer(m_vertexShaderUniformBuffer.m_buffer);
-    vmaFreeMemory(g_allocator, m_vertexShaderUniformBuffer.m_memory);
+    for (const auto& it : m_vertexShaderUniformBuffers)
+    {
+        m_vulkanDevice.m_logicalDevice.destroyBuffer(it.m_buffer);
+        vmaFreeMemory(g_allocator, it.m_memory);
+    }
 
     if (m_descriptorPool)
     { // m_vulkanDevice.m_logicalDevice.freeDescriptorSets(m_descriptorPool, m_descriptorSets);
@@ -61,22 +69,36 @@ TextureLayout::~TextureLayout()
 
 void TextureLayout::update() 
 {
+    auto inFlightFrame = VulkanRenderer::Get()->getInFlightFrame();
+    if (m_hasTexture && m_descriptorSetImageVersions[inFlightFrame] != m_imageVersion)
+    {
+        vk::WriteDescriptorSet writeSet;
+        writeSet.setDescriptorCount(1).setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+            .setDstArrayElement(0).setDstBinding(1).setDstSet(m_descriptorSets[inFlightFrame]).setPImageInfo(&m_imageInfo);
+        m_vulkanDevice.m_logicalDevice.updateDescriptorSets(1, &writeSet, 0, nullptr);
+        m_descriptorSetImageVersions[inFlightFrame] = m_imageVersion;
+    }
+
+    const auto& uniformBuffer = m_vertexShaderUniformBuffers[inFlightFrame];
     void* data;
-    vmaMapMemory(g_allocator, m_vertexShaderUniformBuffer.m_memory, &data);
+    vmaMapMemory(g_allocator, uniformBuffer.m_memory, &data);
     memcpy(data, &m_uniformBufferObject, sizeof(UniformBufferObject));
-    vmaUnmapMemory(g_allocator, m_vertexShaderUniformBuffer.m_memory);
+    vmaUnmapMemory(g_allocator, uniformBuffer.m_memory);
 }
 
 auto TextureLayout::createDescriptorPools() -> void
 {
-    std::array<vk::DescriptorPoolSize, 2> descriptorPoolSizes;
-    descriptorPoolSizes[0].setDescriptorCount(1);
+    uint32_t frames = VulkanRenderer::getMaxInFlightFrames();
+    std::array<vk::DescriptorPoolSize, 3> descriptorPoolSizes;
+    descriptorPoolSizes[0].setDescriptorCount(frames);
     descriptorPoolSizes[0].setType(vk::DescriptorType::eUniformBuffer);
-    descriptorPoolSizes[1].setDescriptorCount(1);
+    descriptorPoolSizes[1].setDescriptorCount(frames);
     descriptorPoolSizes[1].setType(vk::DescriptorType::eCombinedImageSampler);
+    descriptorPoolSizes[2].setDescriptorCount(frames);
+    descriptorPoolSizes[2].setType(vk::DescriptorType::eStorageBuffer);
 
     vk::DescriptorPoolCreateInfo descriptorPoolInfo = {};
-    descriptorPoolInfo.setMaxSets(1)
+    descriptorPoolInfo.setMaxSets(frames)
         .setPoolSizeCount((uint32_t)descriptorPoolSizes.size()).setPPoolSizes(descriptorPoolSizes.data());
 
     m_descriptorPool = m_vulkanDevice.m_logicalDevice.createDescriptorPool(descriptorPoolInfo);
@@ -85,30 +107,36 @@ auto TextureLayout::createDescriptorPools() -> void
 
 auto TextureLayout::allocateDescriptorSets() -> void
 {
-    std::vector<vk::DescriptorSetLayout> layouts(1, m_descriptorLayout);
+    std::vector<vk::DescriptorSetLayout> layouts(VulkanRenderer::getMaxInFlightFrames(), m_descriptorLayout);
     vk::DescriptorSetAllocateInfo allocationInfo;
     allocationInfo.setDescriptorPool(m_descriptorPool);
-    allocationInfo.setDescriptorSetCount(1);
+    allocationInfo.setDescriptorSetCount((uint32_t)layouts.size());
     allocationInfo.setPSetLayouts(layouts.data());
 
-    m_descriptorSet = m_vulkanDevice.m_logicalDevice.allocateDescriptorSets(allocationInfo)[0];
-    EVALUATE(m_descriptorSet, nullptr, == , "Couldn't allocate descriptor sets");
+    m_descriptorSets = m_vulkanDevice.m_logicalDevice.allocateDescriptorSets(allocationInfo);
+    EVALUATE(m_descriptorSets.size(), 0, == , "Couldn't allocate descriptor sets");
+    m_descriptorSetImageVersions.assign(m_descriptorSets.size(), 0);
+    m_descriptorSetInstanceBuffers.assign(m_descriptorSets.size(), vk::Buffer());
 }
 
 auto TextureLayout::updateDescriptorSets() -> void
 {
-    m_vertexShaderUniformBuffer = BufferUtils::createBuffer(vk::BufferUsageFlagBits::eUniformBuffer,
-        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, vk::MemoryPropertyFlagBits::eHostCached,
-        &m_vulkanDevice.m_families.graphicsIndex, 1, sizeof(UniformBufferObject));
+    for (const auto descriptorSet : m_descriptorSets)
+    {
+        auto uniformBuffer = BufferUtils::createBuffer(vk::BufferUsageFlagBits::eUniformBuffer,
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, vk::MemoryPropertyFlagBits::eHostCached,
+            &m_vulkanDevice.m_families.graphicsIndex, 1, sizeof(UniformBufferObject));
+        m_vertexShaderUniformBuffers.push_back(uniformBuffer);
 
-    vk::DescriptorBufferInfo bufferInfo;
-    bufferInfo.setBuffer(m_vertexShaderUniformBuffer.m_buffer)
-        .setOffset(0).setRange(sizeof(UniformBufferObject));
+        vk::DescriptorBufferInfo bufferInfo;
+        bufferInfo.setBuffer(uniformBuffer.m_buffer)
+            .setOffset(0).setRange(sizeof(UniformBufferObject));
 
-    vk::WriteDescriptorSet writeSet;
-    writeSet.setDescriptorCount(1).setDescriptorType(vk::DescriptorType::eUniformBuffer)
-        .setDstArrayElement(0).setDstBinding(0).setDstSet(m_descriptorSet).setPBufferInfo(&bufferInfo);
-    m_vulkanDevice.m_logicalDevice.updateDescriptorSets(1, &writeSet, 0, nullptr);
+        vk::WriteDescriptorSet writeSet;
+        writeSet.setDescriptorCount(1).setDescriptorType(vk::DescriptorType::eUniformBuffer)
+            .setDstArrayElement(0).setDstBinding(0).setDstSet(descriptorSet).setPBufferInfo(&bufferInfo);
+        m_vulkanDevice.m_logicalDevice.updateDescriptorSets(1, &writeSet, 0, nullptr);
+    }
 }
 
 
@@ -125,13 +153,9 @@ auto TextureLayout::setImage(Image* image, vk::Sampler sampler) -> void
 {
     if (image)
     {
-        vk::DescriptorImageInfo imageInfo;
-        imageInfo.setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
+        m_imageInfo.setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
             .setImageView(image->getImageView()).setSampler(sampler);
-        vk::WriteDescriptorSet writeSet;
-        writeSet.setDescriptorCount(1).setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
-            .setDstArrayElement(0).setDstBinding(1).setDstSet(m_descriptorSet).setPImageInfo(&imageInfo);
-        m_vulkanDevice.m_logicalDevice.updateDescriptorSets(1, &writeSet, 0, nullptr);
+        ++m_imageVersion;
         m_hasTexture = 1;
     }
     else
@@ -140,10 +164,25 @@ auto TextureLayout::setImage(Image* image, vk::Sampler sampler) -> void
     }
 }
 
+auto TextureLayout::setInstanceBuffer(vk::Buffer buffer) -> void
+{
+    auto inFlightFrame = VulkanRenderer::Get()->getInFlightFrame();
+    if (m_descriptorSetInstanceBuffers[inFlightFrame] == buffer)
+        return;
+
+    vk::DescriptorBufferInfo bufferInfo;
+    bufferInfo.setBuffer(buffer).setOffset(0).setRange(VK_WHOLE_SIZE);
+    vk::WriteDescriptorSet writeSet;
+    writeSet.setDescriptorCount(1).setDescriptorType(vk::DescriptorType::eStorageBuffer)
+        .setDstArrayElement(0).setDstBinding(2).setDstSet(m_descriptorSets[inFlightFrame]).setPBufferInfo(&bufferInfo);
+    m_vulkanDevice.m_logicalDevice.updateDescriptorSets(1, &writeSet, 0, nullptr);
+    m_descriptorSetInstanceBuffers[inFlightFrame] = buffer;
+}
+
 void TextureLayout::bindDescriptorSets(vk::CommandBuffer& commandBuffer) const
 {
     commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_layout,
-        0, 1, &m_descriptorSet, 0, nullptr);
+        0, 1, &m_descriptorSets[VulkanRenderer::Get()->getInFlightFrame()], 0, nullptr);
     commandBuffer.pushConstants(m_layout, vk::ShaderStageFlagBits::eFragment,
         0, sizeof(uint32_t), &m_hasTexture);
 }
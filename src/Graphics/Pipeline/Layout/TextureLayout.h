@@ -21,10 +21,11 @@ class TextureLayout :
         glm::mat4 projection;
     };
 public:
-    TextureLayout();
+    TextureLayout(const char* vertexShader = "Shaders/basic.vert.spv");
     ~TextureLayout();
 
 
+    // Uploads the matrices into the current in-flight frame's uniform buffer, and writes the image set since its last use
     virtual     void                        update();
 
 
@@ -36,7 +37,11 @@ public:
     virtual     vk::PipelineLayout          getPipelineLayout() const { return m_layout; };
 
 public:
+                // Applied to each in-flight frame's set by update(), so sets still read by the GPU are left alone
                 auto                        setImage(Image* image, vk::Sampler sampler) -> void;
+                // Storage buffer of the instance transforms, for the current in-flight frame's set only.
+                // !THE FENCE OF THE CURRENT IN-FLIGHT FRAME MUST HAVE BEEN WAITED ON
+                auto                        setInstanceBuffer(vk::Buffer buffer) -> void;
                 auto                        getVertexShader() const -> const Shader& { return m_vertexShader; };
                 auto                        getFragmentShader() const -> const Shader& { return m_fragmentShader; };
                 auto                        setWorld(const glm::mat4& world) -> void { m_uniformBufferObject.world = world; };
@@ -53,14 +58,19 @@ private:
     vk::DescriptorSetLayout                 m_descriptorLayout;
     vk::DescriptorPool                      m_descriptorPool;
 
-    vk::DescriptorSet                       m_descriptorSet;
+    // One set and uniform buffer per in-flight frame, so updating never touches what the GPU may still read
+    std::vector<vk::DescriptorSet>          m_descriptorSets;
 
     Shader                                  m_vertexShader;
     Shader                                  m_fragmentShader;
 
     uint32_t                                m_hasTexture = 0;
+    vk::DescriptorImageInfo                 m_imageInfo;
+    uint32_t                                m_imageVersion = 0;
+    std::vector<uint32_t>                   m_descriptorSetImageVersions;
+    std::vector<vk::Buffer>                 m_descriptorSetInstanceBuffers;
 
-    BufferUtils::Buffer                     m_vertexShaderUniformBuffer;
+    std::vector<BufferUtils::Buffer>        m_vertexShaderUniformBuffers;
 
     UniformBufferObject                     m_uniformBufferObject;
 
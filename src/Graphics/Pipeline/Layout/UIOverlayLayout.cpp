@@ -7,9 +7,10 @@ UIOverlayLayout::UIOverlayLayout():
     // Descriptor pool
     {
         std::array<vk::DescriptorPoolSize, 1> poolSizes;
-        poolSizes[0].setDescriptorCount(1).setType(vk::DescriptorType::eCombinedImageSampler);
+        poolSizes[0].setDescriptorCount(_maxTextures).setType(vk::DescriptorType::eCombinedImageSampler);
         vk::DescriptorPoolCreateInfo poolInfo;
-        poolInfo.setMaxSets(1).setPoolSizeCount((uint32_t)poolSizes.size()).setPPoolSizes(poolSizes.data());
+        poolInfo.setMaxSets(_maxTextures).setPoolSizeCount((uint32_t)poolSizes.size()).setPPoolSizes(poolSizes.data())
+            .setFlags(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet);
         EVALUATE(m_descriptorPool = m_vulkanDevice.m_logicalDevice.createDescriptorPool(poolInfo),
             nullptr, == , "Unable to create a descriptor pool for UIOverlayLayout");
     }
@@ -24,13 +25,6 @@ UIOverlayLayout::UIOverlayLayout():
         EVALUATE(m_descriptorLayout = m_vulkanDevice.m_logicalDevice.createDescriptorSetLayout(layoutInfo),
             nullptr, == , "Unable to create Descriptor Layout for UIOverlayLayout");
     }
-    // Descriptor sets
-    {
-        vk::DescriptorSetAllocateInfo allocateInfo;
-        allocateInfo.setDescriptorPool(m_descriptorPool).setDescriptorSetCount(1).setPSetLayouts(&m_descriptorLayout);
-        m_descriptorSets = m_vulkanDevice.m_logicalDevice.allocateDescriptorSets(allocateInfo);
-        EVALUATE(m_descriptorSets.size(), 0, == , "Unable to allocate descriptor sets for UIOverlayLayout");
-    }
     // Pipeline layout
     {
         vk::PushConstantRange pushConstant;
@@ -70,19 +64,70 @@ auto UIOverlayLayout::setPushConstants(vk::CommandBuffer& commandBuffer, const g
 
 auto UIOverlayLayout::setImage(const Image* fontImage, const vk::Sampler sampler) -> void
 {
+    m_defaultDescriptorSet = getDescriptorSet(fontImage, sampler);
+}
+
+auto UIOverlayLayout::getDescriptorSet(const Image* image, const vk::Sampler sampler) -> vk::DescriptorSet
+{
+    auto key = std::make_pair(image, (VkSampler)sampler);
+    auto it = m_descriptorSets.find(key);
+    if (it != m_descriptorSets.end())
+        return it->second;
+
+    if (m_descriptorSets.size() == _maxTextures)
+    {
+        if (!m_exhausted)
+        {
+            WARNING(appendToString("UIOverlayLayout holds ", _maxTextures,
+                " textures already, drawing the others with the font texture until some are released"));
+            m_exhausted = true;
+        }
+        return m_defaultDescriptorSet;
+    }
+
+    vk::DescriptorSetAllocateInfo allocateInfo;
+    allocateInfo.setDescriptorPool(m_descriptorPool).setDescriptorSetCount(1).setPSetLayouts(&m_descriptorLayout);
+    auto descriptorSets = m_vulkanDevice.m_logicalDevice.allocateDescriptorSets(allocateInfo);
+    EVALUATE(descriptorSets.size(), 0, == , "Unable to allocate descriptor sets for UIOverlayLayout");
+
     vk::DescriptorImageInfo imageInfo;
     imageInfo.setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
-        .setImageView(fontImage->getImageView()).setSampler(sampler);
+        .setImageView(image->getImageView()).setSampler(sampler);
 
     vk::WriteDescriptorSet writeDescriptorSet;
     writeDescriptorSet.setDescriptorCount(1).setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
-        .setDstArrayElement(0).setDstBinding(0).setDstSet(m_descriptorSets[0]).setPImageInfo(&imageInfo);
+        .setDstArrayElement(0).setDstBinding(0).setDstSet(descriptorSets[0]).setPImageInfo(&imageInfo);
     m_vulkanDevice.m_logicalDevice.updateDescriptorSets(1, &writeDescriptorSet, 0, nullptr);
+
+    m_descriptorSets[key] = descriptorSets[0];
+    return descriptorSets[0];
+}
+
+auto UIOverlayLayout::releaseImage(const Image* image) -> void
+{
+    for (auto it = m_descriptorSets.begin(); it != m_descriptorSets.end();)
+    {
+        if (it->first.first != image)
+        {
+            ++it;
+            continue;
+        }
+        if (it->second == m_defaultDescriptorSet)
+            m_defaultDescriptorSet = nullptr;
+        m_vulkanDevice.m_logicalDevice.freeDescriptorSets(m_descriptorPool, 1, &it->second);
+        it = m_descriptorSets.erase(it);
+        m_exhausted = false;
+    }
+}
+
+auto UIOverlayLayout::bindDescriptorSet(vk::CommandBuffer& commandBuffer, vk::DescriptorSet descriptorSet) const -> void
+{
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
 }
 
 void UIOverlayLayout::bindDescriptorSets(vk::CommandBuffer& commandBuffer) const
 {
-    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipelineLayout, 0, 1, m_descriptorSets.data(), 0, nullptr);
+    bindDescriptorSet(commandBuffer, m_defaultDescriptorSet);
 }
 
 vk::PipelineLayout UIOverlayLayout::getPipelineLayout() const
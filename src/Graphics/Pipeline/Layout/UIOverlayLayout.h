@@ -7,9 +7,12 @@
 
 #include "glm/vec2.hpp"
 
+#include <map>
+
 class UIOverlayLayout :
     public IPipelineLayout
 {
+    static constexpr const uint32_t _maxTextures = 64;
 public:
     struct PushConstants
     {
@@ -24,6 +27,17 @@ public:
 
     auto                                setPushConstants(vk::CommandBuffer& commandBuffer, const glm::vec2& scale, const glm::vec2& translate) -> void;
     auto                                setImage(const Image*, const vk::Sampler) -> void;
+    /// <summary>
+    ///     Returns the descriptor set sampling image with sampler, allocating and caching it on first use.
+    ///     Sets are cached by image until releaseImage
+    /// </summary>
+    auto                                getDescriptorSet(const Image*, const vk::Sampler) -> vk::DescriptorSet;
+    /// <summary>
+    ///     Frees the descriptor sets of image, call it before destroying an image the overlay drew.
+    ///     !NO FRAME IN FLIGHT MAY STILL USE THEM
+    /// </summary>
+    auto                                releaseImage(const Image*) -> void;
+    auto                                bindDescriptorSet(vk::CommandBuffer& commandBuffer, vk::DescriptorSet descriptorSet) const -> void;
 
     // Inherited via IPipelineLayout
     virtual void bindDescriptorSets(vk::CommandBuffer& commandBuffer) const override;
@@ -33,7 +47,9 @@ public:
 private:
     vk::DescriptorPool                  m_descriptorPool;
     vk::DescriptorSetLayout             m_descriptorLayout;
-    std::vector<vk::DescriptorSet>      m_descriptorSets;
+    vk::DescriptorSet                   m_defaultDescriptorSet;
+    std::map<std::pair<const Image*, VkSampler>, vk::DescriptorSet> m_descriptorSets;
+    bool                                m_exhausted = false;    // Warned once until a set is freed
 
     vk::PipelineLayout                  m_pipelineLayout;
 
@@ -8,46 +8,68 @@
 #include "Layout/TextureLayout.h"
 #include "../Vertex/PositionColorVertex.h"
 
+/// <summary>
+///     How a SimplePipeline uses the depth buffer. eEqual shades only what a depth pre-pass left visible and
+///     writes no depth, eDepthOnly is the pre-pass itself and has no colour attachment
+/// </summary>
+enum class DepthMode
+{
+    eLess,
+    eEqual,
+    eDepthOnly
+};
+
 template <class PipelineLayoutType, class VertexType>
 class SimplePipeline : 
     public IGraphicsPipeline<PipelineLayoutType, VertexType>, public IFrameDependent
 {
 public:
-    SimplePipeline(PipelineLayoutType* pipelineLayout, vk::RenderPass pass, uint32_t subpass) : 
-        m_pipelineLayout(pipelineLayout), m_renderPass(pass), m_subpass(subpass)  {};
+    // An async pipeline is compiled on a worker, getPipeline() is null until it's done
+    SimplePipeline(PipelineLayoutType* pipelineLayout, vk::RenderPass pass, uint32_t subpass, DepthMode depthMode = DepthMode::eLess,
+        bool async = false) :
+        m_pipelineLayout(pipelineLayout), m_renderPass(pass), m_subpass(subpass), m_depthMode(depthMode), m_async(async)  {};
     ~SimplePipeline() {};
 
 public:
     // Inherited via IFrameDependent
+    // Viewport and scissor are dynamic, so only a change of sample count rebuilds the pipeline. The render pass,
+    // and with it the attachment formats, is fixed for the pipeline's lifetime
     virtual void create(uint32_t totalFrames, uint32_t width, uint32_t height) override
     {
-        this->m_depthState.setDepthTestEnable(VK_TRUE).setDepthWriteEnable(VK_TRUE)
-            .setDepthBoundsTestEnable(VK_FALSE).setDepthCompareOp(vk::CompareOp::eLess)
+        auto samples = this->m_vulkanDevice.m_bestSampling;
+        if (this->m_pipeline && samples == m_samples)
+            return;
+        this->reset();
+        m_samples = samples;
+
+        this->m_depthState.setDepthTestEnable(VK_TRUE).setDepthWriteEnable(m_depthMode != DepthMode::eEqual)
+            .setDepthBoundsTestEnable(VK_FALSE)
+            .setDepthCompareOp(m_depthMode == DepthMode::eEqual ? vk::CompareOp::eEqual : vk::CompareOp::eLess)
             .setMinDepthBounds(0.0f).setMaxDepthBounds(1.0f)
             .setStencilTestEnable(VK_FALSE);
+        this->m_blendState.setAttachmentCount(m_depthMode == DepthMode::eDepthOnly ? 0 : 1);
         this->m_msaaState.setAlphaToCoverageEnable(VK_FALSE).setAlphaToOneEnable(VK_FALSE)
             .setSampleShadingEnable(VK_FALSE).setMinSampleShading(0.0f)
-            .setPSampleMask(nullptr).setRasterizationSamples(this->m_vulkanDevice.m_bestSampling);
-        // Viewport state
-        this->m_viewport.setX(0).setY(0).setWidth((float)width).setHeight((float)height).setMinDepth(0.0f).setMaxDepth(1.0f);
-        this->m_scissor.setOffset({ 0,0 });
-        this->m_scissor.setExtent({ width, height });
-        
-        this->updatePipeline(m_pipelineLayout, m_renderPass, m_subpass);
+            .setPSampleMask(nullptr).setRasterizationSamples(samples);
+
+        this->updatePipeline(m_pipelineLayout, m_renderPass, m_subpass, m_async);
     }
 
     virtual void render(uint32_t frameIndex) override
     {
     }
 
+    // Kept across resizes, create() decides whether it's still valid
     virtual void frameCleanup() override
     {
-        this->reset();
     }
 
 private:
     PipelineLayoutType*         m_pipelineLayout;
     vk::RenderPass              m_renderPass;
     uint32_t                    m_subpass;
+    DepthMode                   m_depthMode;
+    bool                        m_async;
+    vk::SampleCountFlagBits     m_samples = vk::SampleCountFlagBits::e1;
 
 };
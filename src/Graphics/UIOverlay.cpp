@@ -2,12 +2,15 @@
 
 
 #include "Utils/Samplers.h"
+#include "Utils/GpuProfiler.h"
+#include "Utils/PipelineRegistry.h"
 
 #include "../Core/Input.h"
 #include "../Core/Window.h"
+#include "../Core/CpuProfiler.h"
 #include "VulkanRenderer.h"
 
-UIOverlay::UIOverlay(vk::RenderPass renderpass)
+UIOverlay::UIOverlay(vk::RenderPass renderpass, uint32_t subpass)
 {
     // Init ImGui
     ImGui::CreateContext();
@@ -17,40 +20,29 @@ UIOverlay::UIOverlay(vk::RenderPass renderpass)
     style.AntiAliasedFill = true;
     style.AntiAliasedLines = true;
 
+    m_geometryBuffer = std::make_unique<FrameRingBuffer>(
+        vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer);
+
     prepareFont();
-    preparePipeline(renderpass);
+    preparePipeline(renderpass, subpass);
 }
 
 UIOverlay::~UIOverlay()
 {
     ImGui::DestroyContext();
 
-    if (m_vertexBuffer.m_buffer)
-    {
-        m_vulkanDevice.m_logicalDevice.destroyBuffer(m_vertexBuffer.m_buffer);
-        vmaFreeMemory(g_allocator, m_vertexBuffer.m_memory);
-    }
-
-    if (m_indexBuffer.m_buffer)
-    {
-        m_vulkanDevice.m_logicalDevice.destroyBuffer(m_indexBuffer.m_buffer);
-        vmaFreeMemory(g_allocator, m_indexBuffer.m_memory);
-    }
+    m_geometryBuffer.reset();
 
-    if (m_pipelineLayout)
-    {
-        m_vulkanDevice.m_logicalDevice.destroyPipeline(m_pipeline);
-        m_pipelineLayout = nullptr;
-    }
+    m_pipeline.reset();
     m_pipelineLayout.reset();
     m_fontImage.reset();
 }
 
-auto UIOverlay::update(float frametime) -> bool
+auto UIOverlay::update(float frametime) -> void
 {
+    CPU_PROFILE_ZONE("UIOverlay::update");
     ImGuiIO& io = ImGui::GetIO();
 
-    io.DisplaySize = ImVec2(WindowObject::Get()->getWindowWidth(), WindowObject::Get()->getWindowHeight());
     io.DeltaTime = frametime;
 
     io.MousePos = ImVec2((float)Input::Get()->getMouseX(), (float)Input::Get()->getMouseY());
@@ -66,8 +58,6 @@ auto UIOverlay::update(float frametime) -> bool
         m_uicallback(frametime);
 
     ImGui::Render();
-
-    return update();
 }
 
 auto UIOverlay::render(vk::CommandBuffer commandBuffer, float width, float height) -> void
@@ -80,32 +70,100 @@ auto UIOverlay::render(vk::CommandBuffer commandBuffer, float width, float heigh
         return;
     }
 
-    ImGuiIO& io = ImGui::GetIO();
+    if (!upload()) { return; }
 
+    // Draw data is in display units with DisplayPos as the top-left corner
+    ImVec2 clipOffset = imDrawData->DisplayPos;
+    ImVec2 clipScale = { width / imDrawData->DisplaySize.x, height / imDrawData->DisplaySize.y };
+    glm::vec2 scale = { 2.0f / imDrawData->DisplaySize.x, 2.0f / imDrawData->DisplaySize.y };
+    glm::vec2 translate = { -1.0f - clipOffset.x * scale.x, -1.0f - clipOffset.y * scale.y };
 
-    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipeline);
-    m_pipelineLayout->bindDescriptorSets(commandBuffer);
-    m_pipelineLayout->setPushConstants(commandBuffer, { 2.0f / io.DisplaySize.x, 2.0f / io.DisplaySize.y }, { -1.f,-1.0f });
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipeline->get());
+    m_pipelineLayout->setPushConstants(commandBuffer, scale, translate);
 
     vk::Viewport viewport(0.0f, 0.0f, (float)width, (float)height, 0.0f, 1.0f);
     commandBuffer.setViewport(0, 1, &viewport);
-    vk::Rect2D scissorRect(vk::Offset2D{}, vk::Extent2D{ (uint32_t)width, (uint32_t)height });
-    commandBuffer.setScissor(0, 1, &scissorRect);
 
-    VkDeviceSize offsets[1] = { 0 };
-    commandBuffer.bindVertexBuffers(0, 1, &m_vertexBuffer.m_buffer, offsets);
-    commandBuffer.bindIndexBuffer(m_indexBuffer.m_buffer, 0, vk::IndexType::eUint16);
+    commandBuffer.bindVertexBuffers(0, 1, &m_vertices.m_buffer, &m_vertices.m_offset);
+    commandBuffer.bindIndexBuffer(m_indices.m_buffer, m_indices.m_offset, vk::IndexType::eUint16);
 
+    vk::DescriptorSet boundSet;
+    vk::Rect2D boundScissor;
+    bool scissorBound = false;
     for (int32_t i = 0; i < imDrawData->CmdListsCount; i++)
     {
         const ImDrawList* cmd_list = imDrawData->CmdLists[i];
+
+        // Consecutive commands of a list are contiguous in the index buffer, so the ones
+        // sharing texture and scissor are merged into a single draw
+        uint32_t batchFirst = indexOffset;
+        uint32_t batchCount = 0;
+        auto flush = [&]()
+        {
+            if (batchCount)
+                commandBuffer.drawIndexed(batchCount, 1, batchFirst, vertexOffset, 0);
+            batchCount = 0;
+        };
+
         for (int32_t j = 0; j < cmd_list->CmdBuffer.Size; j++)
         {
             const ImDrawCmd* pcmd = &cmd_list->CmdBuffer[j];
-            commandBuffer.drawIndexed(pcmd->ElemCount, 1, indexOffset, vertexOffset, 0);
-            
+            uint32_t firstIndex = indexOffset;
             indexOffset += pcmd->ElemCount;
+
+            if (pcmd->UserCallback)
+            {
+                flush();
+                if (pcmd->UserCallback == ImDrawCallback_ResetRenderState)
+                {
+                    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipeline->get());
+                    m_pipelineLayout->setPushConstants(commandBuffer, scale, translate);
+                }
+                else
+                {
+                    pcmd->UserCallback(cmd_list, pcmd);
+                }
+                boundSet = nullptr;
+                scissorBound = false;
+                continue;
+            }
+
+            int32_t x0 = std::max((int32_t)((pcmd->ClipRect.x - clipOffset.x) * clipScale.x), 0);
+            int32_t y0 = std::max((int32_t)((pcmd->ClipRect.y - clipOffset.y) * clipScale.y), 0);
+            int32_t x1 = std::min((int32_t)((pcmd->ClipRect.z - clipOffset.x) * clipScale.x), (int32_t)width);
+            int32_t y1 = std::min((int32_t)((pcmd->ClipRect.w - clipOffset.y) * clipScale.y), (int32_t)height);
+            if (x1 <= x0 || y1 <= y0 || pcmd->ElemCount == 0)
+                continue;
+
+            vk::Rect2D scissorRect({ x0, y0 }, { (uint32_t)(x1 - x0), (uint32_t)(y1 - y0) });
+            vk::DescriptorSet descriptorSet = pcmd->TextureId ?
+                m_pipelineLayout->getDescriptorSet(static_cast<const Image*>(pcmd->TextureId), Samplers::Get()->getLinearAnisotropicSampler()) :
+                m_pipelineLayout->getDescriptorSet(m_fontImage.get(), Samplers::Get()->getLinearAnisotropicSampler());
+
+            bool sameState = scissorBound && descriptorSet == boundSet && scissorRect == boundScissor;
+            if (sameState && firstIndex == batchFirst + batchCount)
+            {
+                batchCount += pcmd->ElemCount;
+                continue;
+            }
+
+            flush();
+            if (descriptorSet != boundSet)
+            {
+                m_pipelineLayout->bindDescriptorSet(commandBuffer, descriptorSet);
+                boundSet = descriptorSet;
+            }
+            if (!scissorBound || scissorRect != boundScissor)
+            {
+                commandBuffer.setScissor(0, 1, &scissorRect);
+                boundScissor = scissorRect;
+                scissorBound = true;
+            }
+            batchFirst = firstIndex;
+            batchCount = pcmd->ElemCount;
         }
+        flush();
+
         vertexOffset += cmd_list->VtxBuffer.Size;
     }
 }
@@ -136,9 +194,10 @@ auto UIOverlay::prepareFont() -> void
         vk::ImageUsageFlagBits::eSampled,
         vk::MemoryPropertyFlagBits::eDeviceLocal, vk::MemoryPropertyFlags(),
         vk::ImageLayout::eShaderReadOnlyOptimal);
+    io.Fonts->TexID = (ImTextureID)m_fontImage.get();
 }
 
-auto UIOverlay::preparePipeline(vk::RenderPass renderpass) -> void
+auto UIOverlay::preparePipeline(vk::RenderPass renderpass, uint32_t subpass) -> void
 {
     m_pipelineLayout = std::make_unique<UIOverlayLayout>();
     m_pipelineLayout->setImage(m_fontImage.get(), Samplers::Get()->getLinearAnisotropicSampler());
@@ -221,58 +280,26 @@ auto UIOverlay::preparePipeline(vk::RenderPass renderpass) -> void
         .setPVertexInputState(&vertexInputState)
         .setLayout(m_pipelineLayout->getPipelineLayout())
         .setStageCount((uint32_t)stages.size()).setPStages(stages.data())
-        .setRenderPass(renderpass).setSubpass(0);
-    EVALUATE(m_pipeline = m_vulkanDevice.m_logicalDevice.createGraphicsPipeline(nullptr, pipelineInfo),
-        nullptr, == , "Unable to create a graphics pipeline for UIOverlay");
+        .setRenderPass(renderpass).setSubpass(subpass);
+    m_pipeline = PipelineRegistry::Get()->acquire(pipelineInfo);
 }
 
-auto UIOverlay::update() -> bool
+auto UIOverlay::upload() -> bool
 {
     ImDrawData* imDrawData = ImGui::GetDrawData();
-    bool updated = false;
-
-    if (!imDrawData) { return false; }
 
     vk::DeviceSize vertexBuffSize = imDrawData->TotalVtxCount * sizeof(ImDrawVert);
     vk::DeviceSize indexBuffSize = imDrawData->TotalIdxCount * sizeof(ImDrawIdx);
     if (vertexBuffSize == 0 || indexBuffSize == 0) { return false; }
 
-    VulkanRenderer::Get()->wait();
-
-    if (vertexBuffSize != m_vertexBuffer.m_size)
-    {
-        
-        if (m_vertexBuffer.m_buffer)
-        {
-            m_vulkanDevice.m_logicalDevice.destroyBuffer(m_vertexBuffer.m_buffer);
-            vmaFreeMemory(g_allocator, m_vertexBuffer.m_memory);
-        }
-
-        m_vertexBuffer = BufferUtils::createBuffer(vk::BufferUsageFlagBits::eVertexBuffer,
-            vk::MemoryPropertyFlagBits::eHostVisible, {},
-            &m_vulkanDevice.m_families.graphicsIndex, 1, vertexBuffSize);
-        updated = true;
-    }
-
-    if (indexBuffSize != m_indexBuffer.m_size)
-    {
-        if (m_indexBuffer.m_buffer)
-        {
-            m_vulkanDevice.m_logicalDevice.destroyBuffer(m_indexBuffer.m_buffer);
-            vmaFreeMemory(g_allocator, m_indexBuffer.m_memory);
-        }
-        m_indexBuffer = BufferUtils::createBuffer(vk::BufferUsageFlagBits::eIndexBuffer,
-            vk::MemoryPropertyFlagBits::eHostVisible, {},
-            &m_vulkanDevice.m_families.graphicsIndex, 1, indexBuffSize);
-        updated = true;
-    }
-
-    // Upload data
-    ImDrawVert* vtxDest;
-    vmaMapMemory(g_allocator, m_vertexBuffer.m_memory, (void**)&vtxDest);
-    ImDrawIdx* idxDest;
-    vmaMapMemory(g_allocator, m_indexBuffer.m_memory, (void**)&idxDest);
+    // Called while recording, after this in-flight frame's fence was waited on, so its slice is free
+    m_geometryBuffer->begin(vertexBuffSize + indexBuffSize + sizeof(ImDrawVert));
+    m_vertices = m_geometryBuffer->allocate(vertexBuffSize, sizeof(ImDrawVert));
+    m_indices = m_geometryBuffer->allocate(indexBuffSize, sizeof(ImDrawIdx));
+    if (!m_vertices.m_buffer || !m_indices.m_buffer) { return false; }
 
+    ImDrawVert* vtxDest = static_cast<ImDrawVert*>(m_vertices.m_data);
+    ImDrawIdx* idxDest = static_cast<ImDrawIdx*>(m_indices.m_data);
     for (int i = 0; i < imDrawData->CmdListsCount; ++i)
     {
         const ImDrawList* cmdList = imDrawData->CmdLists[i];
@@ -281,13 +308,9 @@ auto UIOverlay::update() -> bool
         vtxDest += cmdList->VtxBuffer.Size;
         idxDest += cmdList->IdxBuffer.Size;
     }
-    vmaUnmapMemory(g_allocator, m_vertexBuffer.m_memory);
-    vmaUnmapMemory(g_allocator, m_indexBuffer.m_memory);
-
-    vmaFlushAllocation(g_allocator, m_vertexBuffer.m_memory, 0, m_vertexBuffer.m_size);
-    vmaFlushAllocation(g_allocator, m_indexBuffer.m_memory, 0, m_indexBuffer.m_size);
+    m_geometryBuffer->flush();
 
-    return updated;
+    return true;
 }
 
 auto UIOverlay::begin(const std::string& name) -> void
@@ -304,3 +327,33 @@ auto UIOverlay::text(const std::string& msg) -> void
 {
     ImGui::Text(msg.c_str());
 }
+
+auto UIOverlay::checkbox(const std::string& label, bool* value) -> bool
+{
+    return ImGui::Checkbox(label.c_str(), value);
+}
+
+auto UIOverlay::releaseImage(const Image* image) -> void
+{
+    m_pipelineLayout->releaseImage(image);
+}
+
+auto UIOverlay::gpuProfilerPanel() -> void
+{
+    ImGui::Begin("GPU profiler");
+    auto profiler = GpuProfiler::Get();
+    if (!profiler->isSupported())
+    {
+        ImGui::Text("Timestamp queries are not supported");
+    }
+    else
+    {
+        if (const auto& frameTime = profiler->getFrameResult(); frameTime)
+            ImGui::Text("Frame %llu: %.3f ms", (unsigned long long)frameTime->m_frame, frameTime->m_milliseconds);
+        for (const auto& scope : profiler->getResults())
+        {
+            ImGui::Text("%*s%s: %.3f ms", (int)scope.m_depth * 2, "", scope.m_name.c_str(), scope.m_milliseconds);
+        }
+    }
+    ImGui::End();
+}
@@ -6,16 +6,17 @@
 #include "imgui/imgui.h"
 #include "Utils/Shader.h"
 #include "Utils/Image.h"
-#include "Utils/BufferUtils.h"
+#include "Utils/FrameRingBuffer.h"
+#include "Utils/PipelineRegistry.h"
 
 class UIOverlay : public IVulkanDeviceObject
 {
 public:
-    UIOverlay(vk::RenderPass renderpass);
+    UIOverlay(vk::RenderPass renderpass, uint32_t subpass = 0);
     ~UIOverlay();
 
 public:
-    auto                                update(float frametime) -> bool;
+    auto                                update(float frametime) -> void;
     auto                                render(vk::CommandBuffer commandBuffer, float width, float height) -> void;
 
 public:
@@ -28,25 +29,35 @@ public:
     auto                                end() -> void;
     
     auto                                text(const std::string& msg) -> void;
+    auto                                checkbox(const std::string& label, bool* value) -> bool;
+
+    auto                                gpuProfilerPanel() -> void;
+    /// <summary>
+    ///     Forgets an image drawn through ImGui::Image, before it is destroyed
+    /// </summary>
+    auto                                releaseImage(const Image* image) -> void;
 
 private:
     auto                                prepareFont() -> void;
-    auto                                preparePipeline(vk::RenderPass) -> void;
+    auto                                preparePipeline(vk::RenderPass, uint32_t subpass) -> void;
 
 private:
-    auto                                update() -> bool;
+    auto                                upload() -> bool;
 
 public:
     std::unique_ptr<Image>              m_fontImage;
 
-    BufferUtils::Buffer                 m_vertexBuffer;
-    BufferUtils::Buffer                 m_indexBuffer;
+    // Geometry of the current draw data, streamed every frame
+    std::unique_ptr<FrameRingBuffer>    m_geometryBuffer;
+    FrameRingBuffer::Allocation         m_vertices;
+    FrameRingBuffer::Allocation         m_indices;
 
     std::function<void(float)>          m_uicallback;
 
     // Pipeline
     std::unique_ptr<UIOverlayLayout>    m_pipelineLayout;
-    vk::Pipeline                        m_pipeline;
+    std::shared_ptr<PipelineRegistry::Pipeline>
+                                        m_pipeline;
 
 };
 
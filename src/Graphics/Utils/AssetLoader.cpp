@@ -0,0 +1,105 @@
+#include "AssetLoader.h"
+
+#include "../../Core/JobSystem.h"
+#include "../../Core/CpuProfiler.h"
+
+
+AssetLoader::~AssetLoader()
+{
+    // Jobs still hold a pointer to this loader
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_jobsDone.wait(lock, [&]() { return m_runningJobs == 0; });
+}
+
+auto AssetLoader::loadImage(const std::string& path, vk::ImageUsageFlags usage,
+    vk::MemoryPropertyFlags requiredMemory, vk::MemoryPropertyFlags preferredMemory) -> AssetHandle<Image>
+{
+    return load<Image>(path,
+        [](const std::string& path)
+        {
+            CPU_PROFILE_ZONE("AssetLoader::decodeImage");
+            return Image::decode(path.c_str());
+        },
+        [=](Image::ImageData& data)
+        {
+            return std::make_unique<Image>(data, usage, requiredMemory, preferredMemory);
+        });
+}
+
+auto AssetLoader::loadModel(const std::string& path, Model::VertexFormat format) -> AssetHandle<Model>
+{
+    return load<Model>(path,
+        [format](const std::string& path)
+        {
+            CPU_PROFILE_ZONE("AssetLoader::loadMesh");
+            auto mesh = Model::loadMesh(path.c_str());
+            Model::packMesh(mesh, format);
+            return mesh;
+        },
+        [=](Model::MeshData& mesh)
+        {
+            return std::make_unique<Model>(std::move(mesh), format);
+        });
+}
+
+auto AssetLoader::update() -> void
+{
+    std::vector<std::function<void()>> decodedAssets;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        decodedAssets.swap(m_decodedAssets);
+    }
+
+    CPU_PROFILE_ZONE("AssetLoader::update");
+    for (const auto& it : decodedAssets)
+        it();
+}
+
+template <typename type, typename Decode, typename Create>
+auto AssetLoader::load(const std::string& path, Decode decode, Create create) -> AssetHandle<type>
+{
+    auto state = std::make_shared<typename AssetHandle<type>::State>();
+    state->m_path = path;
+    ++m_pendingAssets;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_runningJobs;
+    }
+
+    JobSystem::Get()->submit([this, state, decode, create]()
+    {
+        std::function<void()> finish;
+        try
+        {
+            auto data = std::make_shared<decltype(decode(state->m_path))>(decode(state->m_path));
+            finish = [this, state, data, create]()
+            {
+                try
+                {
+                    state->m_asset = create(*data);
+                    state->m_state = AssetState::eReady;
+                }
+                catch (const std::exception& e)
+                {
+                    ERROR(appendToString("Couldn't create asset ", state->m_path, ": ", e.what()));
+                    state->m_state = AssetState::eFailed;
+                }
+                --m_pendingAssets;
+            };
+        }
+        catch (const std::exception& e)
+        {
+            ERROR(appendToString("Couldn't load asset ", state->m_path, ": ", e.what()));
+            state->m_state = AssetState::eFailed;
+            --m_pendingAssets;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (finish)
+            m_decodedAssets.push_back(std::move(finish));
+        --m_runningJobs;
+        m_jobsDone.notify_all();
+    });
+
+    return AssetHandle<type>(state);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+
+#include <Oblivion.h>
+#include "Image.h"
+#include "../Model.h"
+
+#include <atomic>
+#include <condition_variable>
+
+
+enum class AssetState
+{
+    eLoading,
+    eReady,
+    eFailed
+};
+
+/// <summary>
+///     Shared view of an asset being loaded by the AssetLoader. Poll it from the main thread.
+/// </summary>
+template <typename type>
+class AssetHandle
+{
+public:
+    struct State
+    {
+        std::atomic<AssetState>         m_state{ AssetState::eLoading };
+        std::unique_ptr<type>           m_asset;
+        std::string                     m_path;
+    };
+
+public:
+    AssetHandle() = default;
+    AssetHandle(std::shared_ptr<State> state) : m_state(std::move(state)) {};
+
+    auto                                isReady() const -> bool { return m_state && m_state->m_state == AssetState::eReady; };
+    auto                                hasFailed() const -> bool { return m_state && m_state->m_state == AssetState::eFailed; };
+    auto                                get() const -> type* { return isReady() ? m_state->m_asset.get() : nullptr; };
+    auto                                reset() -> void { m_state.reset(); };
+
+private:
+    std::shared_ptr<State>              m_state;
+};
+
+
+/// <summary>
+///     Decodes and parses assets on the JobSystem workers. The Vulkan objects are created by update(),
+///     on the thread owning the renderer, and their data goes through the UploadManager.
+/// </summary>
+class AssetLoader
+{
+public:
+    AssetLoader() = default;
+    ~AssetLoader();
+
+public:
+    auto                                loadImage(const std::string& path, vk::ImageUsageFlags usage,
+                                            vk::MemoryPropertyFlags requiredMemory, vk::MemoryPropertyFlags preferredMemory) -> AssetHandle<Image>;
+    auto                                loadModel(const std::string& path,
+                                            Model::VertexFormat format = Model::VertexFormat::ePositionColor) -> AssetHandle<Model>;
+
+    /// <summary>
+    ///     Creates the GPU objects of the assets decoded since the last call
+    /// </summary>
+    auto                                update() -> void;
+    auto                                getPendingCount() const -> uint32_t { return m_pendingAssets.load(); };
+
+private:
+    template <typename type, typename Decode, typename Create>
+    auto                                load(const std::string& path, Decode decode, Create create) -> AssetHandle<type>;
+
+private:
+    std::mutex                          m_mutex;
+    std::condition_variable             m_jobsDone;
+    std::vector<std::function<void()>>  m_decodedAssets;    // Finishes an asset on the main thread
+    uint32_t                            m_runningJobs = 0;
+
+    std::atomic<uint32_t>               m_pendingAssets{ 0 };
+};
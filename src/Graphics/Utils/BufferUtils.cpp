@@ -1,7 +1,7 @@
 #include "BufferUtils.h"
 
 #include "VulkanAllocators.h"
-#include "OneTimeCommandBuffers.h"
+#include "UploadManager.h"
 
 namespace BufferUtils
 {
@@ -9,7 +9,6 @@ namespace BufferUtils
     Buffer createBuffer(vk::BufferUsageFlags usage,
         vk::MemoryPropertyFlags requiredMemory, vk::MemoryPropertyFlags preferredMemory,
         uint32_t * families, uint32_t familiesCount, std::size_t size,
-        vk::Device device, vk::Queue queue, uint32_t quueueFamilyIndex,
         void* pData )
     {
         if (pData)
@@ -41,44 +40,58 @@ namespace BufferUtils
                 vmaUnmapMemory(g_allocator, allocation);
             }
             else
-            {
-                bufferInfo.setPQueueFamilyIndices(&quueueFamilyIndex).setQueueFamilyIndexCount(1)
-                    .setSharingMode(vk::SharingMode::eExclusive).setUsage(vk::BufferUsageFlagBits::eTransferSrc);
-                vk::Buffer tempBuff;
-                VmaAllocationCreateInfo allocationInfo = {};
-                allocationInfo.requiredFlags = (VkMemoryPropertyFlags)vk::MemoryPropertyFlagBits::eHostVisible;
-                allocationInfo.preferredFlags = (VkMemoryPropertyFlags)vk::MemoryPropertyFlagBits::eHostCoherent;
-                VmaAllocation temporaryAllocation;
-                VkResult res = vmaCreateBuffer(g_allocator,
-                    (VkBufferCreateInfo*)&bufferInfo, &allocationInfo,
-                    (VkBuffer*)&tempBuff, &temporaryAllocation, nullptr);
-                EVALUATE(res, VkResult::VK_SUCCESS, != , "Couldn't create a valid transfer buffer");
-
-                void * data;
-                vmaMapMemory(g_allocator, temporaryAllocation, &data);
-                memcpy(data, pData, size);
-                vmaUnmapMemory(g_allocator, temporaryAllocation);
-
-
-                auto commandBuffers = OneTimeCommandBuffers::Get()->allocCommandBuffers<>();
-                auto commandBuffer = commandBuffers[0];
-
-                vk::BufferCopy copyInfo;
-                copyInfo.setSrcOffset(0).setDstOffset(0).setSize(size);
-                commandBuffer.copyBuffer(tempBuff, buffer, 1, &copyInfo);
-
-
-                OneTimeCommandBuffers::Get()->executeCommandBufers(commandBuffers, queue);
-                OneTimeCommandBuffers::Get()->freeCommandBuffers<>(commandBuffers);
-
-                device.destroyBuffer(tempBuff);
-                vmaFreeMemory(g_allocator, temporaryAllocation);
+            { // Staged through the upload manager, visible to every frame submitted afterwards
+                UploadManager::Get()->uploadBuffer(pData, size, buffer);
             }
         }
 
         return result;
+    }
+
+    Buffer createMappedBuffer(vk::BufferUsageFlags usage,
+        vk::MemoryPropertyFlags requiredMemory, vk::MemoryPropertyFlags preferredMemory,
+        uint32_t * families, uint32_t familiesCount, std::size_t size)
+    {
+        vk::BufferCreateInfo bufferInfo = {};
+        bufferInfo.setPQueueFamilyIndices(families).setQueueFamilyIndexCount(familiesCount)
+            .setSharingMode(familiesCount == 1 ? vk::SharingMode::eExclusive : vk::SharingMode::eConcurrent)
+            .setUsage(usage).setSize(size);
+
+        vk::Buffer buffer;
+        VmaAllocationCreateInfo allocationInfo = {};
+        allocationInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        allocationInfo.requiredFlags = (VkMemoryPropertyFlags)(requiredMemory | vk::MemoryPropertyFlagBits::eHostVisible);
+        allocationInfo.preferredFlags = (VkMemoryPropertyFlags)preferredMemory;
+        VmaAllocation allocation;
+        VmaAllocationInfo info = {};
+        VkResult res = vmaCreateBuffer(g_allocator, (VkBufferCreateInfo*)&bufferInfo, &allocationInfo,
+            (VkBuffer*)&buffer, &allocation, &info);
+        EVALUATE(res, VkResult::VK_SUCCESS, != , "Couldn't create a valid mapped buffer");
+        return { buffer,allocation,size,info.pMappedData };
 
     }
 
+    void releaseOwnership(vk::CommandBuffer commandBuffer, const Buffer& buffer,
+        uint32_t srcFamily, uint32_t dstFamily,
+        vk::PipelineStageFlags srcStage, vk::AccessFlags srcAccess)
+    {
+        vk::BufferMemoryBarrier barrier;
+        barrier.setBuffer(buffer.m_buffer).setOffset(0).setSize(VK_WHOLE_SIZE)
+            .setSrcQueueFamilyIndex(srcFamily).setDstQueueFamilyIndex(dstFamily)
+            .setSrcAccessMask(srcAccess).setDstAccessMask({});
+        commandBuffer.pipelineBarrier(srcStage, vk::PipelineStageFlagBits::eBottomOfPipe,
+            {}, 0, nullptr, 1, &barrier, 0, nullptr);
+    }
 
-}
\ No newline at end of file
+    void acquireOwnership(vk::CommandBuffer commandBuffer, const Buffer& buffer,
+        uint32_t srcFamily, uint32_t dstFamily,
+        vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess)
+    {
+        vk::BufferMemoryBarrier barrier;
+        barrier.setBuffer(buffer.m_buffer).setOffset(0).setSize(VK_WHOLE_SIZE)
+            .setSrcQueueFamilyIndex(srcFamily).setDstQueueFamilyIndex(dstFamily)
+            .setSrcAccessMask({}).setDstAccessMask(dstAccess);
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, dstStage,
+            {}, 0, nullptr, 1, &barrier, 0, nullptr);
+    }
+}
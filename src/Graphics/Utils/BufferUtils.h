@@ -11,12 +11,32 @@ namespace BufferUtils
         vk::Buffer      m_buffer;
         VmaAllocation   m_memory;
         std::size_t     m_size = 0;
+        void*           m_mapped = nullptr;     // Only set by createMappedBuffer, valid until the memory is freed
     };
 
     Buffer createBuffer(vk::BufferUsageFlags usage,
         vk::MemoryPropertyFlags requiredMemory, vk::MemoryPropertyFlags preferredMemory,
         uint32_t * families, uint32_t familiesCount, std::size_t size,
-        vk::Device device = nullptr, vk::Queue queue = nullptr, uint32_t queueFamilyIndex = ~0,
         void* pData = nullptr);
+    /// <summary>
+    ///     Host visible buffer that stays mapped for its whole lifetime, written through m_mapped
+    /// </summary>
+    Buffer createMappedBuffer(vk::BufferUsageFlags usage,
+        vk::MemoryPropertyFlags requiredMemory, vk::MemoryPropertyFlags preferredMemory,
+        uint32_t * families, uint32_t familiesCount, std::size_t size);
+
+    /// <summary>
+    ///     Records the release half of a queue family ownership transfer, on a command buffer of srcFamily
+    /// </summary>
+    void releaseOwnership(vk::CommandBuffer commandBuffer, const Buffer& buffer,
+        uint32_t srcFamily, uint32_t dstFamily,
+        vk::PipelineStageFlags srcStage, vk::AccessFlags srcAccess);
+    /// <summary>
+    ///     Records the acquire half of a queue family ownership transfer, on a command buffer of dstFamily.
+    ///     !MUST BE SUBMITTED AFTER THE RELEASE (usually waiting a semaphore signaled by it)
+    /// </summary>
+    void acquireOwnership(vk::CommandBuffer commandBuffer, const Buffer& buffer,
+        uint32_t srcFamily, uint32_t dstFamily,
+        vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess);
 
 }
\ No newline at end of file
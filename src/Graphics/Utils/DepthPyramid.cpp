@@ -0,0 +1,148 @@
+#include "DepthPyramid.h"
+
+
+namespace
+{
+    constexpr uint32_t _groupSize = 8;      // local_size_x and local_size_y of the reduction shaders
+
+    auto previousPowerOfTwo(uint32_t value) -> uint32_t
+    {
+        uint32_t result = 1;
+        while (result * 2 <= value)
+            result *= 2;
+        return result;
+    }
+}
+
+DepthPyramid::DepthPyramid()
+{
+    m_downsampleLayout = std::make_unique<DepthPyramidLayout>("Shaders/depthdownsample.comp.spv");
+    m_downsamplePipeline = std::make_unique<ComputePipeline<DepthPyramidLayout>>(m_downsampleLayout.get());
+}
+
+DepthPyramid::~DepthPyramid()
+{
+    cleanup();
+}
+
+auto DepthPyramid::create(const Image& depth, uint32_t width, uint32_t height, vk::SampleCountFlagBits samples) -> void
+{
+    m_sourceWidth = width;
+    m_sourceHeight = height;
+    // A single sampled attachment can't be bound as a sampler2DMS, so the first reduction has a variant per case
+    if (!m_reducePipeline || (m_samples == 1) != (samples == vk::SampleCountFlagBits::e1))
+    {
+        m_reducePipeline.reset();
+        m_reduceLayout = std::make_unique<DepthPyramidLayout>(samples == vk::SampleCountFlagBits::e1 ?
+            "Shaders/depthreducesingle.comp.spv" : "Shaders/depthreduce.comp.spv");
+        m_reducePipeline = std::make_unique<ComputePipeline<DepthPyramidLayout>>(m_reduceLayout.get());
+    }
+    m_samples = (uint32_t)samples;
+    m_width = previousPowerOfTwo(width);
+    m_height = previousPowerOfTwo(height);
+    m_levelCount = 1;
+    while ((std::max(m_width, m_height) >> m_levelCount) != 0)
+        ++m_levelCount;
+    m_levelCount = std::min(m_levelCount, DepthPyramidLayout::_maxLevels);
+
+    vk::ImageCreateInfo imageInfo;
+    imageInfo.setArrayLayers(1).setMipLevels(m_levelCount)
+        .setFormat(vk::Format::eR32Sfloat)
+        .setImageType(vk::ImageType::e2D).setInitialLayout(vk::ImageLayout::eUndefined)
+        .setSamples(vk::SampleCountFlagBits::e1).setTiling(vk::ImageTiling::eOptimal)
+        .setExtent(vk::Extent3D(m_width, m_height, 1))
+        .setUsage(vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled)
+        .setPQueueFamilyIndices(&m_vulkanDevice.m_families.graphicsIndex).setQueueFamilyIndexCount(1)
+        .setSharingMode(vk::SharingMode::eExclusive);
+
+    VmaAllocationCreateInfo allocationInfo = {};
+    allocationInfo.requiredFlags = (VkMemoryPropertyFlags)vk::MemoryPropertyFlagBits::eDeviceLocal;
+    VkResult res = vmaCreateImage(g_allocator, (VkImageCreateInfo*)&imageInfo, &allocationInfo,
+        (VkImage*)&m_image, &m_memory, nullptr);
+    EVALUATE(res, VkResult::VK_SUCCESS, != , "Couldn't create the depth pyramid");
+
+    vk::ImageViewCreateInfo viewInfo;
+    viewInfo.setComponents(vk::ComponentMapping())
+        .setFormat(vk::Format::eR32Sfloat).setImage(m_image)
+        .setViewType(vk::ImageViewType::e2D)
+        .setSubresourceRange(vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, m_levelCount, 0, 1));
+    m_imageView = m_vulkanDevice.m_logicalDevice.createImageView(viewInfo);
+    EVALUATE(m_imageView, nullptr, == , "Couldn't create a image view for the depth pyramid");
+    for (uint32_t level = 0; level < m_levelCount; ++level)
+    {
+        viewInfo.setSubresourceRange(vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, level, 1, 0, 1));
+        m_levelViews.push_back(m_vulkanDevice.m_logicalDevice.createImageView(viewInfo));
+        EVALUATE(m_levelViews.back(), nullptr, == , "Couldn't create a image view for depth pyramid level %d", level);
+    }
+
+    m_reduceLayout->setImages(0, depth.getImageView(), vk::ImageLayout::eDepthStencilReadOnlyOptimal, m_levelViews[0]);
+    for (uint32_t level = 1; level < m_levelCount; ++level)
+        m_downsampleLayout->setImages(level, m_levelViews[level - 1], vk::ImageLayout::eGeneral, m_levelViews[level]);
+    m_hasContent = false;
+}
+
+auto DepthPyramid::cleanup() -> void
+{
+    for (const auto it : m_levelViews)
+        m_vulkanDevice.m_logicalDevice.destroyImageView(it);
+    m_levelViews.clear();
+    if (m_imageView)
+    {
+        m_vulkanDevice.m_logicalDevice.destroyImageView(m_imageView);
+        m_imageView = nullptr;
+    }
+    if (m_image)
+    {
+        m_vulkanDevice.m_logicalDevice.destroyImage(m_image);
+        vmaFreeMemory(g_allocator, m_memory);
+        m_image = nullptr;
+        m_memory = nullptr;
+    }
+    m_hasContent = false;
+}
+
+auto DepthPyramid::build(vk::CommandBuffer commandBuffer) -> void
+{
+    vk::ImageMemoryBarrier barrier;
+    barrier.setImage(m_image)
+        .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED).setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+        .setSubresourceRange(vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, m_levelCount, 0, 1));
+
+    // The previous content was only read by culling, the old layout is eUndefined until the first build
+    barrier.setOldLayout(m_hasContent ? vk::ImageLayout::eGeneral : vk::ImageLayout::eUndefined).setNewLayout(vk::ImageLayout::eGeneral)
+        .setSrcAccessMask({}).setDstAccessMask(vk::AccessFlagBits::eShaderWrite);
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
+        {}, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_reducePipeline->getPipeline());
+    m_reduceLayout->bindDescriptorSet(commandBuffer, 0);
+    m_reduceLayout->setPushConstants(commandBuffer, { { m_sourceWidth, m_sourceHeight }, { m_width, m_height }, m_samples });
+    dispatch(commandBuffer, m_width, m_height);
+
+    barrier.setOldLayout(vk::ImageLayout::eGeneral).setNewLayout(vk::ImageLayout::eGeneral)
+        .setSrcAccessMask(vk::AccessFlagBits::eShaderWrite).setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_downsamplePipeline->getPipeline());
+    for (uint32_t level = 1; level < m_levelCount; ++level)
+    {
+        barrier.setSubresourceRange(vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, level - 1, 1, 0, 1));
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
+            {}, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        uint32_t width = std::max(m_width >> level, 1u);
+        uint32_t height = std::max(m_height >> level, 1u);
+        m_downsampleLayout->bindDescriptorSet(commandBuffer, level);
+        m_downsampleLayout->setPushConstants(commandBuffer,
+            { { std::max(m_width >> (level - 1), 1u), std::max(m_height >> (level - 1), 1u) }, { width, height }, 1 });
+        dispatch(commandBuffer, width, height);
+    }
+
+    barrier.setSubresourceRange(vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, m_levelCount - 1, 1, 0, 1));
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
+        {}, 0, nullptr, 0, nullptr, 1, &barrier);
+    m_hasContent = true;
+}
+
+auto DepthPyramid::dispatch(vk::CommandBuffer commandBuffer, uint32_t width, uint32_t height) -> void
+{
+    commandBuffer.dispatch((width + _groupSize - 1) / _groupSize, (height + _groupSize - 1) / _groupSize, 1);
+}
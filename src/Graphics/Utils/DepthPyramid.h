@@ -0,0 +1,69 @@
+#pragma once
+
+
+#include <Oblivion.h>
+
+#include "../Interfaces/IGraphicsObject.h"
+#include "../Pipeline/ComputePipeline.h"
+#include "../Pipeline/Layout/DepthPyramidLayout.h"
+#include "Image.h"
+
+/// <summary>
+///     Hierarchical Z buffer: a mip chain where every texel holds the farthest depth of the pixels it covers.
+///     Levels are powers of two, the first one no larger than the depth image, so a box is tested against at
+///     most 2x2 texels of the level matching its size on screen
+/// </summary>
+class DepthPyramid : public IVulkanDeviceObject
+{
+public:
+    DepthPyramid();
+    ~DepthPyramid();
+
+    DepthPyramid(const DepthPyramid&) = delete;
+    DepthPyramid& operator = (const DepthPyramid&) = delete;
+
+public:
+    /// <summary>
+    ///     Creates the levels for a depth attachment of width x height, sampled in eDepthStencilReadOnlyOptimal.
+    ///     samples must be in the device's sampledImageDepthSampleCounts
+    /// </summary>
+    auto                                create(const Image& depth, uint32_t width, uint32_t height, vk::SampleCountFlagBits samples) -> void;
+    auto                                cleanup() -> void;
+    /// <summary>
+    ///     Records the reduction of the depth attachment into every level, and makes them visible to compute shaders.
+    ///     !THE DEPTH WRITES MUST BE VISIBLE TO COMPUTE SHADERS
+    /// </summary>
+    auto                                build(vk::CommandBuffer commandBuffer) -> void;
+
+    // Every level, in eGeneral
+    auto                                getImageView() const -> vk::ImageView { return m_imageView; };
+    auto                                getWidth() const -> uint32_t { return m_width; };
+    auto                                getHeight() const -> uint32_t { return m_height; };
+    auto                                getLevelCount() const -> uint32_t { return m_levelCount; };
+    // False until the first build() after create(), the levels are undefined before it
+    auto                                hasContent() const -> bool { return m_hasContent; };
+
+private:
+    auto                                dispatch(vk::CommandBuffer commandBuffer, uint32_t width, uint32_t height) -> void;
+
+private:
+    std::unique_ptr<DepthPyramidLayout> m_reduceLayout;
+    std::unique_ptr<DepthPyramidLayout> m_downsampleLayout;
+    std::unique_ptr<ComputePipeline<DepthPyramidLayout>>
+                                        m_reducePipeline;
+    std::unique_ptr<ComputePipeline<DepthPyramidLayout>>
+                                        m_downsamplePipeline;
+
+    vk::Image                           m_image;
+    VmaAllocation                       m_memory = nullptr;
+    vk::ImageView                       m_imageView;
+    std::vector<vk::ImageView>          m_levelViews;
+
+    uint32_t                            m_sourceWidth = 0;
+    uint32_t                            m_sourceHeight = 0;
+    uint32_t                            m_samples = 1;
+    uint32_t                            m_width = 0;
+    uint32_t                            m_height = 0;
+    uint32_t                            m_levelCount = 0;
+    bool                                m_hasContent = false;
+};
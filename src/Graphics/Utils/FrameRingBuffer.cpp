@@ -0,0 +1,106 @@
+#include "FrameRingBuffer.h"
+
+#include "../VulkanRenderer.h"
+
+
+FrameRingBuffer::FrameRingBuffer(vk::BufferUsageFlags usage, vk::DeviceSize sliceSize) :
+    m_usage(usage)
+{
+    createBuffer(std::max(sliceSize, _minSliceSize));
+}
+
+FrameRingBuffer::~FrameRingBuffer()
+{
+    for (const auto& it : m_retiredBuffers)
+    {
+        m_vulkanDevice.m_logicalDevice.destroyBuffer(it.m_buffer);
+        vmaFreeMemory(g_allocator, it.m_memory);
+    }
+
+    if (m_buffer)
+    {
+        m_vulkanDevice.m_logicalDevice.destroyBuffer(m_buffer);
+        vmaFreeMemory(g_allocator, m_memory);
+    }
+}
+
+auto FrameRingBuffer::begin(vk::DeviceSize requiredSize) -> void
+{
+    releaseRetiredBuffers();
+
+    if (requiredSize > m_sliceSize)
+    {
+        // Frames still in flight keep reading the old buffer, it is released once they are done
+        m_retiredBuffers.push_back({ m_buffer, m_memory, VulkanRenderer::Get()->getFrameNumber() });
+
+        vk::DeviceSize sliceSize = m_sliceSize;
+        while (sliceSize < requiredSize)
+            sliceSize *= 2;
+        createBuffer(sliceSize);
+    }
+
+    m_sliceBegin = m_sliceSize * VulkanRenderer::Get()->getInFlightFrame();
+    m_sliceHead = m_sliceBegin;
+}
+
+auto FrameRingBuffer::allocate(vk::DeviceSize size, vk::DeviceSize alignment) -> Allocation
+{
+    vk::DeviceSize offset = (m_sliceHead + alignment - 1) / alignment * alignment;
+    if (offset + size > m_sliceBegin + m_sliceSize)
+    {
+        WARNING("FrameRingBuffer slice exhausted, call begin() with the size needed for the frame");
+        return {};
+    }
+
+    m_sliceHead = offset + size;
+    return { m_buffer, offset, m_mapped + offset };
+}
+
+auto FrameRingBuffer::flush() -> void
+{
+    if (!m_coherent && m_sliceHead > m_sliceBegin)
+    {
+        vmaFlushAllocation(g_allocator, m_memory, m_sliceBegin, m_sliceHead - m_sliceBegin);
+    }
+}
+
+auto FrameRingBuffer::createBuffer(vk::DeviceSize sliceSize) -> void
+{
+    uint32_t family = m_vulkanDevice.m_families.graphicsIndex;
+    vk::BufferCreateInfo bufferInfo = {};
+    bufferInfo.setPQueueFamilyIndices(&family).setQueueFamilyIndexCount(1)
+        .setSharingMode(vk::SharingMode::eExclusive)
+        .setUsage(m_usage).setSize(sliceSize * VulkanRenderer::getMaxInFlightFrames());
+
+    VmaAllocationCreateInfo allocationInfo = {};
+    allocationInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    allocationInfo.requiredFlags = (VkMemoryPropertyFlags)vk::MemoryPropertyFlagBits::eHostVisible;
+    allocationInfo.preferredFlags = (VkMemoryPropertyFlags)vk::MemoryPropertyFlagBits::eHostCoherent;
+
+    VmaAllocationInfo info = {};
+    VkResult res = vmaCreateBuffer(g_allocator, (VkBufferCreateInfo*)&bufferInfo, &allocationInfo,
+        (VkBuffer*)&m_buffer, &m_memory, &info);
+    EVALUATE(res, VkResult::VK_SUCCESS, != , "Couldn't create a valid ring buffer");
+
+    VkMemoryPropertyFlags memoryFlags;
+    vmaGetMemoryTypeProperties(g_allocator, info.memoryType, &memoryFlags);
+    m_coherent = (memoryFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+    m_mapped = static_cast<uint8_t*>(info.pMappedData);
+    m_sliceSize = sliceSize;
+}
+
+auto FrameRingBuffer::releaseRetiredBuffers() -> void
+{
+    // A buffer retired during frame N was last read by a frame submitted before N + the in-flight count
+    uint64_t frame = VulkanRenderer::Get()->getFrameNumber();
+    auto it = std::remove_if(m_retiredBuffers.begin(), m_retiredBuffers.end(), [&](const RetiredBuffer& retired)
+    {
+        if (frame < retired.m_frame + VulkanRenderer::getMaxInFlightFrames())
+            return false;
+
+        m_vulkanDevice.m_logicalDevice.destroyBuffer(retired.m_buffer);
+        vmaFreeMemory(g_allocator, retired.m_memory);
+        return true;
+    });
+    m_retiredBuffers.erase(it, m_retiredBuffers.end());
+}
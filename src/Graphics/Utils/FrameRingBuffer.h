@@ -0,0 +1,74 @@
+#pragma once
+
+
+#include <Oblivion.h>
+#include <vulkan/vulkan.hpp>
+#include <vk_mem_alloc.h>
+#include "../Interfaces/IGraphicsObject.h"
+
+
+/// <summary>
+///     Persistently mapped, host visible buffer split into one slice per in-flight frame.
+///     Every frame allocations are linearly sub-allocated from the slice of the current in-flight frame.
+///     When a slice is too small the whole buffer grows geometrically; the old buffer is kept alive
+///     until every frame that may still read it has completed, so growing never waits on the GPU.
+/// </summary>
+class FrameRingBuffer : public IVulkanDeviceObject
+{
+    static constexpr const vk::DeviceSize _minSliceSize = 64 * 1024;
+public:
+    struct Allocation
+    {
+        vk::Buffer                      m_buffer;
+        vk::DeviceSize                  m_offset = 0;
+        void*                           m_data = nullptr;
+    };
+
+public:
+    FrameRingBuffer(vk::BufferUsageFlags usage, vk::DeviceSize sliceSize = _minSliceSize);
+    ~FrameRingBuffer();
+
+    FrameRingBuffer(const FrameRingBuffer&) = delete;
+    FrameRingBuffer& operator = (const FrameRingBuffer&) = delete;
+
+public:
+    /// <summary>
+    ///     Starts sub-allocating from the slice of the current in-flight frame, growing it to at least requiredSize.
+    ///     !THE FENCE OF THE CURRENT IN-FLIGHT FRAME MUST HAVE BEEN WAITED ON
+    /// </summary>
+    auto                                begin(vk::DeviceSize requiredSize) -> void;
+    /// <summary>
+    ///     Returns size bytes from the current slice, or an allocation without a buffer if the slice is exhausted
+    /// </summary>
+    auto                                allocate(vk::DeviceSize size, vk::DeviceSize alignment) -> Allocation;
+    /// <summary>
+    ///     Makes the writes of the current slice visible to the device
+    /// </summary>
+    auto                                flush() -> void;
+
+    auto                                getSliceSize() const -> vk::DeviceSize { return m_sliceSize; };
+
+private:
+    auto                                createBuffer(vk::DeviceSize sliceSize) -> void;
+    auto                                releaseRetiredBuffers() -> void;
+
+private:
+    struct RetiredBuffer
+    {
+        vk::Buffer                      m_buffer;
+        VmaAllocation                   m_memory;
+        uint64_t                        m_frame;
+    };
+
+    vk::BufferUsageFlags                m_usage;
+    vk::Buffer                          m_buffer;
+    VmaAllocation                       m_memory = nullptr;
+    uint8_t*                            m_mapped = nullptr;
+    bool                                m_coherent = false;
+
+    vk::DeviceSize                      m_sliceSize = 0;
+    vk::DeviceSize                      m_sliceBegin = 0;
+    vk::DeviceSize                      m_sliceHead = 0;
+
+    std::vector<RetiredBuffer>          m_retiredBuffers;
+};
@@ -0,0 +1,298 @@
+#include "FrustumCulling.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_CULLING_SSE
+#include <emmintrin.h>
+#endif
+#if defined(__AVX__)
+#define FRUSTUM_CULLING_AVX
+#define FRUSTUM_CULLING_AVX_TARGET
+#include <immintrin.h>
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+// The build targets an older CPU: only the AVX kernels are compiled for AVX, and they are picked when the CPU has it
+#define FRUSTUM_CULLING_AVX
+#define FRUSTUM_CULLING_AVX_RUNTIME
+#define FRUSTUM_CULLING_AVX_TARGET __attribute__((target("avx")))
+#include <immintrin.h>
+#endif
+
+
+namespace
+{
+    // Planes broadcast once per batch, the absolute normal gives the box extent along the normal
+    struct PlaneSet
+    {
+        float   m_x[Frustum::ePlaneCount], m_y[Frustum::ePlaneCount], m_z[Frustum::ePlaneCount], m_w[Frustum::ePlaneCount];
+        float   m_absX[Frustum::ePlaneCount], m_absY[Frustum::ePlaneCount], m_absZ[Frustum::ePlaneCount];
+
+        PlaneSet(const Frustum& frustum)
+        {
+            for (uint32_t p = 0; p < Frustum::ePlaneCount; ++p)
+            {
+                const glm::vec4& plane = frustum.m_planes[p];
+                m_x[p] = plane.x; m_y[p] = plane.y; m_z[p] = plane.z; m_w[p] = plane.w;
+                m_absX[p] = std::abs(plane.x); m_absY[p] = std::abs(plane.y); m_absZ[p] = std::abs(plane.z);
+            }
+        }
+    };
+
+    auto boxVisible(const PlaneSet& planes, const FrustumCulling::BoxBounds& bounds, uint32_t i) -> bool
+    {
+        for (uint32_t p = 0; p < Frustum::ePlaneCount; ++p)
+        {
+            float distance = planes.m_x[p] * bounds.m_centerX[i] + planes.m_y[p] * bounds.m_centerY[i] +
+                planes.m_z[p] * bounds.m_centerZ[i] + planes.m_w[p];
+            float radius = planes.m_absX[p] * bounds.m_extentX[i] + planes.m_absY[p] * bounds.m_extentY[i] +
+                planes.m_absZ[p] * bounds.m_extentZ[i];
+            if (distance + radius < 0.0f)
+                return false;
+        }
+        return true;
+    }
+
+    auto sphereVisible(const PlaneSet& planes, const FrustumCulling::SphereBounds& bounds, uint32_t i) -> bool
+    {
+        for (uint32_t p = 0; p < Frustum::ePlaneCount; ++p)
+        {
+            float distance = planes.m_x[p] * bounds.m_centerX[i] + planes.m_y[p] * bounds.m_centerY[i] +
+                planes.m_z[p] * bounds.m_centerZ[i] + planes.m_w[p];
+            if (distance < -bounds.m_radius[i])
+                return false;
+        }
+        return true;
+    }
+
+    // Branchless compaction: every lane is written, only visible ones advance the output
+    auto appendVisible(uint32_t* visible, uint32_t count, uint32_t first, uint32_t mask, uint32_t lanes) -> uint32_t
+    {
+        for (uint32_t lane = 0; lane < lanes; ++lane)
+        {
+            visible[count] = first + lane;
+            count += (mask >> lane) & 1;
+        }
+        return count;
+    }
+
+    template <typename Visible>
+    auto cullTail(uint32_t begin, uint32_t end, uint32_t* visible, uint32_t count, Visible isVisible) -> uint32_t
+    {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            visible[count] = i;
+            count += isVisible(i) ? 1 : 0;
+        }
+        return count;
+    }
+
+#if defined(FRUSTUM_CULLING_SSE)
+    auto cullBoxesSSE(const PlaneSet& planes, const FrustumCulling::BoxBounds& bounds, uint32_t* visible) -> uint32_t
+    {
+        uint32_t total = bounds.size();
+        uint32_t count = 0;
+        uint32_t i = 0;
+        for (; i + 4 <= total; i += 4)
+        {
+            __m128 cx = _mm_loadu_ps(&bounds.m_centerX[i]), cy = _mm_loadu_ps(&bounds.m_centerY[i]), cz = _mm_loadu_ps(&bounds.m_centerZ[i]);
+            __m128 ex = _mm_loadu_ps(&bounds.m_extentX[i]), ey = _mm_loadu_ps(&bounds.m_extentY[i]), ez = _mm_loadu_ps(&bounds.m_extentZ[i]);
+            __m128 outside = _mm_setzero_ps();
+            for (uint32_t p = 0; p < Frustum::ePlaneCount; ++p)
+            {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.m_x[p]), cx),
+                    _mm_mul_ps(_mm_set1_ps(planes.m_y[p]), cy)), _mm_mul_ps(_mm_set1_ps(planes.m_z[p]), cz)), _mm_set1_ps(planes.m_w[p]));
+                __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.m_absX[p]), ex), _mm_mul_ps(_mm_set1_ps(planes.m_absY[p]), ey)),
+                    _mm_mul_ps(_mm_set1_ps(planes.m_absZ[p]), ez));
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+            }
+            count = appendVisible(visible, count, i, ~(uint32_t)_mm_movemask_ps(outside) & 0xf, 4);
+        }
+        return cullTail(i, total, visible, count, [&](uint32_t index) { return boxVisible(planes, bounds, index); });
+    }
+
+    auto cullSpheresSSE(const PlaneSet& planes, const FrustumCulling::SphereBounds& bounds, uint32_t* visible) -> uint32_t
+    {
+        uint32_t total = bounds.size();
+        uint32_t count = 0;
+        uint32_t i = 0;
+        for (; i + 4 <= total; i += 4)
+        {
+            __m128 cx = _mm_loadu_ps(&bounds.m_centerX[i]), cy = _mm_loadu_ps(&bounds.m_centerY[i]), cz = _mm_loadu_ps(&bounds.m_centerZ[i]);
+            __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&bounds.m_radius[i]));
+            __m128 outside = _mm_setzero_ps();
+            for (uint32_t p = 0; p < Frustum::ePlaneCount; ++p)
+            {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.m_x[p]), cx),
+                    _mm_mul_ps(_mm_set1_ps(planes.m_y[p]), cy)), _mm_mul_ps(_mm_set1_ps(planes.m_z[p]), cz)), _mm_set1_ps(planes.m_w[p]));
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeRadius));
+            }
+            count = appendVisible(visible, count, i, ~(uint32_t)_mm_movemask_ps(outside) & 0xf, 4);
+        }
+        return cullTail(i, total, visible, count, [&](uint32_t index) { return sphereVisible(planes, bounds, index); });
+    }
+#endif
+
+#if defined(FRUSTUM_CULLING_AVX)
+    auto isAVXSupported() -> bool
+    {
+#if defined(FRUSTUM_CULLING_AVX_RUNTIME)
+        static const bool supported = __builtin_cpu_supports("avx");
+        return supported;
+#else
+        return true;
+#endif
+    }
+
+    FRUSTUM_CULLING_AVX_TARGET auto cullBoxesAVX(const PlaneSet& planes, const FrustumCulling::BoxBounds& bounds, uint32_t* visible) -> uint32_t
+    {
+        uint32_t total = bounds.size();
+        uint32_t count = 0;
+        uint32_t i = 0;
+        for (; i + 8 <= total; i += 8)
+        {
+            __m256 cx = _mm256_loadu_ps(&bounds.m_centerX[i]), cy = _mm256_loadu_ps(&bounds.m_centerY[i]), cz = _mm256_loadu_ps(&bounds.m_centerZ[i]);
+            __m256 ex = _mm256_loadu_ps(&bounds.m_extentX[i]), ey = _mm256_loadu_ps(&bounds.m_extentY[i]), ez = _mm256_loadu_ps(&bounds.m_extentZ[i]);
+            __m256 outside = _mm256_setzero_ps();
+            for (uint32_t p = 0; p < Frustum::ePlaneCount; ++p)
+            {
+                __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.m_x[p]), cx),
+                    _mm256_mul_ps(_mm256_set1_ps(planes.m_y[p]), cy)), _mm256_mul_ps(_mm256_set1_ps(planes.m_z[p]), cz)), _mm256_set1_ps(planes.m_w[p]));
+                __m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.m_absX[p]), ex), _mm256_mul_ps(_mm256_set1_ps(planes.m_absY[p]), ey)),
+                    _mm256_mul_ps(_mm256_set1_ps(planes.m_absZ[p]), ez));
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_LT_OQ));
+            }
+            count = appendVisible(visible, count, i, ~(uint32_t)_mm256_movemask_ps(outside) & 0xff, 8);
+        }
+        return cullTail(i, total, visible, count, [&](uint32_t index) { return boxVisible(planes, bounds, index); });
+    }
+
+    FRUSTUM_CULLING_AVX_TARGET auto cullSpheresAVX(const PlaneSet& planes, const FrustumCulling::SphereBounds& bounds, uint32_t* visible) -> uint32_t
+    {
+        uint32_t total = bounds.size();
+        uint32_t count = 0;
+        uint32_t i = 0;
+        for (; i + 8 <= total; i += 8)
+        {
+            __m256 cx = _mm256_loadu_ps(&bounds.m_centerX[i]), cy = _mm256_loadu_ps(&bounds.m_centerY[i]), cz = _mm256_loadu_ps(&bounds.m_centerZ[i]);
+            __m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&bounds.m_radius[i]));
+            __m256 outside = _mm256_setzero_ps();
+            for (uint32_t p = 0; p < Frustum::ePlaneCount; ++p)
+            {
+                __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.m_x[p]), cx),
+                    _mm256_mul_ps(_mm256_set1_ps(planes.m_y[p]), cy)), _mm256_mul_ps(_mm256_set1_ps(planes.m_z[p]), cz)), _mm256_set1_ps(planes.m_w[p]));
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, negativeRadius, _CMP_LT_OQ));
+            }
+            count = appendVisible(visible, count, i, ~(uint32_t)_mm256_movemask_ps(outside) & 0xff, 8);
+        }
+        return cullTail(i, total, visible, count, [&](uint32_t index) { return sphereVisible(planes, bounds, index); });
+    }
+#endif
+}
+
+auto FrustumCulling::BoxBounds::resize(uint32_t count) -> void
+{
+    for (auto* it : { &m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ })
+        it->resize(count);
+}
+
+auto FrustumCulling::BoxBounds::set(uint32_t index, const glm::vec3& center, const glm::vec3& extent) -> void
+{
+    m_centerX[index] = center.x; m_centerY[index] = center.y; m_centerZ[index] = center.z;
+    m_extentX[index] = extent.x; m_extentY[index] = extent.y; m_extentZ[index] = extent.z;
+}
+
+auto FrustumCulling::BoxBounds::set(uint32_t index, const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::mat4& world) -> void
+{
+    // Arvo: the extent of a transformed box is the absolute matrix applied to the extent
+    glm::vec3 center = glm::vec3(world * glm::vec4((boundsMin + boundsMax) * 0.5f, 1.0f));
+    glm::vec3 extent = (boundsMax - boundsMin) * 0.5f;
+    glm::vec3 worldExtent = glm::abs(glm::vec3(world[0])) * extent.x + glm::abs(glm::vec3(world[1])) * extent.y +
+        glm::abs(glm::vec3(world[2])) * extent.z;
+    set(index, center, worldExtent);
+}
+
+auto FrustumCulling::SphereBounds::resize(uint32_t count) -> void
+{
+    for (auto* it : { &m_centerX, &m_centerY, &m_centerZ, &m_radius })
+        it->resize(count);
+}
+
+auto FrustumCulling::SphereBounds::set(uint32_t index, const glm::vec3& center, float radius) -> void
+{
+    m_centerX[index] = center.x; m_centerY[index] = center.y; m_centerZ[index] = center.z;
+    m_radius[index] = radius;
+}
+
+FrustumCulling::Kernel FrustumCulling::getBestKernel()
+{
+#if defined(FRUSTUM_CULLING_AVX)
+    if (isAVXSupported())
+        return Kernel::eAVX;
+#endif
+#if defined(FRUSTUM_CULLING_SSE)
+    return Kernel::eSSE;
+#else
+    return Kernel::eScalar;
+#endif
+}
+
+const char* FrustumCulling::getKernelName(Kernel kernel)
+{
+    switch (kernel)
+    {
+    case Kernel::eSSE: return "SSE";
+    case Kernel::eAVX: return "AVX";
+    default: return "Scalar";
+    }
+}
+
+bool FrustumCulling::isKernelAvailable(Kernel kernel)
+{
+    switch (kernel)
+    {
+#if defined(FRUSTUM_CULLING_SSE)
+    case Kernel::eSSE: return true;
+#endif
+#if defined(FRUSTUM_CULLING_AVX)
+    case Kernel::eAVX: return isAVXSupported();
+#endif
+    case Kernel::eScalar: return true;
+    default: return false;
+    }
+}
+
+uint32_t FrustumCulling::cullBoxes(const Frustum& frustum, const BoxBounds& bounds, uint32_t* visible, Kernel kernel)
+{
+    PlaneSet planes(frustum);
+    switch (kernel)
+    {
+#if defined(FRUSTUM_CULLING_AVX)
+    case Kernel::eAVX:
+        if (isAVXSupported())
+            return cullBoxesAVX(planes, bounds, visible);
+        [[fallthrough]];
+#endif
+#if defined(FRUSTUM_CULLING_SSE)
+    case Kernel::eSSE: return cullBoxesSSE(planes, bounds, visible);
+#endif
+    default:
+        return cullTail(0, bounds.size(), visible, 0, [&](uint32_t index) { return boxVisible(planes, bounds, index); });
+    }
+}
+
+uint32_t FrustumCulling::cullSpheres(const Frustum& frustum, const SphereBounds& bounds, uint32_t* visible, Kernel kernel)
+{
+    PlaneSet planes(frustum);
+    switch (kernel)
+    {
+#if defined(FRUSTUM_CULLING_AVX)
+    case Kernel::eAVX:
+        if (isAVXSupported())
+            return cullSpheresAVX(planes, bounds, visible);
+        [[fallthrough]];
+#endif
+#if defined(FRUSTUM_CULLING_SSE)
+    case Kernel::eSSE: return cullSpheresSSE(planes, bounds, visible);
+#endif
+    default:
+        return cullTail(0, bounds.size(), visible, 0, [&](uint32_t index) { return sphereVisible(planes, bounds, index); });
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Oblivion.h>
+#include <glm/glm.hpp>
+#include "../../Gameplay/Frustum.h"
+
+/// <summary>
+///     Batched frustum tests over structure of arrays bounds. The SIMD kernels test 4 (SSE) or 8 (AVX) bounds per
+///     iteration; with GCC and Clang the AVX one is always compiled and only used when the CPU supports AVX.
+///     Scenes cull on the GPU (GpuCulling), these only serve as the CPU reference of CullingBenchmark.
+/// </summary>
+namespace FrustumCulling
+{
+    // World space axis aligned boxes as center and half extent
+    struct BoxBounds
+    {
+        std::vector<float>  m_centerX, m_centerY, m_centerZ;
+        std::vector<float>  m_extentX, m_extentY, m_extentZ;
+
+        auto                resize(uint32_t count) -> void;
+        auto                size() const -> uint32_t { return (uint32_t)m_centerX.size(); };
+        auto                set(uint32_t index, const glm::vec3& center, const glm::vec3& extent) -> void;
+        /// <summary>
+        ///     Stores the world space box enclosing the object space box min..max transformed by world
+        /// </summary>
+        auto                set(uint32_t index, const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::mat4& world) -> void;
+    };
+
+    struct SphereBounds
+    {
+        std::vector<float>  m_centerX, m_centerY, m_centerZ;
+        std::vector<float>  m_radius;
+
+        auto                resize(uint32_t count) -> void;
+        auto                size() const -> uint32_t { return (uint32_t)m_centerX.size(); };
+        auto                set(uint32_t index, const glm::vec3& center, float radius) -> void;
+    };
+
+    enum class Kernel
+    {
+        eScalar,
+        eSSE,
+        eAVX
+    };
+
+    /// <summary>
+    ///     Best kernel compiled into this build that the CPU can run
+    /// </summary>
+    Kernel getBestKernel();
+    const char* getKernelName(Kernel kernel);
+    // Compiled into this build and supported by the CPU
+    bool isKernelAvailable(Kernel kernel);
+
+    /// <summary>
+    ///     Writes the indices of the bounds intersecting the frustum to visible, in ascending order, and returns
+    ///     their number. visible must hold bounds.size() entries. Conservative: boxes crossing two planes near a
+    ///     frustum corner may be reported visible.
+    /// </summary>
+    uint32_t cullBoxes(const Frustum& frustum, const BoxBounds& bounds, uint32_t* visible, Kernel kernel = getBestKernel());
+    uint32_t cullSpheres(const Frustum& frustum, const SphereBounds& bounds, uint32_t* visible, Kernel kernel = getBestKernel());
+}
@@ -0,0 +1,198 @@
+#include "GpuCulling.h"
+
+#include "VulkanAllocators.h"
+#include "../VulkanRenderer.h"
+
+
+GpuCulling::GpuCulling()
+{
+    m_layout = std::make_unique<CullingLayout>();
+    m_pipeline = std::make_unique<ComputePipeline<CullingLayout>>(m_layout.get());
+
+    m_frames.resize(VulkanRenderer::getMaxInFlightFrames());
+    for (auto& frame : m_frames)
+    {
+        frame.m_buffers[CullingLayout::eParameters] = BufferUtils::createMappedBuffer(vk::BufferUsageFlagBits::eUniformBuffer,
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, vk::MemoryPropertyFlags(),
+            &m_vulkanDevice.m_families.graphicsIndex, 1, sizeof(CullingParameters));
+        // Written by the CPU every frame and read back after the frame's fence, so kept host visible
+        frame.m_buffers[CullingLayout::eDrawCommands] = BufferUtils::createMappedBuffer(
+            vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer,
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, vk::MemoryPropertyFlags(),
+            &m_vulkanDevice.m_families.graphicsIndex, 1, sizeof(vk::DrawIndexedIndirectCommand) * _maxLods * ePhaseCount);
+    }
+}
+
+GpuCulling::~GpuCulling()
+{
+    for (auto& frame : m_frames)
+    {
+        for (auto& buffer : frame.m_buffers)
+            destroyBuffer(buffer);
+    }
+}
+
+auto GpuCulling::setDepthPyramid(const DepthPyramid* pyramid) -> void
+{
+    m_depthPyramid = pyramid;
+    m_layout->setDepthPyramid(pyramid->getImageView());
+}
+
+auto GpuCulling::mapInstances(uint32_t count) -> glm::mat4*
+{
+    auto inFlightFrame = VulkanRenderer::Get()->getInFlightFrame();
+    auto& frame = m_frames[inFlightFrame];
+    if (count > frame.m_capacity)
+        createInstanceBuffers(inFlightFrame, std::max(std::max(count, frame.m_capacity * 2), _minCapacity));
+    frame.m_instanceCount = count;
+    return static_cast<glm::mat4*>(frame.m_buffers[CullingLayout::eInstances].m_mapped);
+}
+
+auto GpuCulling::update(const Model& model, const glm::mat4& view, const glm::mat4& projection,
+    const Frustum& frustum, float pixelsPerUnit, float pixelError) -> void
+{
+    auto& frame = m_frames[VulkanRenderer::Get()->getInFlightFrame()];
+    auto commands = static_cast<vk::DrawIndexedIndirectCommand*>(frame.m_buffers[CullingLayout::eDrawCommands].m_mapped);
+    for (uint32_t phase = 0; phase < ePhaseCount; ++phase)
+    {
+        for (uint32_t lod = 0; lod < _maxLods; ++lod)
+            m_lodInstanceCounts[phase][lod] = lod < frame.m_lodCount ? commands[phase * _maxLods + lod].instanceCount : 0;
+    }
+
+    frame.m_lodCount = std::min(model.getLodCount(), _maxLods);
+    if (frame.m_visibleCapacity != frame.m_capacity || frame.m_visibleLodCount != frame.m_lodCount)
+        createVisibleBuffer(VulkanRenderer::Get()->getInFlightFrame());
+    if (frame.m_buffersChanged)
+    {
+        m_layout->setBuffers(VulkanRenderer::Get()->getInFlightFrame(), frame.m_buffers);
+        frame.m_buffersChanged = false;
+    }
+
+    CullingParameters parameters = {};
+    for (uint32_t lod = 0; lod < frame.m_lodCount; ++lod)
+    {
+        const auto& level = model.getLod(lod);
+        // Every level reads its instances from the start of its range, bound as the instance vertex buffer
+        for (uint32_t phase = 0; phase < ePhaseCount; ++phase)
+            commands[phase * _maxLods + lod] = vk::DrawIndexedIndirectCommand(level.m_indexCount, 0, level.m_indexOffset, 0, 0);
+        parameters.lodErrors[lod / 4][lod % 4] = level.m_error;
+    }
+
+    parameters.view = view;
+    parameters.viewProjection = projection * view;
+    for (uint32_t i = 0; i < Frustum::ePlaneCount; ++i)
+        parameters.planes[i] = frustum.m_planes[i];
+    parameters.boundsMin = glm::vec4(model.getBoundsMin(), 1.0f);
+    parameters.boundsMax = glm::vec4(model.getBoundsMax(), 1.0f);
+    parameters.instanceCount = frame.m_instanceCount;
+    parameters.lodCount = frame.m_lodCount;
+    parameters.lodCapacity = frame.m_visibleCapacity;
+    parameters.pixelsPerUnit = pixelsPerUnit;
+    parameters.pixelError = pixelError;
+    parameters.pyramidWidth = m_depthPyramid->getWidth();
+    parameters.pyramidHeight = m_depthPyramid->getHeight();
+    parameters.pyramidLevels = m_depthPyramid->getLevelCount();
+    parameters.pyramidValid = m_depthPyramid->hasContent() ? 1 : 0;
+
+    memcpy(frame.m_buffers[CullingLayout::eParameters].m_mapped, &parameters, sizeof(CullingParameters));
+}
+
+auto GpuCulling::dispatch(vk::CommandBuffer commandBuffer, Phase phase) -> void
+{
+    const auto& frame = m_frames[VulkanRenderer::Get()->getInFlightFrame()];
+    if (frame.m_instanceCount == 0)
+        return;
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline->getPipeline());
+    m_layout->bindDescriptorSets(commandBuffer);
+    m_layout->setPhase(commandBuffer, phase);
+    commandBuffer.dispatch((frame.m_instanceCount + _groupSize - 1) / _groupSize, 1, 1);
+
+    // The late phase reads the occluded flags, the host reads the counts back once the frame's fence is signaled
+    vk::MemoryBarrier barrier;
+    barrier.setSrcAccessMask(vk::AccessFlagBits::eShaderWrite)
+        .setDstAccessMask(vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eVertexAttributeRead |
+            vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eHostRead);
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+        vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput |
+            vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eHost,
+        {}, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+auto GpuCulling::draw(vk::CommandBuffer commandBuffer, uint32_t instanceBinding, Phase phase) -> void
+{
+    const auto& frame = m_frames[VulkanRenderer::Get()->getInFlightFrame()];
+    if (frame.m_instanceCount == 0)
+        return;
+
+    // One draw per level: firstInstance and multi draw indirect are optional features, vertex buffer offsets aren't
+    for (uint32_t lod = 0; lod < frame.m_lodCount; ++lod)
+    {
+        uint32_t command = phase * _maxLods + lod;
+        vk::DeviceSize offset = (vk::DeviceSize)(phase * frame.m_lodCount + lod) * frame.m_visibleCapacity * sizeof(uint32_t);
+        commandBuffer.bindVertexBuffers(instanceBinding, 1, &frame.m_buffers[CullingLayout::eVisibleInstances].m_buffer, &offset);
+        commandBuffer.drawIndexedIndirect(frame.m_buffers[CullingLayout::eDrawCommands].m_buffer,
+            command * sizeof(vk::DrawIndexedIndirectCommand), 1, sizeof(vk::DrawIndexedIndirectCommand));
+    }
+}
+
+auto GpuCulling::getInstanceBuffer() const -> vk::Buffer
+{
+    return m_frames[VulkanRenderer::Get()->getInFlightFrame()].m_buffers[CullingLayout::eInstances].m_buffer;
+}
+
+auto GpuCulling::getVisibleCount(Phase phase) const -> uint32_t
+{
+    uint32_t count = 0;
+    for (uint32_t lod = 0; lod < _maxLods; ++lod)
+        count += m_lodInstanceCounts[phase][lod];
+    return count;
+}
+
+auto GpuCulling::getLodInstanceCount(uint32_t lod) const -> uint32_t
+{
+    return lod < _maxLods ? m_lodInstanceCounts[eEarly][lod] + m_lodInstanceCounts[eLate][lod] : 0;
+}
+
+auto GpuCulling::createInstanceBuffers(uint32_t inFlightFrame, uint32_t capacity) -> void
+{
+    // Only this in-flight frame's buffers are replaced, the GPU is done with them
+    auto& frame = m_frames[inFlightFrame];
+    destroyBuffer(frame.m_buffers[CullingLayout::eInstances]);
+    destroyBuffer(frame.m_buffers[CullingLayout::eOccludedInstances]);
+
+    // Read by culling.comp and by the vertex shaders, through the indices it appends
+    frame.m_buffers[CullingLayout::eInstances] = BufferUtils::createMappedBuffer(vk::BufferUsageFlagBits::eStorageBuffer,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, vk::MemoryPropertyFlags(),
+        &m_vulkanDevice.m_families.graphicsIndex, 1, capacity * sizeof(glm::mat4));
+    frame.m_buffers[CullingLayout::eOccludedInstances] = BufferUtils::createBuffer(vk::BufferUsageFlagBits::eStorageBuffer,
+        vk::MemoryPropertyFlagBits::eDeviceLocal, vk::MemoryPropertyFlags(),
+        &m_vulkanDevice.m_families.graphicsIndex, 1, capacity * sizeof(uint32_t));
+    frame.m_capacity = capacity;
+    frame.m_buffersChanged = true;
+}
+
+auto GpuCulling::createVisibleBuffer(uint32_t inFlightFrame) -> void
+{
+    // One range of indices per level the model actually has and per phase, each as large as the instance count
+    auto& frame = m_frames[inFlightFrame];
+    destroyBuffer(frame.m_buffers[CullingLayout::eVisibleInstances]);
+
+    frame.m_buffers[CullingLayout::eVisibleInstances] = BufferUtils::createBuffer(
+        vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eVertexBuffer,
+        vk::MemoryPropertyFlagBits::eDeviceLocal, vk::MemoryPropertyFlags(),
+        &m_vulkanDevice.m_families.graphicsIndex, 1, (std::size_t)frame.m_capacity * frame.m_lodCount * ePhaseCount * sizeof(uint32_t));
+    frame.m_visibleCapacity = frame.m_capacity;
+    frame.m_visibleLodCount = frame.m_lodCount;
+    frame.m_buffersChanged = true;
+}
+
+auto GpuCulling::destroyBuffer(BufferUtils::Buffer& buffer) -> void
+{
+    if (buffer.m_buffer)
+    {
+        m_vulkanDevice.m_logicalDevice.destroyBuffer(buffer.m_buffer);
+        vmaFreeMemory(g_allocator, buffer.m_memory);
+        buffer = {};
+    }
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+
+#include <Oblivion.h>
+#include <glm/glm.hpp>
+
+#include "../Interfaces/IGraphicsObject.h"
+#include "../Pipeline/ComputePipeline.h"
+#include "../Pipeline/Layout/CullingLayout.h"
+#include "../Model.h"
+#include "DepthPyramid.h"
+#include "../../Gameplay/Frustum.h"
+
+/// <summary>
+///     Frustum and occlusion culls the copies of a model and picks their level of detail on the GPU. A compute shader
+///     appends the index of every visible copy to the range of its level and counts it in that level's
+///     VkDrawIndexedIndirectCommand, the draws then read the counts straight from the buffer. The CPU only writes
+///     the matrices and records one dispatch plus one indirect draw per level and phase, whatever the number of copies.
+///
+///     Occlusion takes two phases. The early one tests against last frame's depth pyramid and draws what passes,
+///     the pyramid is then rebuilt from that depth and the late phase draws the copies the early one got wrong.
+/// </summary>
+class GpuCulling : public IVulkanDeviceObject
+{
+    static constexpr const uint32_t _maxLods = Model::_maxLods;   // maxLods of culling.comp
+    static constexpr const uint32_t _groupSize = 64;       // local_size_x of culling.comp
+    static constexpr const uint32_t _minCapacity = 256;
+    static_assert(_maxLods <= 8, "culling.comp holds the level errors in two vec4");
+
+public:
+    enum Phase
+    {
+        eEarly,
+        eLate,
+        ePhaseCount
+    };
+
+private:
+    // std140, mirrored by culling.comp
+    struct CullingParameters
+    {
+        glm::mat4 view;
+        glm::mat4 viewProjection;
+        glm::vec4 planes[Frustum::ePlaneCount];
+        glm::vec4 boundsMin;
+        glm::vec4 boundsMax;
+        glm::vec4 lodErrors[(_maxLods + 3) / 4];
+        uint32_t instanceCount;
+        uint32_t lodCount;
+        uint32_t lodCapacity;           // Visible instances of a phase and level start at (phase * lodCount + level) * lodCapacity
+        float pixelsPerUnit;
+        float pixelError;
+        uint32_t pyramidWidth;
+        uint32_t pyramidHeight;
+        uint32_t pyramidLevels;
+        uint32_t pyramidValid;
+    };
+
+public:
+    GpuCulling();
+    ~GpuCulling();
+
+    GpuCulling(const GpuCulling&) = delete;
+    GpuCulling& operator = (const GpuCulling&) = delete;
+
+public:
+    /// <summary>
+    ///     Tests occlusion against pyramid, called again whenever it's recreated.
+    ///     !THE DEVICE MUST BE IDLE
+    /// </summary>
+    auto                                setDepthPyramid(const DepthPyramid* pyramid) -> void;
+    /// <summary>
+    ///     Returns room for the world matrices of count instances, written until update() is called.
+    ///     !THE FENCE OF THE CURRENT IN-FLIGHT FRAME MUST HAVE BEEN WAITED ON
+    /// </summary>
+    auto                                mapInstances(uint32_t count) -> glm::mat4*;
+    /// <summary>
+    ///     Writes the parameters and the empty draw commands of the current in-flight frame. The counts the GPU
+    ///     wrote the last time this in-flight frame ran are read back first
+    /// </summary>
+    auto                                update(const Model& model, const glm::mat4& view, const glm::mat4& projection,
+                                            const Frustum& frustum, float pixelsPerUnit, float pixelError = 1.0f) -> void;
+    /// <summary>
+    ///     Records the culling dispatch of a phase and the barrier making its results visible to the draws.
+    ///     The late phase must follow a build of the pyramid.
+    ///     !MUST BE RECORDED OUTSIDE OF A RENDER PASS
+    /// </summary>
+    auto                                dispatch(vk::CommandBuffer commandBuffer, Phase phase) -> void;
+    /// <summary>
+    ///     Records one indirect draw per level of detail, the model's vertex and index buffers must be bound
+    /// </summary>
+    auto                                draw(vk::CommandBuffer commandBuffer, uint32_t instanceBinding, Phase phase) -> void;
+    /// <summary>
+    ///     World matrices of the current in-flight frame, indexed by the visible instances the draws bind.
+    ///     Replaced when mapInstances grows it
+    /// </summary>
+    auto                                getInstanceBuffer() const -> vk::Buffer;
+
+    // Read back from the GPU, so they lag getMaxInFlightFrames() frames behind
+    auto                                getVisibleCount() const -> uint32_t { return getVisibleCount(eEarly) + getVisibleCount(eLate); };
+    auto                                getVisibleCount(Phase phase) const -> uint32_t;
+    auto                                getLodInstanceCount(uint32_t lod) const -> uint32_t;
+
+private:
+    auto                                createInstanceBuffers(uint32_t inFlightFrame, uint32_t capacity) -> void;
+    auto                                createVisibleBuffer(uint32_t inFlightFrame) -> void;
+    auto                                destroyBuffer(BufferUtils::Buffer& buffer) -> void;
+
+private:
+    struct Frame
+    {
+        BufferUtils::Buffer             m_buffers[CullingLayout::_bufferCount];
+        uint32_t                        m_capacity = 0;
+        uint32_t                        m_instanceCount = 0;
+        uint32_t                        m_lodCount = 0;
+        uint32_t                        m_visibleCapacity = 0;  // In instances per level and phase
+        uint32_t                        m_visibleLodCount = 0;
+        bool                            m_buffersChanged = false;
+    };
+
+    std::unique_ptr<CullingLayout>      m_layout;
+    std::unique_ptr<ComputePipeline<CullingLayout>>
+                                        m_pipeline;
+    std::vector<Frame>                  m_frames;
+    const DepthPyramid*                 m_depthPyramid = nullptr;
+
+    uint32_t                            m_lodInstanceCounts[ePhaseCount][_maxLods] = {};
+};
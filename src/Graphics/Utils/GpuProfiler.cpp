@@ -0,0 +1,162 @@
+#include "GpuProfiler.h"
+
+#include "../VulkanRenderer.h"
+
+
+GpuProfiler::Scope::Scope(vk::CommandBuffer commandBuffer, const char* name) :
+    m_commandBuffer(commandBuffer)
+{
+    m_scope = GpuProfiler::Get()->beginScope(commandBuffer, name);
+}
+
+GpuProfiler::Scope::~Scope()
+{
+    GpuProfiler::Get()->endScope(m_commandBuffer, m_scope);
+}
+
+GpuProfiler::GpuProfiler()
+{
+    auto limits = m_vulkanDevice.m_physicalDevice.getProperties().limits;
+    auto queueFamilies = m_vulkanDevice.m_physicalDevice.getQueueFamilyProperties();
+    m_supported = limits.timestampComputeAndGraphics ||
+        queueFamilies[m_vulkanDevice.m_families.graphicsIndex].timestampValidBits != 0;
+    m_timestampPeriod = limits.timestampPeriod;
+    if (!m_supported)
+    {
+        WARNING("Timestamp queries are not supported on the graphics queue, GpuProfiler is disabled");
+        return;
+    }
+
+    m_frames.resize(VulkanRenderer::getMaxInFlightFrames());
+    vk::CommandPoolCreateInfo poolInfo = {};
+    poolInfo.setQueueFamilyIndex(m_vulkanDevice.m_families.graphicsIndex);
+    m_commandPool = m_vulkanDevice.m_logicalDevice.createCommandPool(poolInfo);
+    EVALUATE(m_commandPool, nullptr, == , "Couldn't create a command pool for GpuProfiler");
+
+    vk::CommandBufferAllocateInfo allocationInfo = {};
+    allocationInfo.setCommandPool(m_commandPool).setLevel(vk::CommandBufferLevel::ePrimary)
+        .setCommandBufferCount(2 * (uint32_t)m_frames.size());
+    auto commandBuffers = m_vulkanDevice.m_logicalDevice.allocateCommandBuffers(allocationInfo);
+    EVALUATE(commandBuffers.size(), 0, == , "Couldn't allocate command buffers for GpuProfiler");
+
+    vk::QueryPoolCreateInfo queryPoolInfo = {};
+    queryPoolInfo.setQueryType(vk::QueryType::eTimestamp).setQueryCount(_frameQuery + 2);
+    for (uint32_t i = 0; i < m_frames.size(); ++i)
+    {
+        auto& frame = m_frames[i];
+        frame.m_queryPool = m_vulkanDevice.m_logicalDevice.createQueryPool(queryPoolInfo);
+        EVALUATE(frame.m_queryPool, nullptr, == , "Couldn't create a query pool for GpuProfiler");
+        frame.m_scopes.reserve(_maxScopes);
+
+        // Resubmitted every time this in-flight frame's fence has been waited on
+        frame.m_frameBegin = commandBuffers[2 * i + 0];
+        frame.m_frameBegin.begin(vk::CommandBufferBeginInfo());
+        frame.m_frameBegin.resetQueryPool(frame.m_queryPool, _frameQuery, 2);
+        frame.m_frameBegin.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, frame.m_queryPool, _frameQuery);
+        frame.m_frameBegin.end();
+
+        frame.m_frameEnd = commandBuffers[2 * i + 1];
+        frame.m_frameEnd.begin(vk::CommandBufferBeginInfo());
+        frame.m_frameEnd.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, frame.m_queryPool, _frameQuery + 1);
+        frame.m_frameEnd.end();
+    }
+}
+
+GpuProfiler::~GpuProfiler()
+{
+    for (auto& frame : m_frames)
+    {
+        if (frame.m_queryPool)
+        {
+            m_vulkanDevice.m_logicalDevice.destroyQueryPool(frame.m_queryPool);
+            frame.m_queryPool = nullptr;
+        }
+    }
+    if (m_commandPool)
+        m_vulkanDevice.m_logicalDevice.destroyCommandPool(m_commandPool);
+}
+
+auto GpuProfiler::beginFrame(vk::CommandBuffer commandBuffer) -> void
+{
+    if (!m_supported)
+        return;
+
+    m_recordingFrame = &m_frames[VulkanRenderer::Get()->getInFlightFrame()];
+    m_recordingFrame->m_scopes.clear();
+    m_recordingFrame->m_queryCount = 0;
+    m_recordingFrame->m_frame = VulkanRenderer::Get()->getFrameNumber() + 1;
+    m_depth = 0;
+
+    commandBuffer.resetQueryPool(m_recordingFrame->m_queryPool, 0, 2 * _maxScopes);
+}
+
+auto GpuProfiler::frameScope(std::vector<vk::CommandBuffer>& commandBuffers, uint64_t frame) -> void
+{
+    if (!m_supported)
+        return;
+
+    auto& queries = m_frames[VulkanRenderer::Get()->getInFlightFrame()];
+    commandBuffers.insert(commandBuffers.begin(), queries.m_frameBegin);
+    commandBuffers.push_back(queries.m_frameEnd);
+    queries.m_submittedFrame = frame;
+}
+
+auto GpuProfiler::collect(uint32_t inFlightFrame) -> void
+{
+    if (!m_supported)
+        return;
+
+    auto& frame = m_frames[inFlightFrame];
+    if (frame.m_submittedFrame != 0)
+    {
+        std::array<uint64_t, 2> timestamps;
+        auto res = m_vulkanDevice.m_logicalDevice.getQueryPoolResults(frame.m_queryPool, _frameQuery, 2,
+            sizeof(timestamps), timestamps.data(), sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+        if (res == vk::Result::eSuccess)
+            m_frameResult = FrameResult{ frame.m_submittedFrame, (double)(timestamps[1] - timestamps[0]) * m_timestampPeriod / 1e6 };
+        frame.m_submittedFrame = 0;
+    }
+
+    if (frame.m_queryCount == 0)
+        return;
+
+    std::array<uint64_t, 2 * _maxScopes> timestamps;
+    auto res = m_vulkanDevice.m_logicalDevice.getQueryPoolResults(frame.m_queryPool, 0, frame.m_queryCount,
+        frame.m_queryCount * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+    if (res == vk::Result::eSuccess)
+    {
+        m_results.clear();
+        for (const auto& scope : frame.m_scopes)
+        {
+            double milliseconds = (double)(timestamps[scope.m_endQuery] - timestamps[scope.m_beginQuery]) *
+                m_timestampPeriod / 1e6;
+            m_results.push_back({ scope.m_name, scope.m_depth, milliseconds });
+        }
+        m_resultsFrame = frame.m_frame;
+    }
+    frame.m_queryCount = 0;
+    frame.m_scopes.clear();
+}
+
+auto GpuProfiler::beginScope(vk::CommandBuffer commandBuffer, const char* name) -> uint32_t
+{
+    // Leave room for this scope's end query and for the ones of every scope still open
+    if (!m_supported || !m_recordingFrame || m_recordingFrame->m_queryCount + m_depth + 2 > 2 * _maxScopes)
+        return ~0u;
+
+    ScopeRecord record = { name, m_depth++, m_recordingFrame->m_queryCount++, 0 };
+    commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, m_recordingFrame->m_queryPool, record.m_beginQuery);
+    m_recordingFrame->m_scopes.push_back(record);
+    return (uint32_t)m_recordingFrame->m_scopes.size() - 1;
+}
+
+auto GpuProfiler::endScope(vk::CommandBuffer commandBuffer, uint32_t scope) -> void
+{
+    if (scope == ~0u)
+        return;
+
+    auto& record = m_recordingFrame->m_scopes[scope];
+    record.m_endQuery = m_recordingFrame->m_queryCount++;
+    commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, m_recordingFrame->m_queryPool, record.m_endQuery);
+    m_depth--;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+
+#include <Oblivion.h>
+#include <vulkan/vulkan.hpp>
+#include "../Interfaces/IGraphicsObject.h"
+
+#include <optional>
+
+
+class GpuProfiler : public ISingletone<GpuProfiler>, public IVulkanDeviceObject
+{
+    static constexpr const uint32_t _maxScopes = 64;
+    static constexpr const uint32_t _frameQuery = 2 * _maxScopes;   // Begin and end of the frame scope follow the scopes'
+public:
+    struct ScopeResult
+    {
+        std::string                     m_name;
+        uint32_t                        m_depth;
+        double                          m_milliseconds;
+    };
+
+    struct FrameResult
+    {
+        uint64_t                        m_frame;
+        double                          m_milliseconds;
+    };
+
+    /// <summary>
+    ///     Writes a timestamp when created and one when destroyed, into the query pool of the current in-flight frame
+    /// </summary>
+    class Scope
+    {
+    public:
+        Scope(vk::CommandBuffer commandBuffer, const char* name);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator = (const Scope&) = delete;
+
+    private:
+        vk::CommandBuffer               m_commandBuffer;
+        uint32_t                        m_scope;
+    };
+
+public:
+    GpuProfiler();
+    ~GpuProfiler();
+
+public:
+    /// <summary>
+    ///     Resets the queries of the current in-flight frame. Must be recorded outside of a render pass,
+    ///     before any scope of that frame.
+    /// </summary>
+    auto                                beginFrame(vk::CommandBuffer commandBuffer) -> void;
+    /// <summary>
+    ///     Wraps the command buffers of the current in-flight frame's submission in the frame scope, timing all of
+    ///     them from the first command to the last. frame is the number the submission is reported under
+    /// </summary>
+    auto                                frameScope(std::vector<vk::CommandBuffer>& commandBuffers, uint64_t frame) -> void;
+
+    /// <summary>
+    ///     Reads back the queries last written for inFlightFrame, the frame scope included.
+    ///     !THE FENCE OF THAT FRAME MUST HAVE BEEN WAITED ON
+    /// </summary>
+    auto                                collect(uint32_t inFlightFrame) -> void;
+
+    auto                                getResults() const -> const std::vector<ScopeResult>& { return m_results; };
+    auto                                getResultsFrame() const -> uint64_t { return m_resultsFrame; };
+    // Of the last frame scope collected
+    auto                                getFrameResult() const -> const std::optional<FrameResult>& { return m_frameResult; };
+    auto                                isSupported() const -> bool { return m_supported; };
+
+private:
+    auto                                beginScope(vk::CommandBuffer commandBuffer, const char* name) -> uint32_t;
+    auto                                endScope(vk::CommandBuffer commandBuffer, uint32_t scope) -> void;
+
+private:
+    struct ScopeRecord
+    {
+        const char*                     m_name;
+        uint32_t                        m_depth;
+        uint32_t                        m_beginQuery;
+        uint32_t                        m_endQuery;
+    };
+
+    struct FrameQueries
+    {
+        vk::QueryPool                   m_queryPool;
+        std::vector<ScopeRecord>        m_scopes;
+        uint32_t                        m_queryCount = 0;
+        uint64_t                        m_frame = 0;
+        // Recorded once, they only touch this frame's frame scope queries
+        vk::CommandBuffer               m_frameBegin;
+        vk::CommandBuffer               m_frameEnd;
+        uint64_t                        m_submittedFrame = 0;   // 0 while no frame scope waits to be collected
+    };
+
+private:
+    bool                                m_supported = false;
+    float                               m_timestampPeriod = 1.0f;
+
+    vk::CommandPool                     m_commandPool;
+    std::vector<FrameQueries>           m_frames;
+    FrameQueries*                       m_recordingFrame = nullptr;
+    uint32_t                            m_depth = 0;
+
+    std::vector<ScopeResult>            m_results;
+    uint64_t                            m_resultsFrame = 0;
+    std::optional<FrameResult>          m_frameResult;
+};
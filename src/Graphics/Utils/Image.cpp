@@ -5,6 +5,7 @@
 #include "BufferUtils.h"
 #include "VulkanAllocators.h"
 #include "OneTimeCommandBuffers.h"
+#include "UploadManager.h"
 
 Image::Image(const char * path, vk::ImageUsageFlags usage,
     vk::MemoryPropertyFlags requiredMemory, vk::MemoryPropertyFlags preferredMemory)
@@ -34,6 +35,14 @@ Image::Image(unsigned char* source,
         preferredMemory, layout, samples, mipLevels);
 }
 
+Image::Image(ImageData& data, vk::ImageUsageFlags usage,
+    vk::MemoryPropertyFlags requiredMemory, vk::MemoryPropertyFlags preferredMemory)
+{
+    createFromMemory(data.m_pixels.data(), data.m_pixels.size(), data.m_width, data.m_height, vk::Format::eR8G8B8A8Unorm,
+        usage, requiredMemory, preferredMemory, vk::ImageLayout::eShaderReadOnlyOptimal,
+        vk::SampleCountFlagBits::e1, data.m_mipLevels);
+}
+
 Image::~Image()
 {
     m_vulkanDevice.m_logicalDevice.destroyImageView(m_imageView);
@@ -41,26 +50,31 @@ Image::~Image()
     m_vulkanDevice.m_logicalDevice.destroyImage(m_image);
 }
 
-auto Image::createFromPath(const char * path, vk::ImageUsageFlags usage,
-    vk::MemoryPropertyFlags requiredMemory, vk::MemoryPropertyFlags preferredMemory) -> void
+auto Image::decode(const char* path) -> ImageData
 {
     int width, height, texChannels;
     stbi_uc* result;
     result = stbi_load(path, &width, &height, &texChannels, STBI_rgb_alpha);
     EVALUATE(result, nullptr, == , "Couldn't load texture %s", path);
 
-    uint32_t mipLevels = (uint32_t)std::floor(std::log2(std::max(width, height))) + 1;
+    ImageData data;
+    data.m_width = width;
+    data.m_height = height;
+    data.m_mipLevels = (uint32_t)std::floor(std::log2(std::max(width, height))) + 1;
+    data.m_pixels.assign(result, result + (size_t)width * height * 4);
 
-    size_t imageSize = width * height * 4;
-    m_width = width;
-    m_height = height;
-    m_mipLevels = mipLevels;
+    stbi_image_free(result);
+    return data;
+}
 
-    createFromMemory(result, imageSize, width, height, vk::Format::eR8G8B8A8Unorm,
-        usage, requiredMemory, preferredMemory, vk::ImageLayout::eShaderReadOnlyOptimal,
-        vk::SampleCountFlagBits::e1, mipLevels);
+auto Image::createFromPath(const char * path, vk::ImageUsageFlags usage,
+    vk::MemoryPropertyFlags requiredMemory, vk::MemoryPropertyFlags preferredMemory) -> void
+{
+    auto data = decode(path);
 
-    stbi_image_free(result);
+    createFromMemory(data.m_pixels.data(), data.m_pixels.size(), data.m_width, data.m_height, vk::Format::eR8G8B8A8Unorm,
+        usage, requiredMemory, preferredMemory, vk::ImageLayout::eShaderReadOnlyOptimal,
+        vk::SampleCountFlagBits::e1, data.m_mipLevels);
 }
 
 auto Image::createImage(uint32_t width, uint32_t height,
@@ -76,7 +90,7 @@ auto Image::createImage(uint32_t width, uint32_t height,
     {
         m_imageAspectFlag |= vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
     }
-    if ((usage & vk::ImageUsageFlagBits::eColorAttachment) ||
+    else if ((usage & vk::ImageUsageFlagBits::eColorAttachment) ||
         (usage & vk::ImageUsageFlagBits::eSampled))
     {
         m_imageAspectFlag |= vk::ImageAspectFlagBits::eColor;
@@ -120,103 +134,97 @@ auto Image::createFromMemory(unsigned char* source,
 {
     usage |= vk::ImageUsageFlagBits::eTransferDst; // We will copy into this image
 
-    BufferUtils::Buffer temporaryBuffer;
-    temporaryBuffer = BufferUtils::createBuffer(vk::BufferUsageFlagBits::eTransferSrc,
-        vk::MemoryPropertyFlagBits::eHostCoherent | vk::MemoryPropertyFlagBits::eHostVisible, {},
-        &m_vulkanDevice.m_families.graphicsIndex, 1, imageSize);
-
-
-    void* pData;
-    vmaMapMemory(g_allocator, temporaryBuffer.m_memory, &pData);
-    memcpy(pData, source, imageSize);
-    vmaUnmapMemory(g_allocator, temporaryBuffer.m_memory);
-
-
     createImage(width, height, format, usage,
         requiredMemory, preferredMemory, samples, mipLevels);
 
-    // Make image a suitable transfer dst
-    vk::ImageSubresourceRange range;
-    range = m_subresourceRange;
-    imageBarrier(range, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
-        m_vulkanDevice.m_families.graphicsIndex, m_vulkanDevice.m_families.graphicsIndex);
-
-    // Copy to image
-    auto commandBuffers = OneTimeCommandBuffers::Get()->allocCommandBuffers();
-    auto commandBuffer = commandBuffers[0];
-
-    vk::ImageSubresourceLayers subresource;
-    subresource.setLayerCount(1).setBaseArrayLayer(0)
-        .setMipLevel(0).setAspectMask(m_imageAspectFlag);
-    vk::BufferImageCopy region;
-    region.setBufferImageHeight(0).setBufferRowLength(0)
-        .setBufferOffset(0).setImageExtent(m_imageInfo.extent)
-        .setImageSubresource(subresource);
-
-    commandBuffer.copyBufferToImage(temporaryBuffer.m_buffer,
-        m_image, vk::ImageLayout::eTransferDstOptimal, 1, &region);
-
-    OneTimeCommandBuffers::Get()->executeCommandBufers(commandBuffers, m_vulkanDevice.m_queues.graphicsQueue);
-    OneTimeCommandBuffers::Get()->freeCommandBuffers(commandBuffers);
-
-    if (m_mipLevels > 1)
-    { // Generate mipmaps
-        uint32_t mipWidth = width;
-        uint32_t mipHeight = height;
-        auto mipmapCommandBuffers = OneTimeCommandBuffers::Get()->allocCommandBuffers();
-        commandBuffer = mipmapCommandBuffers[0];
-        vk::ImageSubresourceRange texSubresource;
-        texSubresource.setAspectMask(m_imageAspectFlag)
-            .setBaseArrayLayer(0).setLayerCount(1)
-            .setLevelCount(1);
-        for (uint32_t i = 1; i < m_mipLevels; ++i)
+    // Copies and layout transitions are recorded into the upload manager's batch, they are
+    // visible to every frame submitted afterwards
+    UploadManager::Get()->upload(source, imageSize, [&](const UploadManager::Commands& commands)
+    {
+        // Make image a suitable transfer dst. Its contents are undefined, so the transfer queue can use it without an ownership transfer
+        vk::ImageSubresourceRange range;
+        range = m_subresourceRange;
+        imageBarrier(range, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+            VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, commands.m_transfer);
+
+        // Copy to image
+        vk::ImageSubresourceLayers subresource;
+        subresource.setLayerCount(1).setBaseArrayLayer(0)
+            .setMipLevel(0).setAspectMask(m_imageAspectFlag);
+        vk::BufferImageCopy region;
+        region.setBufferImageHeight(0).setBufferRowLength(0)
+            .setBufferOffset(commands.m_offset).setImageExtent(m_imageInfo.extent)
+            .setImageSubresource(subresource);
+
+        commands.m_transfer.copyBufferToImage(commands.m_staging,
+            m_image, vk::ImageLayout::eTransferDstOptimal, 1, &region);
+
+        // Mipmaps are blitted on the graphics queue, the image goes there still as a transfer dst
+        bool sameFamily = commands.m_transferFamily == commands.m_graphicsFamily;
+        vk::ImageLayout copiedLayout = m_mipLevels > 1 ? vk::ImageLayout::eTransferDstOptimal : layout;
+        if (!sameFamily)
         {
-            texSubresource.setBaseMipLevel(i - 1);
-            imageBarrier(texSubresource, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferSrcOptimal,
-                m_vulkanDevice.m_families.graphicsIndex, m_vulkanDevice.m_families.graphicsIndex, commandBuffer);
-
-            vk::ImageSubresourceLayers srcLayers, dstLayers;
-            srcLayers.setAspectMask(vk::ImageAspectFlagBits::eColor)
-                .setBaseArrayLayer(0).setLayerCount(1).setMipLevel(i - 1);
-            dstLayers.setAspectMask(vk::ImageAspectFlagBits::eColor)
-                .setBaseArrayLayer(0).setLayerCount(1).setMipLevel(i);
-
-            uint32_t newMipWidth = mipWidth > 1 ? mipWidth / 2 : 1;
-            uint32_t newMipHeight = mipHeight > 1 ? mipHeight / 2 : 1;
-            vk::ImageBlit blit;
-            blit.setSrcSubresource(srcLayers).setDstSubresource(dstLayers)
-                .setSrcOffsets({ vk::Offset3D(0,0,0), vk::Offset3D(mipWidth,mipHeight,1) })
-                .setDstOffsets({ vk::Offset3D(0,0,0), vk::Offset3D(newMipWidth,newMipHeight,1) });
-
-            commandBuffer.blitImage(m_image, vk::ImageLayout::eTransferSrcOptimal,
-                m_image, vk::ImageLayout::eTransferDstOptimal, 1, &blit,
-                vk::Filter::eLinear);
+            releaseOwnership(commands.m_transfer, vk::ImageLayout::eTransferDstOptimal, copiedLayout,
+                commands.m_transferFamily, commands.m_graphicsFamily,
+                vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite);
+            acquireOwnership(commands.m_graphics, vk::ImageLayout::eTransferDstOptimal, copiedLayout,
+                commands.m_transferFamily, commands.m_graphicsFamily,
+                vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eFragmentShader,
+                vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite | vk::AccessFlagBits::eShaderRead);
+        }
 
-            imageBarrier(texSubresource, vk::ImageLayout::eTransferSrcOptimal, layout,
+        vk::CommandBuffer commandBuffer = commands.m_graphics;
+        if (m_mipLevels > 1)
+        { // Generate mipmaps
+            uint32_t mipWidth = width;
+            uint32_t mipHeight = height;
+            vk::ImageSubresourceRange texSubresource;
+            texSubresource.setAspectMask(m_imageAspectFlag)
+                .setBaseArrayLayer(0).setLayerCount(1)
+                .setLevelCount(1);
+            for (uint32_t i = 1; i < m_mipLevels; ++i)
+            {
+                texSubresource.setBaseMipLevel(i - 1);
+                imageBarrier(texSubresource, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferSrcOptimal,
+                    m_vulkanDevice.m_families.graphicsIndex, m_vulkanDevice.m_families.graphicsIndex, commandBuffer);
+
+                vk::ImageSubresourceLayers srcLayers, dstLayers;
+                srcLayers.setAspectMask(vk::ImageAspectFlagBits::eColor)
+                    .setBaseArrayLayer(0).setLayerCount(1).setMipLevel(i - 1);
+                dstLayers.setAspectMask(vk::ImageAspectFlagBits::eColor)
+                    .setBaseArrayLayer(0).setLayerCount(1).setMipLevel(i);
+
+                uint32_t newMipWidth = mipWidth > 1 ? mipWidth / 2 : 1;
+                uint32_t newMipHeight = mipHeight > 1 ? mipHeight / 2 : 1;
+                vk::ImageBlit blit;
+                blit.setSrcSubresource(srcLayers).setDstSubresource(dstLayers)
+                    .setSrcOffsets({ vk::Offset3D(0,0,0), vk::Offset3D(mipWidth,mipHeight,1) })
+                    .setDstOffsets({ vk::Offset3D(0,0,0), vk::Offset3D(newMipWidth,newMipHeight,1) });
+
+                commandBuffer.blitImage(m_image, vk::ImageLayout::eTransferSrcOptimal,
+                    m_image, vk::ImageLayout::eTransferDstOptimal, 1, &blit,
+                    vk::Filter::eLinear);
+
+                imageBarrier(texSubresource, vk::ImageLayout::eTransferSrcOptimal, layout,
+                    m_vulkanDevice.m_families.graphicsIndex, m_vulkanDevice.m_families.graphicsIndex, commandBuffer);
+
+                if (newMipWidth > 1)
+                    mipWidth = newMipWidth;
+                if (newMipHeight > 1)
+                    mipHeight = newMipHeight;
+
+            }
+
+            texSubresource.setBaseMipLevel(mipLevels - 1);
+            imageBarrier(texSubresource, vk::ImageLayout::eTransferDstOptimal, layout,
                 m_vulkanDevice.m_families.graphicsIndex, m_vulkanDevice.m_families.graphicsIndex, commandBuffer);
-
-            if (newMipWidth > 1)
-                mipWidth = newMipWidth;
-            if (newMipHeight > 1)
-                mipHeight = newMipHeight;
-
         }
-
-        texSubresource.setBaseMipLevel(mipLevels - 1);
-        imageBarrier(texSubresource, vk::ImageLayout::eTransferDstOptimal, layout,
-            m_vulkanDevice.m_families.graphicsIndex, m_vulkanDevice.m_families.graphicsIndex, commandBuffer);
-
-        OneTimeCommandBuffers::Get()->executeCommandBufers(mipmapCommandBuffers, m_vulkanDevice.m_queues.graphicsQueue);
-        OneTimeCommandBuffers::Get()->freeCommandBuffers(mipmapCommandBuffers);
-    }
-    else
-    {
-        imageBarrier(range, vk::ImageLayout::eTransferDstOptimal, layout,
-            m_vulkanDevice.m_families.graphicsIndex, m_vulkanDevice.m_families.graphicsIndex);
-    }
-
-    vmaFreeMemory(g_allocator, temporaryBuffer.m_memory);
-    m_vulkanDevice.m_logicalDevice.destroyBuffer(temporaryBuffer.m_buffer);
+        else if (sameFamily)
+        {
+            imageBarrier(range, vk::ImageLayout::eTransferDstOptimal, layout,
+                m_vulkanDevice.m_families.graphicsIndex, m_vulkanDevice.m_families.graphicsIndex, commandBuffer);
+        }
+    });
 
     createImageView(vk::ImageViewType::e2D);
 }
@@ -322,3 +330,29 @@ auto Image::imageBarrier(vk::ImageSubresourceRange range, vk::ImageLayout oldLay
         OneTimeCommandBuffers::Get()->freeCommandBuffers(commandBuffers);
     }
 }
+
+auto Image::releaseOwnership(vk::CommandBuffer commandBuffer, vk::ImageLayout oldLayout, vk::ImageLayout newLayout,
+    uint32_t srcFamily, uint32_t dstFamily, vk::PipelineStageFlags srcStage, vk::AccessFlags srcAccess) -> void
+{
+    vk::ImageMemoryBarrier barrier;
+    barrier.setImage(m_image)
+        .setSrcQueueFamilyIndex(srcFamily).setDstQueueFamilyIndex(dstFamily)
+        .setOldLayout(oldLayout).setNewLayout(newLayout)
+        .setSrcAccessMask(srcAccess).setDstAccessMask({})
+        .setSubresourceRange(m_subresourceRange);
+    commandBuffer.pipelineBarrier(srcStage, vk::PipelineStageFlagBits::eBottomOfPipe,
+        {}, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+auto Image::acquireOwnership(vk::CommandBuffer commandBuffer, vk::ImageLayout oldLayout, vk::ImageLayout newLayout,
+    uint32_t srcFamily, uint32_t dstFamily, vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess) -> void
+{
+    vk::ImageMemoryBarrier barrier;
+    barrier.setImage(m_image)
+        .setSrcQueueFamilyIndex(srcFamily).setDstQueueFamilyIndex(dstFamily)
+        .setOldLayout(oldLayout).setNewLayout(newLayout)
+        .setSrcAccessMask({}).setDstAccessMask(dstAccess)
+        .setSubresourceRange(m_subresourceRange);
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, dstStage,
+        {}, 0, nullptr, 0, nullptr, 1, &barrier);
+}
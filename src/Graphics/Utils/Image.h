@@ -7,6 +7,15 @@
 
 class Image : public IVulkanDeviceObject
 {
+public:
+    struct ImageData
+    { // Decoded RGBA8 pixels
+        std::vector<unsigned char>  m_pixels;
+        uint32_t                    m_width;
+        uint32_t                    m_height;
+        uint32_t                    m_mipLevels;
+    };
+
 public:
 
     Image(const char* path, vk::ImageUsageFlags usage,
@@ -21,10 +30,30 @@ public:
         vk::MemoryPropertyFlags requiredMemory, vk::MemoryPropertyFlags preferredMemory,
         vk::ImageLayout layout,
         vk::SampleCountFlagBits samples = vk::SampleCountFlagBits::e1, uint32_t mipLevels = 1);
+    Image(ImageData& data, vk::ImageUsageFlags usage,
+        vk::MemoryPropertyFlags requiredMemory, vk::MemoryPropertyFlags preferredMemory);
     ~Image();
 
+    /// <summary>
+    ///     Decodes the image at path. Touches no Vulkan object, so it can run on any thread
+    /// </summary>
+    static auto                 decode(const char* path) -> ImageData;
+
 public:
     auto                        getImageView() const -> vk::ImageView { return m_imageView; }
+    auto                        getImage() const -> vk::Image { return m_image; }
+
+    /// <summary>
+    ///     Records the release half of a queue family ownership transfer (and layout change), on a command buffer of srcFamily
+    /// </summary>
+    auto                        releaseOwnership(vk::CommandBuffer commandBuffer, vk::ImageLayout oldLayout, vk::ImageLayout newLayout,
+        uint32_t srcFamily, uint32_t dstFamily, vk::PipelineStageFlags srcStage, vk::AccessFlags srcAccess) -> void;
+    /// <summary>
+    ///     Records the acquire half of a queue family ownership transfer, on a command buffer of dstFamily.
+    ///     The layouts must match the release. !MUST BE SUBMITTED AFTER THE RELEASE
+    /// </summary>
+    auto                        acquireOwnership(vk::CommandBuffer commandBuffer, vk::ImageLayout oldLayout, vk::ImageLayout newLayout,
+        uint32_t srcFamily, uint32_t dstFamily, vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess) -> void;
 
 private:
     auto                        createFromPath(const char* path, vk::ImageUsageFlags usage,
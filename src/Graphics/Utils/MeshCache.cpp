@@ -0,0 +1,148 @@
+#include "MeshCache.h"
+
+#include <filesystem>
+#include <fstream>
+
+
+namespace
+{
+    constexpr uint32_t _magic = 0x434D4F58; // "XOMC"
+    constexpr uint32_t _version = 3; // 2: streams are stored optimized, 3: level of detail table
+    constexpr uint64_t _streamAlignment = 16;
+
+    struct Header
+    {
+        uint32_t    m_magic;
+        uint32_t    m_version;
+        uint32_t    m_vertexStride;
+        uint32_t    m_vertexCount;
+        uint32_t    m_indexCount;
+        uint32_t    m_lodCount;
+        uint64_t    m_sourceSize;   // The cache is stale as soon as either of these changes
+        int64_t     m_sourceTime;
+        float       m_boundsMin[3];
+        float       m_boundsMax[3];
+        uint64_t    m_vertexOffset;
+        uint64_t    m_indexOffset;
+        uint64_t    m_lodOffset;
+    };
+    static_assert(sizeof(Model::Lod) == 3 * sizeof(uint32_t), "The level of detail table is stored as is");
+
+    auto alignUp(uint64_t value, uint64_t alignment) -> uint64_t
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    auto getSourceStamp(const std::string& sourcePath, uint64_t& size, int64_t& time) -> bool
+    {
+        std::error_code error;
+        size = (uint64_t)std::filesystem::file_size(sourcePath, error);
+        if (error)
+            return false;
+        time = (int64_t)std::filesystem::last_write_time(sourcePath, error).time_since_epoch().count();
+        return !error;
+    }
+}
+
+auto MeshCache::getCachePath(const std::string& sourcePath) -> std::string
+{
+    return sourcePath + ".meshcache";
+}
+
+bool MeshCache::read(const std::string& sourcePath, const std::string& cachePath, Model::MeshData& mesh)
+{
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    if (!getSourceStamp(sourcePath, sourceSize, sourceTime))
+        return false;
+
+    auto file = std::make_unique<MappedFile>(cachePath);
+    if (!file->isOpen() || file->getSize() < sizeof(Header))
+        return false;
+
+    Header header;
+    memcpy(&header, file->getData(), sizeof(Header));
+    if (header.m_magic != _magic || header.m_version != _version ||
+        header.m_vertexStride != PositionColorVertex::getVertexSize() ||
+        header.m_sourceSize != sourceSize || header.m_sourceTime != sourceTime)
+        return false;
+
+    uint64_t vertexBytes = (uint64_t)header.m_vertexCount * header.m_vertexStride;
+    uint64_t indexBytes = (uint64_t)header.m_indexCount * sizeof(uint32_t);
+    uint64_t lodBytes = (uint64_t)header.m_lodCount * sizeof(Model::Lod);
+    if (header.m_vertexOffset % _streamAlignment != 0 || header.m_indexOffset % sizeof(uint32_t) != 0 ||
+        header.m_vertexOffset < sizeof(Header) || header.m_vertexOffset + vertexBytes > header.m_indexOffset ||
+        header.m_indexOffset + indexBytes > header.m_lodOffset || header.m_lodOffset + lodBytes > file->getSize())
+    {
+        WARNING(appendToString("Ignoring malformed mesh cache ", cachePath));
+        return false;
+    }
+
+    std::vector<Model::Lod> lods(header.m_lodCount);
+    memcpy(lods.data(), file->getData() + header.m_lodOffset, lodBytes);
+    for (const auto& lod : lods)
+    {
+        if ((uint64_t)lod.m_indexOffset + lod.m_indexCount > header.m_indexCount)
+        {
+            WARNING(appendToString("Ignoring malformed mesh cache ", cachePath));
+            return false;
+        }
+    }
+    mesh.m_boundsMin = glm::vec3(header.m_boundsMin[0], header.m_boundsMin[1], header.m_boundsMin[2]);
+    mesh.m_boundsMax = glm::vec3(header.m_boundsMax[0], header.m_boundsMax[1], header.m_boundsMax[2]);
+    mesh.m_mappedVertices = reinterpret_cast<const PositionColorVertex*>(file->getData() + header.m_vertexOffset);
+    mesh.m_mappedIndices = reinterpret_cast<const uint32_t*>(file->getData() + header.m_indexOffset);
+    mesh.m_mappedVertexCount = header.m_vertexCount;
+    mesh.m_mappedIndexCount = header.m_indexCount;
+    mesh.m_lods = std::move(lods);
+    mesh.m_mappedFile = std::move(file);
+    return true;
+}
+
+bool MeshCache::write(const std::string& sourcePath, const std::string& cachePath, const Model::MeshData& mesh)
+{
+    Header header = {};
+    if (!getSourceStamp(sourcePath, header.m_sourceSize, header.m_sourceTime))
+        return false;
+
+    header.m_magic = _magic;
+    header.m_version = _version;
+    header.m_vertexStride = PositionColorVertex::getVertexSize();
+    header.m_vertexCount = mesh.getVertexCount();
+    header.m_indexCount = mesh.getIndexCount();
+    header.m_lodCount = (uint32_t)mesh.m_lods.size();
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        header.m_boundsMin[i] = mesh.m_boundsMin[i];
+        header.m_boundsMax[i] = mesh.m_boundsMax[i];
+    }
+    header.m_vertexOffset = alignUp(sizeof(Header), _streamAlignment);
+    header.m_indexOffset = alignUp(header.m_vertexOffset + (uint64_t)header.m_vertexCount * header.m_vertexStride, _streamAlignment);
+    header.m_lodOffset = alignUp(header.m_indexOffset + (uint64_t)header.m_indexCount * sizeof(uint32_t), _streamAlignment);
+
+    // Written aside and renamed, so a reader never maps a half written cache
+    std::string tempPath = cachePath + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+
+        const char zeros[_streamAlignment] = {};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        file.write(zeros, header.m_vertexOffset - sizeof(Header));
+        file.write(reinterpret_cast<const char*>(mesh.getVertexData()), (uint64_t)header.m_vertexCount * header.m_vertexStride);
+        file.write(zeros, header.m_indexOffset - header.m_vertexOffset - (uint64_t)header.m_vertexCount * header.m_vertexStride);
+        file.write(reinterpret_cast<const char*>(mesh.getIndexData()), (uint64_t)header.m_indexCount * sizeof(uint32_t));
+        file.write(zeros, header.m_lodOffset - header.m_indexOffset - (uint64_t)header.m_indexCount * sizeof(uint32_t));
+        file.write(reinterpret_cast<const char*>(mesh.m_lods.data()), (uint64_t)header.m_lodCount * sizeof(Model::Lod));
+        if (!file)
+            return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, cachePath, error);
+    if (!error)
+        return true;
+    std::filesystem::remove(tempPath, error);
+    return false;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <Oblivion.h>
+#include "../Model.h"
+
+/// <summary>
+///     Binary cache of parsed meshes, laid out so the vertex and index streams can be uploaded
+///     straight from a memory mapping of the file
+/// </summary>
+namespace MeshCache
+{
+    auto getCachePath(const std::string& sourcePath) -> std::string;
+
+    /// <summary>
+    ///     Maps cachePath into mesh. Fails if the cache is missing, malformed or older than sourcePath
+    /// </summary>
+    bool read(const std::string& sourcePath, const std::string& cachePath, Model::MeshData& mesh);
+    bool write(const std::string& sourcePath, const std::string& cachePath, const Model::MeshData& mesh);
+}
@@ -0,0 +1,289 @@
+#include "MeshOptimizer.h"
+
+#include "../../Core/CpuProfiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace
+{
+    constexpr uint32_t _cacheSize = 32;             // Modelled LRU size, larger than any real FIFO on purpose
+    constexpr uint32_t _fifoSize = 16;              // Boundary detection, matches the ACMR default
+    constexpr uint32_t _invalid = ~0u;
+
+    auto vertexScore(int32_t cachePosition, uint32_t liveTriangles) -> float
+    {
+        if (liveTriangles == 0)
+            return -1.0f;
+
+        float score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            // The last triangle's vertices get a fixed score so it isn't simply repeated
+            if (cachePosition < 3)
+                score = 0.75f;
+            else
+                score = std::pow(1.0f - (cachePosition - 3) / float(_cacheSize - 3), 1.5f);
+        }
+        // Favour vertices with few triangles left, to finish them off
+        return score + 2.0f / std::sqrt((float)liveTriangles);
+    }
+}
+
+float MeshOptimizer::computeACMR(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+{
+    if (indices.empty())
+        return 0.0f;
+
+    // Timestamps instead of a queue: a vertex is cached while fewer than cacheSize misses happened since its own
+    std::vector<uint32_t> missTime(vertexCount, 0);
+    uint32_t misses = 0;
+    for (uint32_t index : indices)
+    {
+        if (missTime[index] == 0 || misses - missTime[index] >= cacheSize)
+            missTime[index] = ++misses;
+    }
+    return misses / float(indices.size() / 3);
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount)
+{
+    CPU_PROFILE_ZONE("MeshOptimizer::optimizeVertexCache");
+    uint32_t triangleCount = (uint32_t)indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    // Triangles of every vertex, packed. liveTriangles is the not yet emitted prefix of each range
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (uint32_t index : indices)
+        ++liveTriangles[index];
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (uint32_t i = 0; i < vertexCount; ++i)
+        adjacencyOffsets[i + 1] = adjacencyOffsets[i] + liveTriangles[i];
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (uint32_t i = 0; i < indices.size(); ++i)
+            adjacency[fill[indices[i]]++] = i / 3;
+    }
+
+    std::vector<int32_t> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; ++i)
+        vertexScores[i] = vertexScore(-1, liveTriangles[i]);
+
+    std::vector<float> triangleScores(triangleCount);
+    for (uint32_t i = 0; i < triangleCount; ++i)
+        triangleScores[i] = vertexScores[indices[i * 3]] + vertexScores[indices[i * 3 + 1]] + vertexScores[indices[i * 3 + 2]];
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    std::vector<uint32_t> cache, nextCache;
+    cache.reserve(_cacheSize + 3);
+    nextCache.reserve(_cacheSize + 3);
+
+    uint32_t bestTriangle = 0;
+    uint32_t scanCursor = 0;
+    for (uint32_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+    {
+        if (bestTriangle == _invalid)
+        {
+            // Nothing left around the cache, restart from the next triangle in input order
+            while (emitted[scanCursor])
+                ++scanCursor;
+            bestTriangle = scanCursor;
+        }
+
+        const uint32_t* triangle = &indices[bestTriangle * 3];
+        emitted[bestTriangle] = true;
+        output.insert(output.end(), triangle, triangle + 3);
+
+        nextCache.clear();
+        for (uint32_t k = 0; k < 3; ++k)
+        {
+            if (std::find(nextCache.begin(), nextCache.end(), triangle[k]) == nextCache.end())
+                nextCache.push_back(triangle[k]);
+        }
+        for (uint32_t k = 0; k < 3; ++k)
+        {
+            uint32_t vertex = triangle[k];
+            uint32_t* begin = &adjacency[adjacencyOffsets[vertex]];
+            uint32_t* end = begin + liveTriangles[vertex];
+            std::swap(*std::find(begin, end, bestTriangle), *(end - 1));
+            --liveTriangles[vertex];
+        }
+        for (uint32_t vertex : cache)
+        {
+            if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+                nextCache.push_back(vertex);
+        }
+        cache.swap(nextCache);
+
+        // Rescore everything the cache touched and pick the best live triangle around it
+        bestTriangle = _invalid;
+        float bestScore = -1.0f;
+        for (uint32_t i = 0; i < cache.size(); ++i)
+        {
+            uint32_t vertex = cache[i];
+            cachePositions[vertex] = i < _cacheSize ? (int32_t)i : -1;
+            float score = vertexScore(cachePositions[vertex], liveTriangles[vertex]);
+            float delta = score - vertexScores[vertex];
+            vertexScores[vertex] = score;
+
+            const uint32_t* adjacent = &adjacency[adjacencyOffsets[vertex]];
+            for (uint32_t j = 0; j < liveTriangles[vertex]; ++j)
+                triangleScores[adjacent[j]] += delta;
+        }
+        for (uint32_t i = 0; i < cache.size() && i < _cacheSize; ++i)
+        {
+            uint32_t vertex = cache[i];
+            const uint32_t* adjacent = &adjacency[adjacencyOffsets[vertex]];
+            for (uint32_t j = 0; j < liveTriangles[vertex]; ++j)
+            {
+                if (triangleScores[adjacent[j]] > bestScore)
+                {
+                    bestScore = triangleScores[adjacent[j]];
+                    bestTriangle = adjacent[j];
+                }
+            }
+        }
+        if (cache.size() > _cacheSize)
+            cache.resize(_cacheSize);
+    }
+
+    indices.swap(output);
+}
+
+uint32_t MeshOptimizer::optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<PositionColorVertex>& vertices, float threshold)
+{
+    CPU_PROFILE_ZONE("MeshOptimizer::optimizeOverdraw");
+    uint32_t triangleCount = (uint32_t)indices.size() / 3;
+    if (triangleCount == 0)
+        return 0;
+
+    // Clusters start cold once reordered. A cluster is cut as soon as its own ACMR, simulated from an empty cache,
+    // is within threshold of the whole list, so the reordering costs at most that much vertex reuse.
+    // A triangle missing on all its vertices starts a new cluster anyway.
+    float targetACMR = computeACMR(indices, (uint32_t)vertices.size(), _fifoSize) * threshold;
+    std::vector<uint32_t> clusterStarts;
+    {
+        std::vector<uint32_t> missTime(vertices.size(), 0);
+        uint32_t misses = 0;
+        uint32_t clusterMisses = 0;
+        uint32_t clusterStart = 0;
+        for (uint32_t i = 0; i < triangleCount; ++i)
+        {
+            uint32_t triangleMisses = 0;
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                uint32_t index = indices[i * 3 + k];
+                if (missTime[index] <= clusterMisses || misses - missTime[index] >= _fifoSize)
+                {
+                    missTime[index] = ++misses;
+                    ++triangleMisses;
+                }
+            }
+            if (i == 0 || triangleMisses == 3)
+            {
+                clusterStarts.push_back(i);
+                clusterStart = i;
+                clusterMisses = misses - triangleMisses;
+            }
+            if (misses - clusterMisses <= targetACMR * (i + 1 - clusterStart) && i + 1 < triangleCount)
+            {
+                clusterStarts.push_back(i + 1);
+                clusterStart = i + 1;
+                clusterMisses = misses;
+            }
+        }
+        clusterStarts.push_back(triangleCount);
+    }
+    uint32_t clusterCount = (uint32_t)clusterStarts.size() - 1;
+
+    struct Cluster
+    {
+        glm::vec3   m_centroid = glm::vec3(0.0f);
+        glm::vec3   m_normal = glm::vec3(0.0f);     // Area weighted
+        float       m_sortKey = 0.0f;
+        uint32_t    m_begin = 0;
+        uint32_t    m_end = 0;
+    };
+    std::vector<Cluster> clusters(clusterCount);
+
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (uint32_t c = 0; c < clusterCount; ++c)
+    {
+        Cluster& cluster = clusters[c];
+        cluster.m_begin = clusterStarts[c];
+        cluster.m_end = clusterStarts[c + 1];
+
+        float clusterArea = 0.0f;
+        for (uint32_t i = cluster.m_begin; i < cluster.m_end; ++i)
+        {
+            glm::vec3 a(vertices[indices[i * 3 + 0]].position);
+            glm::vec3 b(vertices[indices[i * 3 + 1]].position);
+            glm::vec3 d(vertices[indices[i * 3 + 2]].position);
+            glm::vec3 normal = glm::cross(b - a, d - a);
+            float area = glm::length(normal);
+            cluster.m_normal += normal;
+            cluster.m_centroid += (a + b + d) * (area / 3.0f);
+            clusterArea += area;
+        }
+        meshCentroid += cluster.m_centroid;
+        meshArea += clusterArea;
+        if (clusterArea > 0.0f)
+            cluster.m_centroid /= clusterArea;
+    }
+    if (meshArea > 0.0f)
+        meshCentroid /= meshArea;
+
+    // Clusters facing away from the centre are the likely occluders, draw them first
+    for (auto& cluster : clusters)
+    {
+        float length = glm::length(cluster.m_normal);
+        cluster.m_sortKey = length > 0.0f ? glm::dot(cluster.m_centroid - meshCentroid, cluster.m_normal / length) : 0.0f;
+    }
+    std::stable_sort(clusters.begin(), clusters.end(),
+        [](const Cluster& a, const Cluster& b) { return a.m_sortKey > b.m_sortKey; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for (const auto& cluster : clusters)
+        output.insert(output.end(), indices.begin() + cluster.m_begin * 3, indices.begin() + cluster.m_end * 3);
+    indices.swap(output);
+    return clusterCount;
+}
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<PositionColorVertex>& vertices, std::vector<uint32_t>& indices)
+{
+    CPU_PROFILE_ZONE("MeshOptimizer::optimizeVertexFetch");
+    std::vector<uint32_t> remap(vertices.size(), _invalid);
+    std::vector<PositionColorVertex> output;
+    output.reserve(vertices.size());
+    for (uint32_t& index : indices)
+    {
+        if (remap[index] == _invalid)
+        {
+            remap[index] = (uint32_t)output.size();
+            output.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(output);
+}
+
+MeshOptimizer::Stats MeshOptimizer::optimize(std::vector<PositionColorVertex>& vertices, std::vector<uint32_t>& indices, float overdrawThreshold)
+{
+    Stats stats;
+    stats.m_acmrBefore = computeACMR(indices, (uint32_t)vertices.size());
+    optimizeVertexCache(indices, (uint32_t)vertices.size());
+    if (overdrawThreshold > 0.0f)
+        stats.m_clusters = optimizeOverdraw(indices, vertices, overdrawThreshold);
+    optimizeVertexFetch(vertices, indices);
+    stats.m_acmrAfter = computeACMR(indices, (uint32_t)vertices.size());
+    return stats;
+}
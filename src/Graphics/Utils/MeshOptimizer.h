@@ -0,0 +1,42 @@
+#pragma once
+
+#include <Oblivion.h>
+#include "../Vertex/PositionColorVertex.h"
+
+/// <summary>
+///     Reorders indexed triangle lists for the GPU: post transform cache reuse, overdraw and vertex fetch locality.
+///     Only the order of triangles and vertices changes, never the rendered surface.
+/// </summary>
+namespace MeshOptimizer
+{
+    struct Stats
+    {
+        float           m_acmrBefore = 0.0f;    // Average cache miss ratio, vertex shader invocations per triangle
+        float           m_acmrAfter = 0.0f;
+        uint32_t        m_clusters = 0;
+    };
+
+    /// <summary>
+    ///     Simulates a FIFO post transform cache of cacheSize entries
+    /// </summary>
+    float computeACMR(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = 16);
+
+    /// <summary>
+    ///     Greedy triangle reordering driven by an LRU cache model (Forsyth, "Linear-Speed Vertex Cache Optimisation")
+    /// </summary>
+    void optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+    /// <summary>
+    ///     Splits a cache optimized list into clusters and draws the outward facing ones first.
+    ///     threshold bounds the ACMR increase, 1.05 allows 5%. Returns the number of clusters
+    /// </summary>
+    uint32_t optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<PositionColorVertex>& vertices, float threshold = 1.05f);
+    /// <summary>
+    ///     Renumbers vertices in order of first use, drops unreferenced ones and remaps the indices
+    /// </summary>
+    void optimizeVertexFetch(std::vector<PositionColorVertex>& vertices, std::vector<uint32_t>& indices);
+
+    /// <summary>
+    ///     Runs every pass above in order, the overdraw pass is skipped with a threshold of 0
+    /// </summary>
+    Stats optimize(std::vector<PositionColorVertex>& vertices, std::vector<uint32_t>& indices, float overdrawThreshold = 1.05f);
+}
@@ -0,0 +1,262 @@
+#include "MeshSimplifier.h"
+
+#include "../../Core/CpuProfiler.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+
+namespace
+{
+    // Symmetric 4x4 matrix, the area weighted sum of squared distances to a set of planes
+    struct Quadric
+    {
+        double  m_a00 = 0.0, m_a01 = 0.0, m_a02 = 0.0, m_a03 = 0.0;
+        double  m_a11 = 0.0, m_a12 = 0.0, m_a13 = 0.0;
+        double  m_a22 = 0.0, m_a23 = 0.0;
+        double  m_a33 = 0.0;
+        double  m_weight = 0.0;
+
+        auto addPlane(const glm::vec3& normal, double distance, double weight) -> void
+        {
+            double a = normal.x, b = normal.y, c = normal.z, d = distance;
+            m_a00 += weight * a * a; m_a01 += weight * a * b; m_a02 += weight * a * c; m_a03 += weight * a * d;
+            m_a11 += weight * b * b; m_a12 += weight * b * c; m_a13 += weight * b * d;
+            m_a22 += weight * c * c; m_a23 += weight * c * d;
+            m_a33 += weight * d * d;
+            m_weight += weight;
+        }
+
+        auto operator += (const Quadric& rhs) -> Quadric&
+        {
+            m_a00 += rhs.m_a00; m_a01 += rhs.m_a01; m_a02 += rhs.m_a02; m_a03 += rhs.m_a03;
+            m_a11 += rhs.m_a11; m_a12 += rhs.m_a12; m_a13 += rhs.m_a13;
+            m_a22 += rhs.m_a22; m_a23 += rhs.m_a23;
+            m_a33 += rhs.m_a33;
+            m_weight += rhs.m_weight;
+            return *this;
+        }
+
+        // Mean squared distance to the planes
+        auto evaluate(const glm::vec3& p) const -> double
+        {
+            if (m_weight <= 0.0)
+                return 0.0;
+            double x = p.x, y = p.y, z = p.z;
+            double result = m_a00 * x * x + 2.0 * m_a01 * x * y + 2.0 * m_a02 * x * z + 2.0 * m_a03 * x +
+                m_a11 * y * y + 2.0 * m_a12 * y * z + 2.0 * m_a13 * y +
+                m_a22 * z * z + 2.0 * m_a23 * z +
+                m_a33;
+            return std::max(result, 0.0) / m_weight;
+        }
+    };
+
+    struct Collapse
+    {
+        uint32_t    m_from;
+        uint32_t    m_to;
+        double      m_error;
+    };
+
+    auto triangleNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) -> glm::vec3
+    {
+        return glm::cross(b - a, c - a);
+    }
+}
+
+std::vector<uint32_t> MeshSimplifier::simplify(const std::vector<uint32_t>& indices,
+    const PositionColorVertex* vertices, uint32_t vertexCount,
+    uint32_t targetIndexCount, float targetError, float* resultError)
+{
+    CPU_PROFILE_ZONE("MeshSimplifier::simplify");
+    std::vector<uint32_t> result = indices;
+    if (resultError)
+        *resultError = 0.0f;
+    if (vertexCount == 0 || result.size() <= targetIndexCount)
+        return result;
+
+    // Work in a unit box, so the quadrics stay well conditioned whatever the mesh scale
+    glm::vec3 boundsMin(vertices[0].position), boundsMax(vertices[0].position);
+    for (uint32_t i = 1; i < vertexCount; ++i)
+    {
+        boundsMin = glm::min(boundsMin, glm::vec3(vertices[i].position));
+        boundsMax = glm::max(boundsMax, glm::vec3(vertices[i].position));
+    }
+    glm::vec3 extent = boundsMax - boundsMin;
+    float scale = std::max(std::max(extent.x, extent.y), extent.z);
+    if (scale <= 0.0f)
+        return result;
+
+    std::vector<glm::vec3> positions(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; ++i)
+        positions[i] = (glm::vec3(vertices[i].position) - boundsMin) / scale;
+
+    // Lock vertices sharing their position with another vertex (UV seams) and vertices on open edges
+    std::vector<bool> locked(vertexCount, false);
+    {
+        std::vector<uint32_t> order(vertexCount);
+        for (uint32_t i = 0; i < vertexCount; ++i)
+            order[i] = i;
+        auto less = [&](uint32_t a, uint32_t b)
+        {
+            const glm::vec3& pa = positions[a];
+            const glm::vec3& pb = positions[b];
+            return pa.x != pb.x ? pa.x < pb.x : pa.y != pb.y ? pa.y < pb.y : pa.z < pb.z;
+        };
+        std::sort(order.begin(), order.end(), less);
+        for (uint32_t i = 1; i < vertexCount; ++i)
+        {
+            if (!less(order[i - 1], order[i]))
+                locked[order[i - 1]] = locked[order[i]] = true;
+        }
+
+        std::unordered_map<uint64_t, uint32_t> edgeUses;
+        edgeUses.reserve(result.size());
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                uint32_t a = result[i + k], b = result[i + (k + 1) % 3];
+                ++edgeUses[((uint64_t)std::min(a, b) << 32) | std::max(a, b)];
+            }
+        }
+        for (const auto& it : edgeUses)
+        {
+            if (it.second == 1)
+                locked[it.first >> 32] = locked[it.first & 0xffffffff] = true;
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+        const glm::vec3& a = positions[result[i]];
+        glm::vec3 normal = triangleNormal(a, positions[result[i + 1]], positions[result[i + 2]]);
+        float area = glm::length(normal);
+        if (area <= 0.0f)
+            continue;
+        normal /= area;
+        for (uint32_t k = 0; k < 3; ++k)
+            quadrics[result[i + k]].addPlane(normal, -glm::dot(normal, a), area);
+    }
+
+    double maxError = (double)targetError / scale;
+    maxError *= maxError;
+    double reachedError = 0.0;
+
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<bool> touched(vertexCount);
+
+    // Passes of independent collapses, cheapest first. Each pass rebuilds the adjacency from the current triangles
+    while (result.size() > targetIndexCount)
+    {
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (uint32_t index : result)
+            ++adjacencyOffsets[index + 1];
+        for (uint32_t i = 0; i < vertexCount; ++i)
+            adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+        adjacency.resize(result.size());
+        {
+            std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (uint32_t i = 0; i < result.size(); ++i)
+                adjacency[fill[result[i]]++] = i / 3;
+        }
+
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                uint32_t a = result[i + k], b = result[i + (k + 1) % 3];
+                if (!locked[a])
+                {
+                    Quadric merged = quadrics[a];
+                    merged += quadrics[b];
+                    collapses.push_back({ a, b, merged.evaluate(positions[b]) });
+                }
+                if (!locked[b])
+                {
+                    Quadric merged = quadrics[b];
+                    merged += quadrics[a];
+                    collapses.push_back({ b, a, merged.evaluate(positions[a]) });
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(),
+            [](const Collapse& a, const Collapse& b) { return a.m_error < b.m_error; });
+
+        for (uint32_t i = 0; i < vertexCount; ++i)
+            remap[i] = i;
+        std::fill(touched.begin(), touched.end(), false);
+
+        size_t removedIndices = 0;
+        size_t requiredIndices = result.size() - targetIndexCount;
+        for (const auto& collapse : collapses)
+        {
+            if (collapse.m_error > maxError || removedIndices >= requiredIndices)
+                break;
+            if (touched[collapse.m_from] || touched[collapse.m_to])
+                continue;
+
+            // Every triangle moving with the vertex must keep its orientation
+            bool flips = false;
+            uint32_t sharedTriangles = 0;
+            const glm::vec3& target = positions[collapse.m_to];
+            for (uint32_t j = adjacencyOffsets[collapse.m_from]; j < adjacencyOffsets[collapse.m_from + 1] && !flips; ++j)
+            {
+                const uint32_t* triangle = &result[adjacency[j] * 3];
+                if (triangle[0] == collapse.m_to || triangle[1] == collapse.m_to || triangle[2] == collapse.m_to)
+                {
+                    ++sharedTriangles;
+                    continue;
+                }
+                glm::vec3 corners[3] = { positions[triangle[0]], positions[triangle[1]], positions[triangle[2]] };
+                glm::vec3 before = triangleNormal(corners[0], corners[1], corners[2]);
+                for (uint32_t k = 0; k < 3; ++k)
+                {
+                    if (triangle[k] == collapse.m_from)
+                        corners[k] = target;
+                }
+                glm::vec3 after = triangleNormal(corners[0], corners[1], corners[2]);
+                // Turning by more than 60 degrees counts as a flip, or a few collapses in a row could fold it
+                flips = glm::dot(before, after) <= 0.5f * glm::length(before) * glm::length(after);
+            }
+            if (flips || sharedTriangles == 0)
+                continue;
+
+            // Lock the whole neighbourhood, so the checks above stay valid for the rest of the pass
+            for (uint32_t j = adjacencyOffsets[collapse.m_from]; j < adjacencyOffsets[collapse.m_from + 1]; ++j)
+            {
+                const uint32_t* triangle = &result[adjacency[j] * 3];
+                touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+            }
+            touched[collapse.m_to] = true;
+
+            remap[collapse.m_from] = collapse.m_to;
+            quadrics[collapse.m_to] += quadrics[collapse.m_from];
+            reachedError = std::max(reachedError, collapse.m_error);
+            removedIndices += sharedTriangles * 3;
+        }
+        if (removedIndices == 0)
+            break;
+
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            uint32_t a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+            if (a == b || b == c || c == a)
+                continue;
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    if (resultError)
+        *resultError = (float)std::sqrt(reachedError) * scale;
+    return result;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <Oblivion.h>
+#include "../Vertex/PositionColorVertex.h"
+
+/// <summary>
+///     Quadric error edge collapse simplification (Garland and Heckbert). Edges collapse onto one of their
+///     existing vertices, so every level of detail indexes the same vertex buffer.
+/// </summary>
+namespace MeshSimplifier
+{
+    /// <summary>
+    ///     Simplifies the triangle list until it has at most targetIndexCount indices, or until the next collapse
+    ///     would move the surface further than targetError. Both errors are object space distances.
+    ///     Border and attribute seam vertices never move, so the silhouette of open meshes and UV seams hold.
+    /// </summary>
+    std::vector<uint32_t> simplify(const std::vector<uint32_t>& indices,
+        const PositionColorVertex* vertices, uint32_t vertexCount,
+        uint32_t targetIndexCount, float targetError, float* resultError = nullptr);
+}
@@ -4,6 +4,7 @@
 #include <vulkan/vulkan.hpp>
 #include "../Interfaces/IGraphicsObject.h"
 #include "VulkanObjects.h"
+#include "../../Core/CpuProfiler.h"
 
 class OneTimeCommandBuffers : public IVulkanDeviceObject, public ISingletone<OneTimeCommandBuffers>
 {
@@ -23,11 +24,23 @@ public:
         m_presentCommandPool = m_vulkanDevice.m_logicalDevice.createCommandPool(commandPoolInfo);
         EVALUATE(m_presentCommandPool, nullptr, == , "Couldn't create a one-time present command pool");
 
+        // Transfer command pool
+        commandPoolInfo.setQueueFamilyIndex(m_vulkanDevice.m_families.transferIndex);
+        m_transferCommandPool = m_vulkanDevice.m_logicalDevice.createCommandPool(commandPoolInfo);
+        EVALUATE(m_transferCommandPool, nullptr, == , "Couldn't create a one-time transfer command pool");
+
+        // Compute command pool
+        commandPoolInfo.setQueueFamilyIndex(m_vulkanDevice.m_families.computeIndex);
+        m_computeCommandPool = m_vulkanDevice.m_logicalDevice.createCommandPool(commandPoolInfo);
+        EVALUATE(m_computeCommandPool, nullptr, == , "Couldn't create a one-time compute command pool");
+
     }
     ~OneTimeCommandBuffers()
     {
         m_vulkanDevice.m_logicalDevice.destroyCommandPool(m_graphicsCommandPool);
         m_vulkanDevice.m_logicalDevice.destroyCommandPool(m_presentCommandPool);
+        m_vulkanDevice.m_logicalDevice.destroyCommandPool(m_transferCommandPool);
+        m_vulkanDevice.m_logicalDevice.destroyCommandPool(m_computeCommandPool);
     }
 
 
@@ -52,6 +65,14 @@ public:
         {
             allocationInfo.setCommandPool(m_presentCommandPool);
         }
+        else if constexpr (type == QueueFamilyType::eTransfer)
+        {
+            allocationInfo.setCommandPool(m_transferCommandPool);
+        }
+        else if constexpr (type == QueueFamilyType::eCompute)
+        {
+            allocationInfo.setCommandPool(m_computeCommandPool);
+        }
 
         auto buffers = m_vulkanDevice.m_logicalDevice.allocateCommandBuffers(allocationInfo);
         EVALUATE(buffers.size(), 0, == , "Couldn't create %d one time command buffers", numCommandBuffers);
@@ -76,6 +97,7 @@ public:
             .setSignalSemaphoreCount(0).setWaitSemaphoreCount(0);
 
         queue.submit(submitInfo, nullptr);
+        CPU_PROFILE_ZONE("queue.waitIdle");
         queue.waitIdle();
     }
 
@@ -95,11 +117,21 @@ public:
         {
             m_vulkanDevice.m_logicalDevice.freeCommandBuffers(m_presentCommandPool, buffers);
         }
+        else if constexpr (type == QueueFamilyType::eTransfer)
+        {
+            m_vulkanDevice.m_logicalDevice.freeCommandBuffers(m_transferCommandPool, buffers);
+        }
+        else if constexpr (type == QueueFamilyType::eCompute)
+        {
+            m_vulkanDevice.m_logicalDevice.freeCommandBuffers(m_computeCommandPool, buffers);
+        }
         buffers.clear();
     }
 
 private:
     vk::CommandPool                 m_graphicsCommandPool;
     vk::CommandPool                 m_presentCommandPool;
+    vk::CommandPool                 m_transferCommandPool;
+    vk::CommandPool                 m_computeCommandPool;
 
 };
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "OverdrawCounter.h"
+
+#include "../VulkanRenderer.h"
+
+
+OverdrawCounter::OverdrawCounter()
+{
+    m_supported = m_vulkanDevice.m_enabledFeatures.pipelineStatisticsQuery == VK_TRUE;
+    if (!m_supported)
+    {
+        WARNING("Pipeline statistics queries are not enabled, overdraw isn't measured");
+        return;
+    }
+
+    m_frames.resize(VulkanRenderer::getMaxInFlightFrames());
+    vk::QueryPoolCreateInfo queryPoolInfo = {};
+    queryPoolInfo.setQueryType(vk::QueryType::ePipelineStatistics).setQueryCount(_maxScopes)
+        .setPipelineStatistics(vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations);
+    for (auto& frame : m_frames)
+    {
+        frame.m_queryPool = m_vulkanDevice.m_logicalDevice.createQueryPool(queryPoolInfo);
+        EVALUATE(frame.m_queryPool, nullptr, == , "Couldn't create a query pool for OverdrawCounter");
+    }
+}
+
+OverdrawCounter::~OverdrawCounter()
+{
+    for (auto& frame : m_frames)
+    {
+        if (frame.m_queryPool)
+        {
+            m_vulkanDevice.m_logicalDevice.destroyQueryPool(frame.m_queryPool);
+            frame.m_queryPool = nullptr;
+        }
+    }
+}
+
+auto OverdrawCounter::beginFrame(vk::CommandBuffer commandBuffer, uint32_t pixelCount) -> void
+{
+    if (!m_supported)
+        return;
+
+    m_recordingFrame = &m_frames[VulkanRenderer::Get()->getInFlightFrame()];
+    m_recordingFrame->m_queryCount = 0;
+    m_recordingFrame->m_pixelCount = pixelCount;
+    m_open = false;
+
+    commandBuffer.resetQueryPool(m_recordingFrame->m_queryPool, 0, _maxScopes);
+}
+
+auto OverdrawCounter::begin(vk::CommandBuffer commandBuffer) -> void
+{
+    if (!m_supported || !m_recordingFrame || m_open || m_recordingFrame->m_queryCount == _maxScopes)
+        return;
+
+    commandBuffer.beginQuery(m_recordingFrame->m_queryPool, m_recordingFrame->m_queryCount, vk::QueryControlFlags());
+    m_open = true;
+}
+
+auto OverdrawCounter::end(vk::CommandBuffer commandBuffer) -> void
+{
+    if (!m_open)
+        return;
+
+    commandBuffer.endQuery(m_recordingFrame->m_queryPool, m_recordingFrame->m_queryCount++);
+    m_open = false;
+}
+
+auto OverdrawCounter::collect(uint32_t inFlightFrame) -> void
+{
+    if (!m_supported)
+        return;
+
+    auto& frame = m_frames[inFlightFrame];
+    if (frame.m_queryCount == 0)
+        return;
+
+    std::array<uint64_t, _maxScopes> invocations;
+    auto res = m_vulkanDevice.m_logicalDevice.getQueryPoolResults(frame.m_queryPool, 0, frame.m_queryCount,
+        frame.m_queryCount * sizeof(uint64_t), invocations.data(), sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+    if (res == vk::Result::eSuccess)
+    {
+        m_fragmentCount = 0;
+        for (uint32_t i = 0; i < frame.m_queryCount; ++i)
+            m_fragmentCount += invocations[i];
+        m_overdraw = frame.m_pixelCount ? (float)((double)m_fragmentCount / frame.m_pixelCount) : 0.0f;
+    }
+    frame.m_queryCount = 0;
+}
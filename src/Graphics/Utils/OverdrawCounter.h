@@ -0,0 +1,59 @@
+#pragma once
+
+
+#include <Oblivion.h>
+#include <vulkan/vulkan.hpp>
+#include "../Interfaces/IGraphicsObject.h"
+
+
+/// <summary>
+///     Measures overdraw: counts the fragment shader invocations of the scopes recorded in a frame with a pipeline
+///     statistics query, and divides them by the pixels of the frame. 1 means every pixel was shaded once.
+/// </summary>
+class OverdrawCounter : public IVulkanDeviceObject
+{
+    static constexpr const uint32_t _maxScopes = 8;
+public:
+    OverdrawCounter();
+    ~OverdrawCounter();
+
+public:
+    /// <summary>
+    ///     Resets the queries of the current in-flight frame. Must be recorded outside of a render pass
+    /// </summary>
+    auto                                beginFrame(vk::CommandBuffer commandBuffer, uint32_t pixelCount) -> void;
+
+    /// <summary>
+    ///     Counts the draws recorded in between. A scope must begin and end within the same subpass
+    /// </summary>
+    auto                                begin(vk::CommandBuffer commandBuffer) -> void;
+    auto                                end(vk::CommandBuffer commandBuffer) -> void;
+
+    /// <summary>
+    ///     Reads back the queries last written for inFlightFrame.
+    ///     !THE FENCE OF THAT FRAME MUST HAVE BEEN WAITED ON
+    /// </summary>
+    auto                                collect(uint32_t inFlightFrame) -> void;
+
+    auto                                getFragmentCount() const -> uint64_t { return m_fragmentCount; };
+    auto                                getOverdraw() const -> float { return m_overdraw; };
+    auto                                isSupported() const -> bool { return m_supported; };
+
+private:
+    struct FrameQueries
+    {
+        vk::QueryPool                   m_queryPool;
+        uint32_t                        m_queryCount = 0;
+        uint32_t                        m_pixelCount = 0;
+    };
+
+private:
+    bool                                m_supported = false;
+
+    std::vector<FrameQueries>           m_frames;
+    FrameQueries*                       m_recordingFrame = nullptr;
+    bool                                m_open = false;
+
+    uint64_t                            m_fragmentCount = 0;
+    float                               m_overdraw = 0.0f;
+};
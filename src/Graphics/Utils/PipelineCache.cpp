@@ -0,0 +1,114 @@
+#include "PipelineCache.h"
+
+#include "../../Core/MappedFile.h"
+
+#include <filesystem>
+#include <fstream>
+
+
+namespace
+{
+    constexpr uint32_t _magic = 0x43504F58; // "XOPC"
+    constexpr uint32_t _version = 1;
+
+    // The driver's own header only identifies the device, the driver version is checked here as well
+    struct Header
+    {
+        uint32_t    m_magic;
+        uint32_t    m_version;
+        uint32_t    m_vendorID;
+        uint32_t    m_deviceID;
+        uint32_t    m_driverVersion;
+        uint8_t     m_pipelineCacheUUID[VK_UUID_SIZE];
+        uint32_t    m_padding;      // Headers are compared as a whole, keep no implicit padding
+        uint64_t    m_dataSize;
+    };
+
+    auto makeHeader(const vk::PhysicalDeviceProperties& properties, uint64_t dataSize) -> Header
+    {
+        Header header = {};
+        header.m_magic = _magic;
+        header.m_version = _version;
+        header.m_vendorID = properties.vendorID;
+        header.m_deviceID = properties.deviceID;
+        header.m_driverVersion = properties.driverVersion;
+        memcpy(header.m_pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+        header.m_dataSize = dataSize;
+        return header;
+    }
+}
+
+PipelineCache::PipelineCache(const std::string& path) :
+    m_path(path)
+{
+    std::vector<uint8_t> data;
+    if (load(data))
+        NOTE(appendToString("Loaded ", data.size(), " bytes of pipeline cache from ", m_path));
+
+    vk::PipelineCacheCreateInfo cacheInfo;
+    cacheInfo.setInitialDataSize(data.size()).setPInitialData(data.empty() ? nullptr : data.data());
+    m_pipelineCache = m_vulkanDevice.m_logicalDevice.createPipelineCache(cacheInfo);
+    EVALUATE(m_pipelineCache, nullptr, == , "Couldn't create a pipeline cache");
+}
+
+PipelineCache::~PipelineCache()
+{
+    if (m_pipelineCache)
+    {
+        if (!save())
+            WARNING(appendToString("Couldn't save the pipeline cache to ", m_path));
+        m_vulkanDevice.m_logicalDevice.destroyPipelineCache(m_pipelineCache);
+        m_pipelineCache = nullptr;
+    }
+}
+
+auto PipelineCache::save() -> bool
+{
+    auto data = m_vulkanDevice.m_logicalDevice.getPipelineCacheData(m_pipelineCache);
+    if (data.empty())
+        return false;
+
+    Header header = makeHeader(m_vulkanDevice.m_physicalDevice.getProperties(), data.size());
+    std::string tempPath = m_path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+        if (!file)
+            return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, m_path, error);
+    if (!error)
+        return true;
+    std::filesystem::remove(tempPath, error);
+    return false;
+}
+
+auto PipelineCache::load(std::vector<uint8_t>& data) -> bool
+{
+    MappedFile file(m_path);
+    if (!file.isOpen() || file.getSize() < sizeof(Header))
+        return false;
+
+    Header header;
+    memcpy(&header, file.getData(), sizeof(Header));
+    Header expected = makeHeader(m_vulkanDevice.m_physicalDevice.getProperties(), header.m_dataSize);
+    if (memcmp(&header, &expected, sizeof(Header)) != 0)
+    {
+        NOTE(appendToString("Ignoring pipeline cache ", m_path, ", it was written by another device or driver"));
+        return false;
+    }
+    if (header.m_dataSize != file.getSize() - sizeof(Header))
+    {
+        WARNING(appendToString("Ignoring malformed pipeline cache ", m_path));
+        return false;
+    }
+
+    data.assign(file.getData() + sizeof(Header), file.getData() + file.getSize());
+    return true;
+}
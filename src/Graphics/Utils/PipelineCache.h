@@ -0,0 +1,34 @@
+#pragma once
+
+
+#include <Oblivion.h>
+#include <vulkan/vulkan.hpp>
+#include "../Interfaces/IGraphicsObject.h"
+
+
+/// <summary>
+///     vk::PipelineCache shared by every pipeline creation, loaded from disk on creation and saved back on
+///     destruction. A file written by another device, driver version or cache layout is ignored, not fed
+///     to the driver.
+/// </summary>
+class PipelineCache : public ISingletone<PipelineCache>, public IVulkanDeviceObject
+{
+public:
+    PipelineCache(const std::string& path = "pipeline.cache");
+    ~PipelineCache();
+
+public:
+    auto                                getPipelineCache() const -> vk::PipelineCache { return m_pipelineCache; };
+
+    /// <summary>
+    ///     Writes the current content of the cache to disk. Written aside and renamed, so it's never left half written
+    /// </summary>
+    auto                                save() -> bool;
+
+private:
+    auto                                load(std::vector<uint8_t>& data) -> bool;
+
+private:
+    std::string                         m_path;
+    vk::PipelineCache                   m_pipelineCache;
+};
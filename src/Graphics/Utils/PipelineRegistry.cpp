@@ -0,0 +1,287 @@
+#include "PipelineRegistry.h"
+#include "PipelineCache.h"
+
+#include "../../Core/JobSystem.h"
+#include "../../Core/CpuProfiler.h"
+
+
+namespace
+{
+    // Create info structures are serialized field by field, their padding isn't part of the state
+    template <typename type>
+    auto appendKey(std::string& key, const type& value) -> void
+    {
+        static_assert(std::is_trivially_copyable<type>::value, "Only plain values are serialized as is");
+        key.append(reinterpret_cast<const char*>(&value), sizeof(type));
+    }
+
+    template <typename type>
+    auto appendKey(std::string& key, const type* values, uint32_t count) -> void
+    {
+        appendKey(key, count);
+        for (uint32_t i = 0; values && i < count; ++i)
+            appendKey(key, values[i]);
+    }
+
+    template <typename type>
+    auto copyArray(const type* values, uint32_t count) -> std::vector<type>
+    {
+        return values ? std::vector<type>(values, values + count) : std::vector<type>();
+    }
+
+    /// <summary>
+    ///     Owns everything a vk::GraphicsPipelineCreateInfo points to, so the pipeline can be created after the
+    ///     caller's state is gone, and serializes that state into the registry key
+    /// </summary>
+    struct PipelineState
+    {
+        PipelineState(const vk::GraphicsPipelineCreateInfo& info);
+
+        PipelineState(const PipelineState&) = delete;
+        PipelineState& operator = (const PipelineState&) = delete;
+
+        vk::GraphicsPipelineCreateInfo                      m_pipelineInfo;
+        std::vector<vk::PipelineShaderStageCreateInfo>      m_stages;
+        std::vector<std::string>                            m_entryPoints;
+        vk::PipelineVertexInputStateCreateInfo              m_vertexInputState;
+        std::vector<vk::VertexInputBindingDescription>      m_bindings;
+        std::vector<vk::VertexInputAttributeDescription>    m_attributes;
+        vk::PipelineInputAssemblyStateCreateInfo            m_inputState;
+        vk::PipelineTessellationStateCreateInfo             m_tesselationState;
+        vk::PipelineViewportStateCreateInfo                 m_viewportState;
+        std::vector<vk::Viewport>                           m_viewports;
+        std::vector<vk::Rect2D>                             m_scissors;
+        vk::PipelineRasterizationStateCreateInfo            m_rasterizerState;
+        vk::PipelineMultisampleStateCreateInfo              m_msaaState;
+        std::vector<vk::SampleMask>                         m_sampleMask;
+        vk::PipelineDepthStencilStateCreateInfo             m_depthState;
+        vk::PipelineColorBlendStateCreateInfo               m_blendState;
+        std::vector<vk::PipelineColorBlendAttachmentState>  m_blendAttachments;
+        vk::PipelineDynamicStateCreateInfo                  m_dynamicState;
+        std::vector<vk::DynamicState>                       m_dynamicStates;
+
+        std::string                                         m_key;
+    };
+
+    PipelineState::PipelineState(const vk::GraphicsPipelineCreateInfo& info) :
+        m_pipelineInfo(info)
+    {
+        EVALUATE(info.pNext, nullptr, != , "PipelineRegistry doesn't handle extension structures");
+        EVALUATE(info.pVertexInputState && info.pInputAssemblyState && info.pViewportState && info.pRasterizationState &&
+            info.pMultisampleState && info.pColorBlendState, false, == , "PipelineRegistry takes complete, rasterizing pipeline states");
+        m_key.reserve(1024);
+        appendKey(m_key, info.flags);
+        appendKey(m_key, info.layout);
+        appendKey(m_key, info.renderPass);
+        appendKey(m_key, info.subpass);
+
+        // Shader stages, by module and entry point
+        m_stages = copyArray(info.pStages, info.stageCount);
+        m_entryPoints.reserve(m_stages.size());
+        appendKey(m_key, (uint32_t)m_stages.size());
+        for (auto& it : m_stages)
+        {
+            EVALUATE(it.pSpecializationInfo, nullptr, != , "PipelineRegistry doesn't handle specialization constants");
+            m_entryPoints.push_back(it.pName);
+            it.setPName(m_entryPoints.back().c_str());
+            appendKey(m_key, it.stage);
+            appendKey(m_key, it.module);
+            m_key.append(m_entryPoints.back()).push_back('\0');
+        }
+
+        m_vertexInputState = *info.pVertexInputState;
+        m_bindings = copyArray(m_vertexInputState.pVertexBindingDescriptions, m_vertexInputState.vertexBindingDescriptionCount);
+        m_attributes = copyArray(m_vertexInputState.pVertexAttributeDescriptions, m_vertexInputState.vertexAttributeDescriptionCount);
+        m_vertexInputState.setPVertexBindingDescriptions(m_bindings.data()).setPVertexAttributeDescriptions(m_attributes.data());
+        appendKey(m_key, m_bindings.data(), (uint32_t)m_bindings.size());
+        appendKey(m_key, m_attributes.data(), (uint32_t)m_attributes.size());
+
+        m_inputState = *info.pInputAssemblyState;
+        appendKey(m_key, m_inputState.topology);
+        appendKey(m_key, m_inputState.primitiveRestartEnable);
+
+        // Only read with tessellation stages, PatchControlPoints is 0 otherwise
+        if (info.pTessellationState)
+            m_tesselationState = *info.pTessellationState;
+        appendKey(m_key, info.pTessellationState ? m_tesselationState.patchControlPoints : 0u);
+
+        m_viewportState = *info.pViewportState;
+        m_viewports = copyArray(m_viewportState.pViewports, m_viewportState.viewportCount);
+        m_scissors = copyArray(m_viewportState.pScissors, m_viewportState.scissorCount);
+        m_viewportState.setPViewports(m_viewports.empty() ? nullptr : m_viewports.data())
+            .setPScissors(m_scissors.empty() ? nullptr : m_scissors.data());
+        appendKey(m_key, m_viewportState.viewportCount);
+        appendKey(m_key, m_viewportState.scissorCount);
+        appendKey(m_key, m_viewports.data(), (uint32_t)m_viewports.size());
+        appendKey(m_key, m_scissors.data(), (uint32_t)m_scissors.size());
+
+        m_rasterizerState = *info.pRasterizationState;
+        appendKey(m_key, m_rasterizerState.depthClampEnable);
+        appendKey(m_key, m_rasterizerState.rasterizerDiscardEnable);
+        appendKey(m_key, m_rasterizerState.polygonMode);
+        appendKey(m_key, m_rasterizerState.cullMode);
+        appendKey(m_key, m_rasterizerState.frontFace);
+        appendKey(m_key, m_rasterizerState.depthBiasEnable);
+        appendKey(m_key, m_rasterizerState.depthBiasConstantFactor);
+        appendKey(m_key, m_rasterizerState.depthBiasClamp);
+        appendKey(m_key, m_rasterizerState.depthBiasSlopeFactor);
+        appendKey(m_key, m_rasterizerState.lineWidth);
+
+        m_msaaState = *info.pMultisampleState;
+        m_sampleMask = copyArray(m_msaaState.pSampleMask, ((uint32_t)m_msaaState.rasterizationSamples + 31) / 32);
+        m_msaaState.setPSampleMask(m_sampleMask.empty() ? nullptr : m_sampleMask.data());
+        appendKey(m_key, m_msaaState.rasterizationSamples);
+        appendKey(m_key, m_msaaState.sampleShadingEnable);
+        appendKey(m_key, m_msaaState.minSampleShading);
+        appendKey(m_key, m_sampleMask.data(), (uint32_t)m_sampleMask.size());
+        appendKey(m_key, m_msaaState.alphaToCoverageEnable);
+        appendKey(m_key, m_msaaState.alphaToOneEnable);
+
+        // Without a depth attachment the depth state isn't read, key it as if it were all off
+        if (info.pDepthStencilState)
+            m_depthState = *info.pDepthStencilState;
+        appendKey(m_key, m_depthState.depthTestEnable);
+        appendKey(m_key, m_depthState.depthWriteEnable);
+        appendKey(m_key, m_depthState.depthCompareOp);
+        appendKey(m_key, m_depthState.depthBoundsTestEnable);
+        appendKey(m_key, m_depthState.stencilTestEnable);
+        appendKey(m_key, m_depthState.front);
+        appendKey(m_key, m_depthState.back);
+        appendKey(m_key, m_depthState.minDepthBounds);
+        appendKey(m_key, m_depthState.maxDepthBounds);
+
+        m_blendState = *info.pColorBlendState;
+        m_blendAttachments = copyArray(m_blendState.pAttachments, m_blendState.attachmentCount);
+        m_blendState.setPAttachments(m_blendAttachments.empty() ? nullptr : m_blendAttachments.data());
+        appendKey(m_key, m_blendState.logicOpEnable);
+        appendKey(m_key, m_blendState.logicOp);
+        appendKey(m_key, m_blendAttachments.data(), (uint32_t)m_blendAttachments.size());
+        appendKey(m_key, m_blendState.blendConstants);
+
+        if (info.pDynamicState)
+        {
+            m_dynamicState = *info.pDynamicState;
+            m_dynamicStates = copyArray(m_dynamicState.pDynamicStates, m_dynamicState.dynamicStateCount);
+            m_dynamicState.setPDynamicStates(m_dynamicStates.empty() ? nullptr : m_dynamicStates.data());
+        }
+        appendKey(m_key, m_dynamicStates.data(), (uint32_t)m_dynamicStates.size());
+
+        // Base pipelines only speed up creation, they don't change the result
+        m_pipelineInfo.setPStages(m_stages.data())
+            .setPVertexInputState(&m_vertexInputState)
+            .setPInputAssemblyState(&m_inputState)
+            .setPTessellationState(info.pTessellationState ? &m_tesselationState : nullptr)
+            .setPViewportState(&m_viewportState)
+            .setPRasterizationState(&m_rasterizerState)
+            .setPMultisampleState(&m_msaaState)
+            .setPDepthStencilState(info.pDepthStencilState ? &m_depthState : nullptr)
+            .setPColorBlendState(&m_blendState)
+            .setPDynamicState(info.pDynamicState ? &m_dynamicState : nullptr);
+    }
+
+    auto createPipeline(vk::Device device, vk::PipelineCache pipelineCache, const PipelineState& state) -> vk::Pipeline
+    {
+        CPU_PROFILE_ZONE("PipelineRegistry::createPipeline");
+        vk::Pipeline pipeline;
+        EVALUATE(pipeline = device.createGraphicsPipeline(pipelineCache, state.m_pipelineInfo), nullptr,
+            == , "Couldn't create a pipeline");
+        return pipeline;
+    }
+}
+
+PipelineRegistry::Pipeline::~Pipeline()
+{
+    if (!m_pipeline.valid())
+        return;
+
+    try
+    { // Waits for a creation still running
+        vk::Pipeline pipeline = m_pipeline.get();
+        if (pipeline)
+            m_vulkanDevice.m_logicalDevice.destroyPipeline(pipeline);
+    }
+    catch (const std::exception&)
+    { // Failed, reported to whoever waited on it
+    }
+}
+
+auto PipelineRegistry::Pipeline::isReady() const -> bool
+{
+    return m_pipeline.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+auto PipelineRegistry::Pipeline::get() const -> vk::Pipeline
+{
+    return isReady() ? m_pipeline.get() : vk::Pipeline();
+}
+
+auto PipelineRegistry::Pipeline::wait() const -> vk::Pipeline
+{
+    return m_pipeline.get();
+}
+
+auto PipelineRegistry::acquire(const vk::GraphicsPipelineCreateInfo& pipelineInfo, bool async) -> std::shared_ptr<Pipeline>
+{
+    auto state = std::make_shared<PipelineState>(pipelineInfo);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto it = m_pipelines.find(state->m_key);
+    if (it != m_pipelines.end())
+    {
+        if (auto pipeline = it->second.lock())
+        {
+            // Another user may have asked for it asynchronously, a synchronous caller expects it created
+            lock.unlock();
+            if (!async)
+                pipeline->wait();
+            return pipeline;
+        }
+    }
+
+    // Only creations add entries, so dropping the expired ones here bounds the map by the live pipelines
+    for (auto expired = m_pipelines.begin(); expired != m_pipelines.end();)
+        expired = expired->second.expired() ? m_pipelines.erase(expired) : std::next(expired);
+
+    // Creating pipelines is thread safe, and so is the pipeline cache
+    auto device = m_vulkanDevice.m_logicalDevice;
+    auto pipelineCache = PipelineCache::Get()->getPipelineCache();
+    std::promise<vk::Pipeline> promise;
+    std::shared_future<vk::Pipeline> future;
+    if (async)
+    {
+        future = JobSystem::Get()->async([device, pipelineCache, state]()
+        {
+            return createPipeline(device, pipelineCache, *state);
+        }).share();
+    }
+    else
+        future = promise.get_future().share();
+
+    auto pipeline = std::make_shared<Pipeline>(std::move(future));
+    m_pipelines[state->m_key] = pipeline;
+    if (async)
+        return pipeline;
+
+    // The entry is published before creating, so other acquires of the same state wait on it
+    // and acquires of other states don't wait on the lock
+    lock.unlock();
+    try
+    {
+        promise.set_value(createPipeline(device, pipelineCache, *state));
+    }
+    catch (...)
+    { // Rethrown to whoever waits on it too
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+    return pipeline;
+}
+
+auto PipelineRegistry::getPipelineCount() -> uint32_t
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t count = 0;
+    for (const auto& it : m_pipelines)
+        count += it.second.expired() ? 0 : 1;
+    return count;
+}
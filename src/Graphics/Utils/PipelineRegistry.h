@@ -0,0 +1,64 @@
+#pragma once
+
+
+#include <Oblivion.h>
+#include <vulkan/vulkan.hpp>
+#include "../Interfaces/IGraphicsObject.h"
+
+#include <future>
+#include <mutex>
+#include <unordered_map>
+
+
+/// <summary>
+///     Deduplicates graphics pipelines. The whole state of a vk::GraphicsPipelineCreateInfo is hashed and every
+///     identical request shares one vk::Pipeline, destroyed with its last user. Shader modules and render passes
+///     are keyed by handle, so they must outlive the pipelines built from them.
+///     Creation goes through the PipelineCache and can run on a JobSystem worker.
+/// </summary>
+class PipelineRegistry : public ISingletone<PipelineRegistry>, public IVulkanDeviceObject
+{
+public:
+    /// <summary>
+    ///     A shared pipeline, possibly still being created
+    /// </summary>
+    class Pipeline : public IVulkanDeviceObject
+    {
+    public:
+        Pipeline(std::shared_future<vk::Pipeline> pipeline) : m_pipeline(std::move(pipeline)) {};
+        ~Pipeline();
+
+        Pipeline(const Pipeline&) = delete;
+        Pipeline& operator = (const Pipeline&) = delete;
+
+    public:
+        auto                            isReady() const -> bool;
+        // Null while the pipeline is still being created, never blocks
+        auto                            get() const -> vk::Pipeline;
+        // Blocks until the pipeline is created, rethrows a creation failure
+        auto                            wait() const -> vk::Pipeline;
+
+    private:
+        std::shared_future<vk::Pipeline> m_pipeline;
+    };
+
+public:
+    PipelineRegistry() = default;
+    ~PipelineRegistry() = default;
+
+public:
+    /// <summary>
+    ///     Returns the pipeline of that state, creating it if nobody holds it yet. The create info is copied,
+    ///     it doesn't have to outlive the call. Async creation returns at once, poll the result with isReady().
+    ///     A synchronous call always returns a created pipeline, waiting for it if an async one is in flight
+    /// </summary>
+    auto                                acquire(const vk::GraphicsPipelineCreateInfo& pipelineInfo, bool async = false)
+                                            -> std::shared_ptr<Pipeline>;
+
+    auto                                getPipelineCount() -> uint32_t;
+
+private:
+    std::mutex                          m_mutex;
+    std::unordered_map<std::string, std::weak_ptr<Pipeline>>
+                                        m_pipelines;    // By serialized state
+};
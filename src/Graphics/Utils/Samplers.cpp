@@ -11,6 +11,16 @@ Samplers::~Samplers()
         m_vulkanDevice.m_logicalDevice.destroySampler(m_linearAnisotropicSampler);
         m_linearAnisotropicSampler = nullptr;
     }
+    if (m_linearNonAnisotropicSampler)
+    {
+        m_vulkanDevice.m_logicalDevice.destroySampler(m_linearNonAnisotropicSampler);
+        m_linearNonAnisotropicSampler = nullptr;
+    }
+    if (m_nearestClampSampler)
+    {
+        m_vulkanDevice.m_logicalDevice.destroySampler(m_nearestClampSampler);
+        m_nearestClampSampler = nullptr;
+    }
 }
 
 auto Samplers::getLinearAnisotropicSampler() -> vk::Sampler
@@ -52,3 +62,22 @@ auto Samplers::getLinearNonAnisotropicSampler() -> vk::Sampler
     m_linearNonAnisotropicSampler = m_vulkanDevice.m_logicalDevice.createSampler(samplerInfo);
     return m_linearNonAnisotropicSampler;
 }
+
+auto Samplers::getNearestClampSampler() -> vk::Sampler
+{
+    if (m_nearestClampSampler)
+    {
+        return m_nearestClampSampler;
+    }
+    vk::SamplerCreateInfo samplerInfo = {};
+    samplerInfo.setAddressModeU(vk::SamplerAddressMode::eClampToEdge)
+        .setAddressModeV(vk::SamplerAddressMode::eClampToEdge)
+        .setAddressModeW(vk::SamplerAddressMode::eClampToEdge)
+        .setAnisotropyEnable(VK_FALSE).setMaxAnisotropy(1)
+        .setCompareEnable(VK_FALSE)
+        .setMagFilter(vk::Filter::eNearest).setMinFilter(vk::Filter::eNearest)
+        .setMaxLod(FLT_MAX).setMinLod(0.0f).setMipmapMode(vk::SamplerMipmapMode::eNearest)
+        .setUnnormalizedCoordinates(VK_FALSE);
+    m_nearestClampSampler = m_vulkanDevice.m_logicalDevice.createSampler(samplerInfo);
+    return m_nearestClampSampler;
+}
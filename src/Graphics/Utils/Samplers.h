@@ -15,8 +15,11 @@ public:
 public:
     auto                        getLinearAnisotropicSampler()->vk::Sampler;
     auto                        getLinearNonAnisotropicSampler()->vk::Sampler;
+    // For texelFetch and formats without linear filtering, such as depth
+    auto                        getNearestClampSampler()->vk::Sampler;
 
 private:
     vk::Sampler                 m_linearAnisotropicSampler;
     vk::Sampler                 m_linearNonAnisotropicSampler;
+    vk::Sampler                 m_nearestClampSampler;
 };
\ No newline at end of file
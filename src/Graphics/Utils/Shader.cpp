@@ -29,6 +29,8 @@ Shader::Shader(const std::string & path)
         m_shaderType = vk::ShaderStageFlagBits::eVertex;
     else if (boost::contains(path, "frag"))
         m_shaderType = vk::ShaderStageFlagBits::eFragment;
+    else if (boost::contains(path, "comp"))
+        m_shaderType = vk::ShaderStageFlagBits::eCompute;
 
 
     m_pipelineCreateInfo.setModule(m_shader);
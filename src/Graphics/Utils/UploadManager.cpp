@@ -0,0 +1,299 @@
+#include "UploadManager.h"
+
+#include "VulkanAllocators.h"
+#include "../../Core/CpuProfiler.h"
+
+
+UploadManager::UploadManager()
+{
+    m_dedicatedTransfer = m_vulkanDevice.hasDedicatedTransferQueue();
+
+    vk::CommandPoolCreateInfo commandPoolInfo = {};
+    commandPoolInfo.setQueueFamilyIndex(m_vulkanDevice.m_families.transferIndex)
+        .setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer | vk::CommandPoolCreateFlagBits::eTransient);
+    m_commandPool = m_vulkanDevice.m_logicalDevice.createCommandPool(commandPoolInfo);
+    EVALUATE(m_commandPool, nullptr, == , "Couldn't create a command pool for UploadManager");
+    if (m_dedicatedTransfer)
+    {
+        commandPoolInfo.setQueueFamilyIndex(m_vulkanDevice.m_families.graphicsIndex);
+        m_graphicsCommandPool = m_vulkanDevice.m_logicalDevice.createCommandPool(commandPoolInfo);
+        EVALUATE(m_graphicsCommandPool, nullptr, == , "Couldn't create a graphics command pool for UploadManager");
+    }
+
+    vk::BufferCreateInfo bufferInfo = {};
+    bufferInfo.setPQueueFamilyIndices(&m_vulkanDevice.m_families.transferIndex).setQueueFamilyIndexCount(1)
+        .setSharingMode(vk::SharingMode::eExclusive)
+        .setUsage(vk::BufferUsageFlagBits::eTransferSrc).setSize(_stagingSize);
+
+    VmaAllocationCreateInfo allocationInfo = {};
+    allocationInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    allocationInfo.requiredFlags = (VkMemoryPropertyFlags)(vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+
+    VmaAllocationInfo info = {};
+    VkResult res = vmaCreateBuffer(g_allocator, (VkBufferCreateInfo*)&bufferInfo, &allocationInfo,
+        (VkBuffer*)&m_stagingBuffer, &m_stagingMemory, &info);
+    EVALUATE(res, VkResult::VK_SUCCESS, != , "Couldn't create the staging buffer for UploadManager");
+    m_stagingData = static_cast<uint8_t*>(info.pMappedData);
+}
+
+UploadManager::~UploadManager()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_openBatch)
+        submitBatch();
+    while (!m_submittedBatches.empty())
+        retireBatch();
+
+    for (const auto& it : m_freeBatches)
+    {
+        m_vulkanDevice.m_logicalDevice.destroyFence(it->m_fence);
+        if (it->m_semaphore)
+            m_vulkanDevice.m_logicalDevice.destroySemaphore(it->m_semaphore);
+    }
+
+    m_vulkanDevice.m_logicalDevice.destroyCommandPool(m_commandPool);
+    if (m_graphicsCommandPool)
+        m_vulkanDevice.m_logicalDevice.destroyCommandPool(m_graphicsCommandPool);
+    m_vulkanDevice.m_logicalDevice.destroyBuffer(m_stagingBuffer);
+    vmaFreeMemory(g_allocator, m_stagingMemory);
+}
+
+auto UploadManager::upload(const void* data, vk::DeviceSize size, const RecordFunction& record) -> Handle
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    vk::Buffer staging;
+    vk::DeviceSize offset = 0;
+    void* dst = nullptr;
+    if (size > _stagingSize)
+    { // Would never fit into the ring, give it its own staging buffer released with the batch
+        if (!m_openBatch)
+            openBatch();
+
+        auto buffer = BufferUtils::createBuffer(vk::BufferUsageFlagBits::eTransferSrc,
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, {},
+            &m_vulkanDevice.m_families.transferIndex, 1, size);
+        vmaMapMemory(g_allocator, buffer.m_memory, &dst);
+        memcpy(dst, data, size);
+        vmaUnmapMemory(g_allocator, buffer.m_memory);
+
+        m_openBatch->m_dedicatedBuffers.push_back(buffer);
+        staging = buffer.m_buffer;
+    }
+    else
+    {
+        while (!allocateStaging(size, offset))
+        { // The ring is full, wait for the oldest batch to give its range back
+            CPU_PROFILE_ZONE("UploadManager::waitStaging");
+            if (m_openBatch && m_openBatch->m_stagingEnd != 0)
+                submitBatch();
+            EVALUATE(m_submittedBatches.empty(), true, == , "UploadManager staging ring can't fit %llu bytes", (unsigned long long)size);
+            retireBatch();
+        }
+        if (!m_openBatch)
+            openBatch();
+
+        memcpy(m_stagingData + offset, data, size);
+        m_openBatch->m_stagingEnd = m_stagingHead;
+        staging = m_stagingBuffer;
+    }
+
+    Commands commands;
+    commands.m_transfer = m_openBatch->m_commandBuffer;
+    commands.m_graphics = m_dedicatedTransfer ? m_openBatch->m_graphicsCommandBuffer : m_openBatch->m_commandBuffer;
+    commands.m_transferFamily = m_vulkanDevice.m_families.transferIndex;
+    commands.m_graphicsFamily = m_vulkanDevice.m_families.graphicsIndex;
+    commands.m_staging = staging;
+    commands.m_offset = offset;
+    record(commands);
+    return { m_openBatch->m_id, m_openBatch->m_future };
+}
+
+auto UploadManager::uploadBuffer(const void* data, vk::DeviceSize size,
+    const BufferUtils::Buffer& dst, vk::DeviceSize dstOffset) -> Handle
+{
+    return upload(data, size, [&](const Commands& commands)
+    {
+        vk::BufferCopy copyInfo;
+        copyInfo.setSrcOffset(commands.m_offset).setDstOffset(dstOffset).setSize(size);
+        commands.m_transfer.copyBuffer(commands.m_staging, dst.m_buffer, 1, &copyInfo);
+
+        if (commands.m_transferFamily != commands.m_graphicsFamily)
+        {
+            BufferUtils::releaseOwnership(commands.m_transfer, dst, commands.m_transferFamily, commands.m_graphicsFamily,
+                vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite);
+            BufferUtils::acquireOwnership(commands.m_graphics, dst, commands.m_transferFamily, commands.m_graphicsFamily,
+                vk::PipelineStageFlagBits::eAllCommands, vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead |
+                vk::AccessFlagBits::eUniformRead | vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eTransferRead);
+        }
+    });
+}
+
+auto UploadManager::flush() -> void
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_openBatch)
+        submitBatch();
+}
+
+auto UploadManager::collect() -> void
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    collectNoLock();
+}
+
+auto UploadManager::isComplete(const Handle& handle) -> bool
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    collectNoLock();
+    return handle.m_batch <= m_completedBatch;
+}
+
+auto UploadManager::wait(const Handle& handle) -> void
+{
+    CPU_PROFILE_ZONE("UploadManager::wait");
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_openBatch && m_openBatch->m_id <= handle.m_batch)
+        submitBatch();
+    while (m_completedBatch < handle.m_batch && !m_submittedBatches.empty())
+        retireBatch();
+}
+
+auto UploadManager::openBatch() -> void
+{
+    if (!m_freeBatches.empty())
+    {
+        m_openBatch = std::move(m_freeBatches.back());
+        m_freeBatches.pop_back();
+        m_openBatch->m_commandBuffer.reset({});
+        if (m_dedicatedTransfer)
+            m_openBatch->m_graphicsCommandBuffer.reset({});
+        m_vulkanDevice.m_logicalDevice.resetFences(1, &m_openBatch->m_fence);
+    }
+    else
+    {
+        m_openBatch = std::make_unique<Batch>();
+
+        vk::CommandBufferAllocateInfo allocationInfo = {};
+        allocationInfo.setCommandBufferCount(1).setLevel(vk::CommandBufferLevel::ePrimary).setCommandPool(m_commandPool);
+        auto commandBuffers = m_vulkanDevice.m_logicalDevice.allocateCommandBuffers(allocationInfo);
+        EVALUATE(commandBuffers.size(), 0, == , "Couldn't allocate an upload command buffer");
+        m_openBatch->m_commandBuffer = commandBuffers[0];
+
+        if (m_dedicatedTransfer)
+        {
+            allocationInfo.setCommandPool(m_graphicsCommandPool);
+            commandBuffers = m_vulkanDevice.m_logicalDevice.allocateCommandBuffers(allocationInfo);
+            EVALUATE(commandBuffers.size(), 0, == , "Couldn't allocate an upload command buffer");
+            m_openBatch->m_graphicsCommandBuffer = commandBuffers[0];
+
+            m_openBatch->m_semaphore = m_vulkanDevice.m_logicalDevice.createSemaphore(vk::SemaphoreCreateInfo());
+            EVALUATE(m_openBatch->m_semaphore, nullptr, == , "Couldn't create an upload semaphore");
+        }
+
+        m_openBatch->m_fence = m_vulkanDevice.m_logicalDevice.createFence(vk::FenceCreateInfo());
+        EVALUATE(m_openBatch->m_fence, nullptr, == , "Couldn't create an upload fence");
+    }
+
+    m_openBatch->m_id = m_nextBatch++;
+    m_openBatch->m_stagingEnd = 0;
+    m_openBatch->m_promise = std::promise<void>();
+    m_openBatch->m_future = m_openBatch->m_promise.get_future().share();
+
+    vk::CommandBufferBeginInfo beginInfo = {};
+    beginInfo.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+    m_openBatch->m_commandBuffer.begin(beginInfo);
+    if (m_dedicatedTransfer)
+        m_openBatch->m_graphicsCommandBuffer.begin(beginInfo);
+}
+
+auto UploadManager::submitBatch() -> void
+{
+    auto commandBuffer = m_dedicatedTransfer ? m_openBatch->m_graphicsCommandBuffer : m_openBatch->m_commandBuffer;
+    if (m_dedicatedTransfer)
+    { // Copies go first on the transfer queue, the graphics side waits for them
+        m_openBatch->m_commandBuffer.end();
+
+        vk::SubmitInfo submitInfo;
+        submitInfo.setCommandBufferCount(1).setPCommandBuffers(&m_openBatch->m_commandBuffer)
+            .setSignalSemaphoreCount(1).setPSignalSemaphores(&m_openBatch->m_semaphore);
+        m_vulkanDevice.m_queues.transferQueue.submit(1, &submitInfo, nullptr);
+    }
+
+    // Make the copies visible to everything submitted after this batch on the same queue
+    vk::MemoryBarrier barrier;
+    barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+        .setDstAccessMask(vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead |
+            vk::AccessFlagBits::eUniformRead | vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eTransferRead);
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands,
+        {}, 1, &barrier, 0, nullptr, 0, nullptr);
+    commandBuffer.end();
+
+    vk::SubmitInfo submitInfo;
+    vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eAllCommands;
+    submitInfo.setCommandBufferCount(1).setPCommandBuffers(&commandBuffer);
+    if (m_dedicatedTransfer)
+    {
+        submitInfo.setWaitSemaphoreCount(1).setPWaitSemaphores(&m_openBatch->m_semaphore)
+            .setPWaitDstStageMask(&waitStage);
+    }
+    m_vulkanDevice.m_queues.graphicsQueue.submit(1, &submitInfo, m_openBatch->m_fence);
+
+    m_submittedBatches.push_back(std::move(m_openBatch));
+}
+
+auto UploadManager::retireBatch() -> void
+{
+    auto& batch = m_submittedBatches.front();
+    m_vulkanDevice.m_logicalDevice.waitForFences(1, &batch->m_fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+
+    if (batch->m_stagingEnd != 0)
+        m_stagingTail = batch->m_stagingEnd;
+    for (const auto& it : batch->m_dedicatedBuffers)
+    {
+        m_vulkanDevice.m_logicalDevice.destroyBuffer(it.m_buffer);
+        vmaFreeMemory(g_allocator, it.m_memory);
+    }
+    batch->m_dedicatedBuffers.clear();
+
+    m_completedBatch = batch->m_id;
+    batch->m_promise.set_value();
+
+    m_freeBatches.push_back(std::move(batch));
+    m_submittedBatches.pop_front();
+}
+
+auto UploadManager::collectNoLock() -> void
+{
+    while (!m_submittedBatches.empty() &&
+        m_vulkanDevice.m_logicalDevice.getFenceStatus(m_submittedBatches.front()->m_fence) == vk::Result::eSuccess)
+    {
+        retireBatch();
+    }
+}
+
+auto UploadManager::allocateStaging(vk::DeviceSize size, vk::DeviceSize& offset) -> bool
+{
+    // head == tail only when the ring is empty, so it's never filled up to the tail
+    if (m_stagingHead == m_stagingTail)
+        m_stagingHead = m_stagingTail = 0;
+
+    offset = (m_stagingHead + _stagingAlignment - 1) / _stagingAlignment * _stagingAlignment;
+    if (m_stagingHead >= m_stagingTail)
+    {
+        if (offset + size > _stagingSize)
+        { // Wrap around
+            if (size >= m_stagingTail)
+                return false;
+            offset = 0;
+        }
+    }
+    else if (offset + size >= m_stagingTail)
+    {
+        return false;
+    }
+
+    m_stagingHead = offset + size;
+    return true;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+
+#include <Oblivion.h>
+#include <vulkan/vulkan.hpp>
+#include <vk_mem_alloc.h>
+#include "../Interfaces/IGraphicsObject.h"
+#include "BufferUtils.h"
+
+#include <deque>
+#include <future>
+#include <mutex>
+
+
+/// <summary>
+///     Copies data to device local resources without stalling the queue.
+///     Data is written into a persistently mapped staging ring, the copies are recorded into the open batch
+///     and batches are submitted with a fence. A batch's staging range is reused once its fence signals.
+///     With a dedicated transfer queue the copies run there, and a graphics side command buffer waiting on
+///     them acquires ownership of the resources and does what transfer queues can't (e.g. mipmap blits).
+/// </summary>
+class UploadManager : public ISingletone<UploadManager>, public IVulkanDeviceObject
+{
+    static constexpr const vk::DeviceSize _stagingSize = 32 * 1024 * 1024;
+    static constexpr const vk::DeviceSize _stagingAlignment = 16;
+public:
+    struct Commands
+    {
+        vk::CommandBuffer               m_transfer;         // Copies out of the staging range, on transferFamily
+        vk::CommandBuffer               m_graphics;         // Ownership acquires and graphics work, same as m_transfer without a dedicated queue
+        uint32_t                        m_transferFamily;
+        uint32_t                        m_graphicsFamily;
+        vk::Buffer                      m_staging;
+        vk::DeviceSize                  m_offset;
+    };
+    /// <summary>
+    ///     Records the copies out of the staging range into the batch's command buffers
+    /// </summary>
+    using RecordFunction = std::function<void(const Commands& commands)>;
+
+    struct Handle
+    {
+        uint64_t                        m_batch = 0;
+        std::shared_future<void>        m_future;   // Ready once the copies completed on the GPU
+    };
+
+public:
+    UploadManager();
+    ~UploadManager();
+
+public:
+    /// <summary>
+    ///     Stages size bytes of data and records the copies with record.
+    ///     !RENDER THREAD ONLY: a full ring submits to the graphics and transfer queues, which the renderer
+    ///     submits to without holding any lock
+    /// </summary>
+    auto                                upload(const void* data, vk::DeviceSize size, const RecordFunction& record) -> Handle;
+    // Same as upload, render thread only
+    auto                                uploadBuffer(const void* data, vk::DeviceSize size,
+                                            const BufferUtils::Buffer& dst, vk::DeviceSize dstOffset = 0) -> Handle;
+
+    /// <summary>
+    ///     Submits the open batch. Called by the renderer before submitting a frame, so the frame sees the copies
+    /// </summary>
+    auto                                flush() -> void;
+    /// <summary>
+    ///     Retires the batches whose fence signaled, without blocking
+    /// </summary>
+    auto                                collect() -> void;
+
+    auto                                isComplete(const Handle& handle) -> bool;
+    // Render thread only, it may submit the open batch
+    auto                                wait(const Handle& handle) -> void;
+
+private:
+    struct Batch
+    {
+        uint64_t                        m_id = 0;
+        vk::CommandBuffer               m_commandBuffer;
+        vk::CommandBuffer               m_graphicsCommandBuffer;    // Only with a dedicated transfer queue
+        vk::Semaphore                   m_semaphore;                // Transfer -> graphics, only with a dedicated transfer queue
+        vk::Fence                       m_fence;
+        vk::DeviceSize                  m_stagingEnd = 0;
+        std::vector<BufferUtils::Buffer> m_dedicatedBuffers;    // Staging of uploads larger than the ring
+        std::promise<void>              m_promise;
+        std::shared_future<void>        m_future;
+    };
+
+    auto                                openBatch() -> void;
+    auto                                submitBatch() -> void;
+    auto                                retireBatch() -> void;
+    auto                                collectNoLock() -> void;
+    auto                                allocateStaging(vk::DeviceSize size, vk::DeviceSize& offset) -> bool;
+
+private:
+    std::mutex                          m_mutex;            // Lets isComplete() poll from other threads, submits stay on the render thread
+
+    vk::CommandPool                     m_commandPool;
+    vk::CommandPool                     m_graphicsCommandPool;
+    bool                                m_dedicatedTransfer = false;
+
+    vk::Buffer                          m_stagingBuffer;
+    VmaAllocation                       m_stagingMemory = nullptr;
+    uint8_t*                            m_stagingData = nullptr;
+    vk::DeviceSize                      m_stagingHead = 0;
+    vk::DeviceSize                      m_stagingTail = 0;
+
+    std::unique_ptr<Batch>              m_openBatch;
+    std::deque<std::unique_ptr<Batch>>  m_submittedBatches;
+    std::vector<std::unique_ptr<Batch>> m_freeBatches;
+
+    uint64_t                            m_nextBatch = 1;
+    uint64_t                            m_completedBatch = 0;
+};
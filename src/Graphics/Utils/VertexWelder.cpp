@@ -0,0 +1,155 @@
+#include "VertexWelder.h"
+
+#include "../../Core/JobSystem.h"
+#include "../../Core/CpuProfiler.h"
+
+#include <chrono>
+
+
+namespace
+{
+    constexpr uint32_t _partitionBits = 6;
+    constexpr uint32_t _partitionCount = 1u << _partitionBits;
+    constexpr uint32_t _grain = 1u << 16;
+    constexpr uint32_t _empty = ~0u;
+
+    static_assert(sizeof(PositionColorVertex) % sizeof(uint64_t) == 0, "The vertex is hashed 64 bits at a time");
+
+    auto mix(uint64_t value) -> uint64_t
+    {
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccdull;
+        value ^= value >> 33;
+        value *= 0xc4ceb9fe1a85ec53ull;
+        value ^= value >> 33;
+        return value;
+    }
+
+    // Hashes the raw bits, so it agrees with the memcmp used to compare vertices
+    auto hashVertex(const PositionColorVertex& vertex) -> uint32_t
+    {
+        uint64_t words[sizeof(PositionColorVertex) / sizeof(uint64_t)];
+        memcpy(words, &vertex, sizeof(words));
+        uint64_t hash = 0x9e3779b97f4a7c15ull;
+        for (uint64_t word : words)
+            hash = mix(hash ^ word) * 0x9e3779b97f4a7c15ull;
+        return (uint32_t)mix(hash);
+    }
+
+    auto nextPowerOfTwo(uint32_t value) -> uint32_t
+    {
+        uint32_t result = 1;
+        while (result < value)
+            result <<= 1;
+        return result;
+    }
+}
+
+VertexWelder::Stats VertexWelder::weld(const std::vector<PositionColorVertex>& corners,
+    std::vector<PositionColorVertex>& vertices, std::vector<uint32_t>& indices)
+{
+    CPU_PROFILE_ZONE("VertexWelder::weld");
+    auto start = std::chrono::steady_clock::now();
+
+    uint32_t count = (uint32_t)corners.size();
+    uint32_t chunks = (count + _grain - 1) / _grain;
+    auto jobs = JobSystem::Get();
+
+    // Hash every corner and bucket it by the top bits of its hash. Identical vertices always land in the
+    // same partition, so partitions are welded independently. Chunks keep their corners in ascending order.
+    std::vector<uint32_t> hashes(count);
+    std::vector<std::array<std::vector<uint32_t>, _partitionCount>> chunkPartitions(chunks);
+    jobs->parallelFor(count, _grain, [&](uint32_t begin, uint32_t end)
+    {
+        auto& partitions = chunkPartitions[begin / _grain];
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            hashes[i] = hashVertex(corners[i]);
+            partitions[hashes[i] >> (32 - _partitionBits)].push_back(i);
+        }
+    });
+
+    // Open addressing with linear probing. The first corner seen of each vertex becomes its representative,
+    // visiting chunks in order makes that the lowest corner index, as in a sequential weld.
+    std::vector<uint32_t> representatives(count);
+    jobs->parallelFor(_partitionCount, 1, [&](uint32_t begin, uint32_t end)
+    {
+        std::vector<uint32_t> table;
+        for (uint32_t partition = begin; partition < end; ++partition)
+        {
+            size_t partitionSize = 0;
+            for (const auto& it : chunkPartitions)
+                partitionSize += it[partition].size();
+            if (partitionSize == 0)
+                continue;
+
+            uint32_t mask = nextPowerOfTwo((uint32_t)partitionSize * 2) - 1;
+            table.assign((size_t)mask + 1, _empty);
+            for (const auto& chunk : chunkPartitions)
+            {
+                for (uint32_t corner : chunk[partition])
+                {
+                    uint32_t hash = hashes[corner];
+                    for (uint32_t slot = hash & mask;; slot = (slot + 1) & mask)
+                    {
+                        uint32_t entry = table[slot];
+                        if (entry == _empty)
+                        {
+                            table[slot] = corner;
+                            representatives[corner] = corner;
+                            break;
+                        }
+                        if (hashes[entry] == hash && memcmp(&corners[entry], &corners[corner], sizeof(PositionColorVertex)) == 0)
+                        {
+                            representatives[corner] = entry;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+    });
+    chunkPartitions.clear();
+
+    // Number the representatives in corner order: count per chunk, scan, then assign
+    std::vector<uint32_t> chunkOffsets(chunks + 1, 0);
+    jobs->parallelFor(count, _grain, [&](uint32_t begin, uint32_t end)
+    {
+        uint32_t unique = 0;
+        for (uint32_t i = begin; i < end; ++i)
+            unique += representatives[i] == i;
+        chunkOffsets[begin / _grain + 1] = unique;
+    });
+    for (uint32_t i = 0; i < chunks; ++i)
+        chunkOffsets[i + 1] += chunkOffsets[i];
+
+    // hashes is not needed anymore and becomes the corner to vertex remap
+    std::vector<uint32_t>& remap = hashes;
+    vertices.resize(chunkOffsets[chunks]);
+    jobs->parallelFor(count, _grain, [&](uint32_t begin, uint32_t end)
+    {
+        uint32_t next = chunkOffsets[begin / _grain];
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            if (representatives[i] == i)
+            {
+                vertices[next] = corners[i];
+                remap[i] = next++;
+            }
+        }
+    });
+
+    // A representative always precedes or is the corner, and was numbered in the pass above
+    indices.resize(count);
+    jobs->parallelFor(count, _grain, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+            indices[i] = remap[representatives[i]];
+    });
+
+    Stats stats;
+    stats.m_corners = count;
+    stats.m_uniqueVertices = (uint32_t)vertices.size();
+    stats.m_milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
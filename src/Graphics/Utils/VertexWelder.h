@@ -0,0 +1,26 @@
+#pragma once
+
+#include <Oblivion.h>
+#include "../Vertex/PositionColorVertex.h"
+
+/// <summary>
+///     Merges bitwise identical vertices of an unindexed corner stream.
+///     Runs on the JobSystem and produces the same output as a sequential first occurrence weld.
+/// </summary>
+namespace VertexWelder
+{
+    struct Stats
+    {
+        uint32_t        m_corners = 0;
+        uint32_t        m_uniqueVertices = 0;
+        double          m_milliseconds = 0.0;
+
+        auto            getCornersPerSecond() const -> double { return m_milliseconds > 0.0 ? m_corners * 1000.0 / m_milliseconds : 0.0; };
+    };
+
+    /// <summary>
+    ///     Fills vertices with the unique corners, in order of first occurrence, and indices with one entry per corner
+    /// </summary>
+    Stats weld(const std::vector<PositionColorVertex>& corners,
+        std::vector<PositionColorVertex>& vertices, std::vector<uint32_t>& indices);
+}
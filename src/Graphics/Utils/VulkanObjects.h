@@ -6,7 +6,9 @@
 enum class QueueFamilyType
 { // Might add more
     eGraphics,
-    ePresent
+    ePresent,
+    eTransfer,
+    eCompute
 };
 
 
@@ -17,16 +19,23 @@ struct DeviceInfo
     vk::PhysicalDeviceFeatures          m_enabledFeatures;
     vk::SampleCountFlagBits             m_bestSampling;
     struct
-    {
+    { // graphics and present must stay first, they're handed to the swapchain as an array
         uint32_t graphicsIndex;
         uint32_t presentIndex;
+        uint32_t transferIndex;     // Transfer only family if there's one, graphicsIndex otherwise
+        uint32_t computeIndex;      // Compute without graphics if there's one, graphicsIndex otherwise
     }									m_families;
     struct
     {
         vk::Queue graphicsQueue;
         vk::Queue presentQueue;
+        vk::Queue transferQueue;
+        vk::Queue computeQueue;
     }									m_queues;
 
+    auto hasDedicatedTransferQueue() const -> bool { return m_families.transferIndex != m_families.graphicsIndex; }
+    auto hasDedicatedComputeQueue() const -> bool { return m_families.computeIndex != m_families.graphicsIndex; }
+
 };
 
 
@@ -0,0 +1,108 @@
+#pragma once
+
+
+#include <Oblivion.h>
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+/// <summary>
+///     Per instance index into the instance transforms, read from its own vertex binding with an instance input rate.
+///     The vertex shader fetches the world matrix from the storage buffer holding every instance
+/// </summary>
+class InstanceIndex
+{
+public:
+    InstanceIndex() = default;
+    InstanceIndex(uint32_t index) : index(index) {};
+
+
+    static constexpr uint32_t getVertexSize()
+    {
+        return sizeof(decltype(index));
+    };
+
+    static auto getAttributeDescription()->std::vector<vk::VertexInputAttributeDescription>*
+    {
+        static std::vector<vk::VertexInputAttributeDescription> inputAttributeDescription =
+        {
+                                        // Location    Binding                 Format                               offset
+            vk::VertexInputAttributeDescription(0,          0,        vk::Format::eR32Uint,                          0)
+        };
+        return &inputAttributeDescription;
+    }
+
+    static auto getBindingDescription()->std::vector<vk::VertexInputBindingDescription>*
+    {
+        static std::vector<vk::VertexInputBindingDescription> inputBindingDescription =
+        {
+                                        // Binding            Stride                              InputRate
+            vk::VertexInputBindingDescription(0,           getVertexSize(),              vk::VertexInputRate::eInstance)
+        };
+        return &inputBindingDescription;
+    }
+
+public:
+    uint32_t index;
+
+};
+
+
+/// <summary>
+///     Vertex type of an instanced pipeline: VertexType's bindings come first, InstanceType's follow with their
+///     bindings and locations shifted past them. Vertex shaders declare the instance inputs after the vertex ones.
+/// </summary>
+template <class VertexType, class InstanceType>
+class InstancedVertex
+{
+public:
+    static auto getVertexInputStateCreateInfo() -> vk::PipelineVertexInputStateCreateInfo
+    {
+        auto attributeDescription = getAttributeDescription();
+        auto bindingDescription = getBindingDescription();
+        vk::PipelineVertexInputStateCreateInfo vertexState = {};
+        vertexState.setVertexBindingDescriptionCount((uint32_t)bindingDescription->size()).setPVertexBindingDescriptions(bindingDescription->data())
+            .setVertexAttributeDescriptionCount((uint32_t)attributeDescription->size()).setPVertexAttributeDescriptions(attributeDescription->data());
+        return vertexState;
+    }
+
+    static auto getAttributeDescription()->std::vector<vk::VertexInputAttributeDescription>*
+    {
+        static std::vector<vk::VertexInputAttributeDescription> inputAttributeDescription = []()
+        {
+            auto result = *VertexType::getAttributeDescription();
+            uint32_t firstLocation = (uint32_t)result.size();
+            uint32_t firstBinding = getInstanceBinding();
+            for (auto it : *InstanceType::getAttributeDescription())
+            {
+                it.setLocation(it.location + firstLocation).setBinding(it.binding + firstBinding);
+                result.push_back(it);
+            }
+            return result;
+        }();
+        return &inputAttributeDescription;
+    }
+
+    static auto getBindingDescription()->std::vector<vk::VertexInputBindingDescription>*
+    {
+        static std::vector<vk::VertexInputBindingDescription> inputBindingDescription = []()
+        {
+            auto result = *VertexType::getBindingDescription();
+            uint32_t firstBinding = getInstanceBinding();
+            for (auto it : *InstanceType::getBindingDescription())
+            {
+                it.setBinding(it.binding + firstBinding);
+                result.push_back(it);
+            }
+            return result;
+        }();
+        return &inputBindingDescription;
+    }
+
+    /// <summary>
+    ///     Binding to bind the instance buffer to
+    /// </summary>
+    static auto getInstanceBinding() -> uint32_t
+    {
+        return (uint32_t)VertexType::getBindingDescription()->size();
+    }
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+
+#include <Oblivion.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include "PositionColorVertex.h"
+
+/// <summary>
+///     12 byte replacement for PositionColorVertex. Position is unorm16 within the mesh bounds, dequantized by
+///     getDequantizeTransform folded into the world matrix. UV is half float, so tiling coordinates survive.
+///     Reads as the same vec4 inputs as PositionColorVertex, the shaders don't change.
+/// </summary>
+class PackedPositionUVVertex
+{
+public:
+    PackedPositionUVVertex() = default;
+    PackedPositionUVVertex(const PositionColorVertex& vertex, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+    {
+        glm::vec3 extent = boundsMax - boundsMin;
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            float normalized = extent[i] > 0.0f ? (vertex.position[i] - boundsMin[i]) / extent[i] : 0.0f;
+            position[i] = (uint16_t)(glm::clamp(normalized, 0.0f, 1.0f) * 65535.0f + 0.5f);
+        }
+        position[3] = 65535; // w = 1
+        uv = glm::packHalf2x16(glm::vec2(vertex.color));
+    };
+
+
+    static constexpr uint32_t getVertexSize()
+    {
+        return sizeof(decltype(position)) + sizeof(decltype(uv));
+    };
+
+    /// <summary>
+    ///     Maps the unorm position back into the bounds, apply it before the world matrix
+    /// </summary>
+    static auto getDequantizeTransform(const glm::vec3& boundsMin, const glm::vec3& boundsMax) -> glm::mat4
+    {
+        return glm::scale(glm::translate(glm::mat4(1.0f), boundsMin), boundsMax - boundsMin);
+    }
+
+    static auto getVertexInputStateCreateInfo() -> vk::PipelineVertexInputStateCreateInfo
+    {
+        auto attributeDescription = getAttributeDescription();
+        auto bindingDescription = getBindingDescription();
+        vk::PipelineVertexInputStateCreateInfo vertexState = {};
+        vertexState.setVertexBindingDescriptionCount((uint32_t)bindingDescription->size()).setPVertexBindingDescriptions(bindingDescription->data())
+            .setVertexAttributeDescriptionCount((uint32_t)attributeDescription->size()).setPVertexAttributeDescriptions(attributeDescription->data());
+        return vertexState;
+    }
+
+    static auto getAttributeDescription()->std::vector<vk::VertexInputAttributeDescription>*
+    {
+        static std::vector<vk::VertexInputAttributeDescription> inputAttributeDescription =
+        {
+                                        // Location    Binding                 Format                               offset
+            vk::VertexInputAttributeDescription(0,          0,        vk::Format::eR16G16B16A16Unorm,                0),
+            vk::VertexInputAttributeDescription(1,          0,        vk::Format::eR16G16Sfloat,              sizeof(position))
+        };
+        return &inputAttributeDescription;
+    }
+
+    static auto getBindingDescription()->std::vector<vk::VertexInputBindingDescription>*
+    {
+        static std::vector<vk::VertexInputBindingDescription> inputBindingDescription =
+        {
+                                        // Binding            Stride                              InputRate
+            vk::VertexInputBindingDescription(0,           getVertexSize(),              vk::VertexInputRate::eVertex)
+        };
+        return &inputBindingDescription;
+    }
+
+    bool operator == (const PackedPositionUVVertex& rhs) const
+    {
+        return memcmp(this, &rhs, sizeof(PackedPositionUVVertex)) == 0;
+    }
+
+public:
+    uint16_t position[4];
+    uint32_t uv;
+
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+
+#include <Oblivion.h>
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include "PackedPositionUVVertex.h"
+
+/// <summary>
+///     Position only view of a PackedPositionUVVertex buffer, for depth only pipelines. Keeps the packed stride,
+///     so the same vertex buffer is bound and the UV is simply skipped.
+/// </summary>
+class PackedPositionVertex
+{
+public:
+    static constexpr uint32_t getVertexSize()
+    {
+        return PackedPositionUVVertex::getVertexSize();
+    };
+
+    static auto getVertexInputStateCreateInfo() -> vk::PipelineVertexInputStateCreateInfo
+    {
+        auto attributeDescription = getAttributeDescription();
+        auto bindingDescription = getBindingDescription();
+        vk::PipelineVertexInputStateCreateInfo vertexState = {};
+        vertexState.setVertexBindingDescriptionCount((uint32_t)bindingDescription->size()).setPVertexBindingDescriptions(bindingDescription->data())
+            .setVertexAttributeDescriptionCount((uint32_t)attributeDescription->size()).setPVertexAttributeDescriptions(attributeDescription->data());
+        return vertexState;
+    }
+
+    static auto getAttributeDescription()->std::vector<vk::VertexInputAttributeDescription>*
+    {
+        static std::vector<vk::VertexInputAttributeDescription> inputAttributeDescription =
+        {
+                                        // Location    Binding                 Format                               offset
+            vk::VertexInputAttributeDescription(0,          0,        vk::Format::eR16G16B16A16Unorm,                0)
+        };
+        return &inputAttributeDescription;
+    }
+
+    static auto getBindingDescription()->std::vector<vk::VertexInputBindingDescription>*
+    {
+        static std::vector<vk::VertexInputBindingDescription> inputBindingDescription =
+        {
+                                        // Binding            Stride                              InputRate
+            vk::VertexInputBindingDescription(0,           getVertexSize(),              vk::VertexInputRate::eVertex)
+        };
+        return &inputBindingDescription;
+    }
+};
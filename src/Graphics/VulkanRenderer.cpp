@@ -3,8 +3,13 @@
 #include "Utils/VulkanAllocators.h"
 #include "Utils/BufferUtils.h"
 #include "Utils/OneTimeCommandBuffers.h"
+#include "Utils/GpuProfiler.h"
+#include "Utils/UploadManager.h"
+#include "Utils/PipelineCache.h"
+#include "Utils/PipelineRegistry.h"
 
 #include "../Core/Window.h"
+#include "../Core/CpuProfiler.h"
 
 #include "Utils/Samplers.h"
 
@@ -18,6 +23,10 @@ std::vector<const char*> deviceEnabledExtensions =
     VK_KHR_SWAPCHAIN_EXTENSION_NAME
 };
 
+std::vector<const char*> headlessDeviceEnabledExtensions =
+{
+};
+
 VulkanRenderer::VulkanRenderer()
 {
     m_presentLayers = vk::enumerateInstanceLayerProperties();
@@ -36,9 +45,12 @@ VulkanRenderer::~VulkanRenderer()
     }
 
     clearSwapchainImageViews();
-    m_vulkanDevice.m_logicalDevice.destroySwapchainKHR(m_swapchain);
+    clearOffscreenImages();
+    if (m_swapchain)
+        m_vulkanDevice.m_logicalDevice.destroySwapchainKHR(m_swapchain);
 
-    m_vulkanInstance.destroySurfaceKHR(m_renderingSurface);
+    if (m_renderingSurface)
+        m_vulkanInstance.destroySurfaceKHR(m_renderingSurface);
 
     vmaDestroyAllocator(g_allocator);
 
@@ -50,10 +62,13 @@ VulkanRenderer::~VulkanRenderer()
     m_vulkanInstance.destroy();
 }
 
-auto VulkanRenderer::create(uint32_t width, uint32_t height) -> void
+auto VulkanRenderer::create(uint32_t width, uint32_t height, bool headless) -> void
 {
+    m_headless = headless;
+
     createInstance();
-    createSurface();
+    if (!m_headless)
+        createSurface();
     createDevice();
     createAllocators();
     createSyncObjects();
@@ -63,19 +78,38 @@ auto VulkanRenderer::create(uint32_t width, uint32_t height) -> void
 
 auto VulkanRenderer::onSize(uint32_t width, uint32_t height) -> void
 {
-    m_vulkanDevice.m_logicalDevice.waitIdle();
+    CPU_PROFILE_ZONE("VulkanRenderer::onSize");
+    wait();
 
     clearSwapchainImageViews();
+    clearOffscreenImages();
     querySwapchainCreateInfo(width, height);
-    createSwapchain(width, height);
+    if (m_headless)
+        createOffscreenImages(width, height);
+    else
+        createSwapchain(width, height);
+    createSwapchainImageViews();
     for (const auto it : m_frameDependentObjects)
         it->recreate(m_swapchainCreateInfo.m_imageCount, width, height);
 }
 
 auto VulkanRenderer::acquire() -> void
 {
-    m_vulkanDevice.m_logicalDevice.waitForFences(1, &m_inFlightFence[m_inFlightFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+    CPU_PROFILE_ZONE("VulkanRenderer::acquire");
+    {
+        CPU_PROFILE_ZONE("waitForFences");
+        m_vulkanDevice.m_logicalDevice.waitForFences(1, &m_inFlightFence[m_inFlightFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+    }
     m_vulkanDevice.m_logicalDevice.resetFences(1, &m_inFlightFence[m_inFlightFrame]);
+    GpuProfiler::Get()->collect(m_inFlightFrame);
+    UploadManager::Get()->collect();
+    if (m_headless)
+    { // No presentation engine, just cycle through the offscreen images
+        m_currentFrame = (m_currentFrame + 1) % m_swapchainCreateInfo.m_imageCount;
+        updateFrameDependentObjects(m_currentFrame);
+        return;
+    }
+    CPU_PROFILE_ZONE("acquireNextImageKHR");
     vk::ResultValue<uint32_t> imageIndex = m_vulkanDevice.m_logicalDevice.acquireNextImageKHR(m_swapchain, std::numeric_limits<uint64_t>::max(),
         m_imageAvailableSemaphore[m_inFlightFrame], nullptr);
     switch (imageIndex.result)
@@ -98,21 +132,37 @@ auto VulkanRenderer::acquire() -> void
 
 auto VulkanRenderer::render(IGraphicsScene* scene) -> void
 {
+    CPU_PROFILE_ZONE("VulkanRenderer::render");
     auto commandBuffers = scene->getCommandBuffers(m_currentFrame);
+    GpuProfiler::Get()->frameScope(commandBuffers, ++m_frameNumber);
+
+    // Pending uploads go first so this frame sees them
+    UploadManager::Get()->flush();
+
     vk::SubmitInfo submitInfo;
     submitInfo.setCommandBufferCount((uint32_t)commandBuffers.size());
     submitInfo.setPCommandBuffers(commandBuffers.data());
-    submitInfo.setWaitSemaphoreCount(1);
-    submitInfo.setPWaitSemaphores(&m_imageAvailableSemaphore[m_inFlightFrame]);
-    submitInfo.setSignalSemaphoreCount(1);
-    submitInfo.setPSignalSemaphores(&m_renderingFinishedSemaphore[m_inFlightFrame]);
     vk::PipelineStageFlags waitFlags[] = { vk::PipelineStageFlagBits::eTopOfPipe };
-    submitInfo.setPWaitDstStageMask(waitFlags);
+    if (!m_headless)
+    { // Offscreen images are never acquired or presented, so there's nothing to wait for
+        submitInfo.setWaitSemaphoreCount(1);
+        submitInfo.setPWaitSemaphores(&m_imageAvailableSemaphore[m_inFlightFrame]);
+        submitInfo.setSignalSemaphoreCount(1);
+        submitInfo.setPSignalSemaphores(&m_renderingFinishedSemaphore[m_inFlightFrame]);
+        submitInfo.setPWaitDstStageMask(waitFlags);
+    }
     m_vulkanDevice.m_queues.graphicsQueue.submit(1, &submitInfo, m_inFlightFence[m_inFlightFrame]);
 }
 
 auto VulkanRenderer::present() -> void
 {
+    CPU_PROFILE_ZONE("VulkanRenderer::present");
+    if (m_headless)
+    {
+        m_inFlightFrame = (m_inFlightFrame + 1) % _maxInFlightFrames;
+        return;
+    }
+
     vk::PresentInfoKHR presentInfo;
     presentInfo.setSwapchainCount(1);
     presentInfo.setPSwapchains(&m_swapchain);
@@ -126,6 +176,7 @@ auto VulkanRenderer::present() -> void
 
 auto VulkanRenderer::wait() -> void
 {
+    CPU_PROFILE_ZONE("waitIdle");
     m_vulkanDevice.m_logicalDevice.waitIdle();
 }
 
@@ -203,6 +254,27 @@ auto VulkanRenderer::getVulkanSwapchainCreateInfo() const -> const SwapchainCrea
     return m_swapchainCreateInfo;
 }
 
+auto VulkanRenderer::getPresentLayout() const -> vk::ImageLayout
+{
+    // Offscreen images are read back instead of presented
+    return m_headless ? vk::ImageLayout::eTransferSrcOptimal : vk::ImageLayout::ePresentSrcKHR;
+}
+
+auto VulkanRenderer::isHeadless() const -> bool
+{
+    return m_headless;
+}
+
+auto VulkanRenderer::getFrameNumber() const -> uint64_t
+{
+    return m_frameNumber;
+}
+
+auto VulkanRenderer::getInFlightFrame() const -> uint32_t
+{
+    return m_inFlightFrame;
+}
+
 auto VulkanRenderer::createInstance() -> void
 {
     vk::ApplicationInfo appInfo = {};
@@ -231,6 +303,7 @@ auto VulkanRenderer::createSurface() -> void
 
 auto VulkanRenderer::createDevice() -> void
 {
+    const auto& enabledExtensions = m_headless ? headlessDeviceEnabledExtensions : deviceEnabledExtensions;
     auto devices = m_vulkanInstance.enumeratePhysicalDevices();
     for (const auto& device : devices)
     {
@@ -249,7 +322,7 @@ auto VulkanRenderer::createDevice() -> void
 
         auto deviceExtensions = device.enumerateDeviceExtensionProperties();
         good = true;
-        for (const auto& it : deviceEnabledExtensions)
+        for (const auto& it : enabledExtensions)
         {
             deviceExtensions[0].extensionName;
             if (!CHECK_IF_STR_IN_ARRAY_COMPLEX(it, deviceExtensions, extensionName))
@@ -268,7 +341,8 @@ auto VulkanRenderer::createDevice() -> void
         auto queueFamilies = m_vulkanDevice.m_physicalDevice.getQueueFamilyProperties();
         for (uint32_t i = 0; i < queueFamilies.size(); ++i)
         {
-            vk::Bool32 canPresent = m_vulkanDevice.m_physicalDevice.getSurfaceSupportKHR(i, m_renderingSurface);
+            vk::Bool32 canPresent = m_headless ? VK_TRUE :
+                m_vulkanDevice.m_physicalDevice.getSurfaceSupportKHR(i, m_renderingSurface);
             if (canPresent && queueFamilies[i].queueFlags & vk::QueueFlagBits::eGraphics)
             {
                 m_vulkanDevice.m_families.presentIndex = i;
@@ -277,8 +351,28 @@ auto VulkanRenderer::createDevice() -> void
             else if (queueFamilies[i].queueFlags & vk::QueueFlagBits::eGraphics)
                 m_vulkanDevice.m_families.graphicsIndex = i;
         }
-        VkSampleCountFlags sampling = std::min(static_cast<VkSampleCountFlags>(deviceProperties.limits.framebufferColorSampleCounts),
-            static_cast<VkSampleCountFlags>(deviceProperties.limits.framebufferDepthSampleCounts));
+        // Queues that can run beside graphics, falling back to the graphics queue
+        m_vulkanDevice.m_families.transferIndex = m_vulkanDevice.m_families.graphicsIndex;
+        m_vulkanDevice.m_families.computeIndex = m_vulkanDevice.m_families.graphicsIndex;
+        bool dedicatedTransfer = false;
+        for (uint32_t i = 0; i < queueFamilies.size(); ++i)
+        {
+            auto flags = queueFamilies[i].queueFlags;
+            if (flags & vk::QueueFlagBits::eGraphics)
+                continue;
+            if ((flags & vk::QueueFlagBits::eTransfer) && !dedicatedTransfer)
+            { // Prefer a pure transfer family (DMA engine) over a compute one
+                m_vulkanDevice.m_families.transferIndex = i;
+                dedicatedTransfer = !(flags & vk::QueueFlagBits::eCompute);
+            }
+            if ((flags & vk::QueueFlagBits::eCompute) &&
+                m_vulkanDevice.m_families.computeIndex == m_vulkanDevice.m_families.graphicsIndex)
+                m_vulkanDevice.m_families.computeIndex = i;
+        }
+        // The depth pyramid samples the depth attachment, so its sample count must also be readable from a shader
+        VkSampleCountFlags sampling = static_cast<VkSampleCountFlags>(deviceProperties.limits.framebufferColorSampleCounts) &
+            static_cast<VkSampleCountFlags>(deviceProperties.limits.framebufferDepthSampleCounts) &
+            static_cast<VkSampleCountFlags>(deviceProperties.limits.sampledImageDepthSampleCounts);
 
         if (sampling & VkSampleCountFlagBits::VK_SAMPLE_COUNT_64_BIT) { m_vulkanDevice.m_bestSampling = vk::SampleCountFlagBits::e64; }
         else if (sampling & VkSampleCountFlagBits::VK_SAMPLE_COUNT_32_BIT) { m_vulkanDevice.m_bestSampling = vk::SampleCountFlagBits::e32; }
@@ -295,23 +389,26 @@ auto VulkanRenderer::createDevice() -> void
 
     std::unordered_set<decltype(m_vulkanDevice.m_families.graphicsIndex)> families{
         m_vulkanDevice.m_families.graphicsIndex,
-        m_vulkanDevice.m_families.presentIndex
+        m_vulkanDevice.m_families.presentIndex,
+        m_vulkanDevice.m_families.transferIndex,
+        m_vulkanDevice.m_families.computeIndex
     };
     
     uint32_t numberOfIndices = (uint32_t)families.size();
     std::vector<vk::DeviceQueueCreateInfo> queues;
-    queues.resize(numberOfIndices);
-    for (uint32_t i = 0; i < numberOfIndices; ++i)
+    queues.reserve(numberOfIndices);
+    static const float priority = 1.0f;
+    for (auto family : families)
     {
-        float priority = 1.0f;
-        queues[i].setPQueuePriorities(&priority);
-        queues[i].setQueueCount(1);
-        queues[i].setQueueFamilyIndex(*((decltype(m_vulkanDevice.m_families.graphicsIndex)*)&m_vulkanDevice.m_families + i));
+        queues.emplace_back();
+        queues.back().setPQueuePriorities(&priority);
+        queues.back().setQueueCount(1);
+        queues.back().setQueueFamilyIndex(family);
     }
 
     vk::DeviceCreateInfo deviceInfo = {};
-    deviceInfo.setEnabledExtensionCount((uint32_t)deviceEnabledExtensions.size())
-        .setPpEnabledExtensionNames(deviceEnabledExtensions.data())
+    deviceInfo.setEnabledExtensionCount((uint32_t)enabledExtensions.size())
+        .setPpEnabledExtensionNames(enabledExtensions.data())
         .setEnabledLayerCount((uint32_t)deviceEnabledLayers.size())
         .setPpEnabledLayerNames(deviceEnabledLayers.data())
         .setPQueueCreateInfos(queues.data())
@@ -322,6 +419,13 @@ auto VulkanRenderer::createDevice() -> void
 
     m_vulkanDevice.m_queues.graphicsQueue = m_vulkanDevice.m_logicalDevice.getQueue(m_vulkanDevice.m_families.graphicsIndex, 0);
     m_vulkanDevice.m_queues.presentQueue = m_vulkanDevice.m_logicalDevice.getQueue(m_vulkanDevice.m_families.presentIndex, 0);
+    m_vulkanDevice.m_queues.transferQueue = m_vulkanDevice.m_logicalDevice.getQueue(m_vulkanDevice.m_families.transferIndex, 0);
+    m_vulkanDevice.m_queues.computeQueue = m_vulkanDevice.m_logicalDevice.getQueue(m_vulkanDevice.m_families.computeIndex, 0);
+
+    if (m_vulkanDevice.hasDedicatedTransferQueue())
+        NOTE(appendToString("Using queue family ", m_vulkanDevice.m_families.transferIndex, " for transfers"));
+    if (m_vulkanDevice.hasDedicatedComputeQueue())
+        NOTE(appendToString("Using queue family ", m_vulkanDevice.m_families.computeIndex, " for async compute"));
 }
 
 auto VulkanRenderer::createAllocators() -> void
@@ -373,9 +477,40 @@ auto VulkanRenderer::createSwapchain(uint32_t width, uint32_t height) -> void
     }
     m_swapchain = newSwapchain;
 
-
-    // Create image views for images
     m_swapchainInfo.m_images = m_vulkanDevice.m_logicalDevice.getSwapchainImagesKHR(m_swapchain);
+}
+
+auto VulkanRenderer::createOffscreenImages(uint32_t width, uint32_t height) -> void
+{
+    vk::ImageCreateInfo imageInfo;
+    imageInfo.setArrayLayers(1).setMipLevels(1)
+        .setFormat(m_swapchainCreateInfo.m_format.format)
+        .setImageType(vk::ImageType::e2D).setInitialLayout(vk::ImageLayout::eUndefined)
+        .setSamples(vk::SampleCountFlagBits::e1).setTiling(vk::ImageTiling::eOptimal)
+        .setExtent(vk::Extent3D(m_swapchainCreateInfo.m_extent.width, m_swapchainCreateInfo.m_extent.height, 1))
+        .setUsage(vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc)
+        .setPQueueFamilyIndices(&m_vulkanDevice.m_families.graphicsIndex).setQueueFamilyIndexCount(1)
+        .setSharingMode(vk::SharingMode::eExclusive);
+
+    VmaAllocationCreateInfo allocationInfo = {};
+    allocationInfo.requiredFlags = (VkMemoryPropertyFlags)vk::MemoryPropertyFlagBits::eDeviceLocal;
+
+    m_swapchainInfo.m_images.reserve(m_swapchainCreateInfo.m_imageCount);
+    m_offscreenAllocations.reserve(m_swapchainCreateInfo.m_imageCount);
+    for (uint32_t i = 0; i < m_swapchainCreateInfo.m_imageCount; ++i)
+    {
+        vk::Image image;
+        VmaAllocation allocation;
+        VkResult res = vmaCreateImage(g_allocator, (VkImageCreateInfo*)&imageInfo, &allocationInfo,
+            (VkImage*)&image, &allocation, nullptr);
+        EVALUATE(res, VkResult::VK_SUCCESS, != , "Couldn't create offscreen image %d", i);
+        m_swapchainInfo.m_images.push_back(image);
+        m_offscreenAllocations.push_back(allocation);
+    }
+}
+
+auto VulkanRenderer::createSwapchainImageViews() -> void
+{
     m_swapchainInfo.m_imageViews.reserve(m_swapchainInfo.m_images.size());
     for (const auto it : m_swapchainInfo.m_images)
     {
@@ -425,6 +560,15 @@ auto VulkanRenderer::updateFrameDependentObjects(uint32_t currentImage) -> void
 
 auto VulkanRenderer::querySwapchainCreateInfo(uint32_t width, uint32_t height) -> void
 {
+    if (m_headless)
+    {
+        m_swapchainCreateInfo.m_format = vk::SurfaceFormatKHR(vk::Format::eR8G8B8A8Unorm, vk::ColorSpaceKHR::eSrgbNonlinear);
+        m_swapchainCreateInfo.m_presentMode = vk::PresentModeKHR::eImmediate;
+        m_swapchainCreateInfo.m_extent = vk::Extent2D(width, height);
+        m_swapchainCreateInfo.m_imageCount = _headlessImageCount;
+        return;
+    }
+
     m_swapchainCapabilities.m_formats = m_vulkanDevice.m_physicalDevice.getSurfaceFormatsKHR(m_renderingSurface);
     m_swapchainCapabilities.m_presentModes = m_vulkanDevice.m_physicalDevice.getSurfacePresentModesKHR(m_renderingSurface);
     m_swapchainCapabilities.m_surfaceCapabilities = m_vulkanDevice.m_physicalDevice.getSurfaceCapabilitiesKHR(m_renderingSurface);
@@ -436,8 +580,12 @@ auto VulkanRenderer::querySwapchainCreateInfo(uint32_t width, uint32_t height) -
 
 auto VulkanRenderer::destroyUtilities() -> void
 {
+    UploadManager::reset();
     OneTimeCommandBuffers::reset();
     Samplers::reset();
+    GpuProfiler::reset();
+    PipelineRegistry::reset();
+    PipelineCache::reset(); // Saves it to disk
 }
 
 auto VulkanRenderer::selectExtent(uint32_t width, uint32_t height) -> vk::Extent2D
@@ -495,3 +643,17 @@ auto VulkanRenderer::clearSwapchainImageViews() -> void
     }
     m_swapchainInfo.m_imageViews.clear();
 }
+
+auto VulkanRenderer::clearOffscreenImages() -> void
+{
+    if (!m_headless)
+        return;
+
+    for (uint32_t i = 0; i < m_offscreenAllocations.size(); ++i)
+    {
+        m_vulkanDevice.m_logicalDevice.destroyImage(m_swapchainInfo.m_images[i]);
+        vmaFreeMemory(g_allocator, m_offscreenAllocations[i]);
+    }
+    m_offscreenAllocations.clear();
+    m_swapchainInfo.m_images.clear();
+}
\ No newline at end of file
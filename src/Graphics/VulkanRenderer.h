@@ -17,6 +17,7 @@
 class VulkanRenderer : public ISingletone<VulkanRenderer>
 {
     static constexpr const uint8_t _maxInFlightFrames = 2;
+    static constexpr const uint32_t _headlessImageCount = 3;
     template <typename T>
     using InFlightArray = std::array<T, _maxInFlightFrames>;
 public:
@@ -24,7 +25,10 @@ public:
     ~VulkanRenderer();
 
 public:
-    auto									create(uint32_t, uint32_t) -> void;
+    static constexpr auto                   getMaxInFlightFrames() -> uint32_t { return _maxInFlightFrames; };
+
+public:
+    auto									create(uint32_t, uint32_t, bool headless = false) -> void;
     auto									onSize(uint32_t, uint32_t) -> void;
     auto                                    acquire() -> void;
     auto									render(IGraphicsScene* scene) -> void;
@@ -46,6 +50,10 @@ public:
     auto                                    getVulkanDeviceInfo() const -> const DeviceInfo&;
     auto                                    getVulkanSwapchainInfo() const -> const SwapchainInfo&;
     auto                                    getVulkanSwapchainCreateInfo() const -> const SwapchainCreateInfo&;
+    auto                                    getPresentLayout() const -> vk::ImageLayout;
+    auto                                    isHeadless() const -> bool;
+    auto                                    getFrameNumber() const -> uint64_t;
+    auto                                    getInFlightFrame() const -> uint32_t;
 
 private:
     auto									createInstance() -> void;
@@ -53,6 +61,8 @@ private:
     auto									createDevice() -> void;
     auto                                    createAllocators() -> void;
     auto									createSwapchain(uint32_t, uint32_t) -> void;
+    auto                                    createOffscreenImages(uint32_t, uint32_t) -> void;
+    auto                                    createSwapchainImageViews() -> void;
     auto									createSyncObjects() -> void;
 
 private:
@@ -69,6 +79,7 @@ private:
     auto									selectFormat()->vk::SurfaceFormatKHR;
     auto									selectPresentMode()->vk::PresentModeKHR;
     auto									clearSwapchainImageViews() -> void;
+    auto                                    clearOffscreenImages() -> void;
 
 public: // TODO: Make update things depending on these values
     bool                                    m_hasVsync = true;
@@ -85,11 +96,17 @@ private:
     SwapchainInfo                           m_swapchainInfo;
     vk::SwapchainKHR						m_swapchain;
 
+    // Headless mode renders into these instead of swapchain images
+    bool                                    m_headless = false;
+    std::vector<VmaAllocation>              m_offscreenAllocations;
+
 
     InFlightArray<vk::Semaphore>            m_imageAvailableSemaphore;
     InFlightArray<vk::Semaphore>            m_renderingFinishedSemaphore;
     InFlightArray<vk::Fence>                m_inFlightFence;
 
+    uint64_t                                m_frameNumber = 0;   // Of the last submission, GpuProfiler reports frame times under it
+
     
 private:
     std::vector<IFrameDependent*>           m_frameDependentObjects;
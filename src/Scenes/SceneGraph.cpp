@@ -0,0 +1,116 @@
+#include "SceneGraph.h"
+
+#include "../Core/CpuProfiler.h"
+
+
+auto SceneGraph::createNode(NodeId parent, const glm::mat4& local) -> NodeId
+{
+    NodeId node;
+    if (!m_freeIds.empty())
+    {
+        node = m_freeIds.back();
+        m_freeIds.pop_back();
+    }
+    else
+    {
+        node = (NodeId)m_indices.size();
+        m_indices.push_back(0);
+    }
+
+    uint32_t index = (uint32_t)m_nodes.size();
+    m_indices[node] = index;
+    m_nodes.push_back(node);
+    m_locals.push_back(local);
+    m_worlds.push_back(local);
+    m_parents.push_back(parent == _invalidNode ? _invalidNode : m_indices[parent]);
+    m_dirty.push_back(1);
+    m_firstDirty = std::min(m_firstDirty, index);
+    return node;
+}
+
+auto SceneGraph::destroyNode(NodeId node) -> void
+{
+    // Descendants follow their parent, so a forward pass from the node finds the whole subtree
+    uint32_t first = m_indices[node];
+    std::vector<uint32_t> remap(m_nodes.size() - first);
+    uint32_t write = first;
+    for (uint32_t read = first; read < m_nodes.size(); ++read)
+    {
+        uint32_t parent = m_parents[read];
+        bool removed = read == first || (parent != _invalidNode && parent >= first && remap[parent - first] == _invalidNode);
+        if (removed)
+        {
+            remap[read - first] = _invalidNode;
+            m_freeIds.push_back(m_nodes[read]);
+            continue;
+        }
+
+        remap[read - first] = write;
+        m_locals[write] = m_locals[read];
+        m_worlds[write] = m_worlds[read];
+        m_parents[write] = parent != _invalidNode && parent >= first ? remap[parent - first] : parent;
+        m_dirty[write] = m_dirty[read];
+        m_nodes[write] = m_nodes[read];
+        m_indices[m_nodes[write]] = write;
+        ++write;
+    }
+
+    m_locals.resize(write);
+    m_worlds.resize(write);
+    m_parents.resize(write);
+    m_dirty.resize(write);
+    m_nodes.resize(write);
+    if (m_firstDirty >= first)
+        m_firstDirty = first < write ? first : ~0u;
+}
+
+auto SceneGraph::reserve(uint32_t nodes) -> void
+{
+    m_locals.reserve(nodes);
+    m_worlds.reserve(nodes);
+    m_parents.reserve(nodes);
+    m_dirty.reserve(nodes);
+    m_nodes.reserve(nodes);
+    m_indices.reserve(nodes);
+}
+
+auto SceneGraph::setLocalTransform(NodeId node, const glm::mat4& local) -> void
+{
+    uint32_t index = m_indices[node];
+    m_locals[index] = local;
+    m_dirty[index] = 1;
+    m_firstDirty = std::min(m_firstDirty, index);
+}
+
+auto SceneGraph::getParent(NodeId node) const -> NodeId
+{
+    uint32_t parent = m_parents[m_indices[node]];
+    return parent == _invalidNode ? _invalidNode : m_nodes[parent];
+}
+
+auto SceneGraph::update() -> void
+{
+    m_updatedCount = 0;
+    if (m_firstDirty >= m_nodes.size())
+    {
+        m_firstDirty = ~0u;
+        return;
+    }
+
+    CPU_PROFILE_ZONE("SceneGraph::update");
+    // Nothing before the first dirty node can change. From there a node is dirty if it or its parent is,
+    // and its parent's world matrix is already final when it is reached
+    for (uint32_t i = m_firstDirty; i < m_nodes.size(); ++i)
+    {
+        uint32_t parent = m_parents[i];
+        if (parent != _invalidNode)
+            m_dirty[i] |= m_dirty[parent];
+        if (!m_dirty[i])
+            continue;
+
+        m_worlds[i] = parent != _invalidNode ? m_worlds[parent] * m_locals[i] : m_locals[i];
+        ++m_updatedCount;
+    }
+    std::fill(m_dirty.begin() + m_firstDirty, m_dirty.end(), (uint8_t)0);
+    m_firstDirty = ~0u;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+
+#include <Oblivion.h>
+#include <glm/glm.hpp>
+
+
+/// <summary>
+///     Transform hierarchy stored as parallel arrays, every parent before its children. Nodes are referred to
+///     by stable ids, their dense index may change when nodes are destroyed.
+///     update() recomputes the world matrices of dirty nodes and their descendants in one forward pass.
+/// </summary>
+class SceneGraph
+{
+public:
+    using NodeId = uint32_t;
+    static constexpr const NodeId _invalidNode = ~0u;
+
+public:
+    SceneGraph() = default;
+
+public:
+    /// <summary>
+    ///     Appends a node, so the parent always precedes it
+    /// </summary>
+    auto                                createNode(NodeId parent = _invalidNode, const glm::mat4& local = glm::mat4(1.0f)) -> NodeId;
+    /// <summary>
+    ///     Destroys the node and its whole subtree, keeping the order of the remaining nodes
+    /// </summary>
+    auto                                destroyNode(NodeId node) -> void;
+    auto                                reserve(uint32_t nodes) -> void;
+
+    auto                                setLocalTransform(NodeId node, const glm::mat4& local) -> void;
+    auto                                getLocalTransform(NodeId node) const -> const glm::mat4& { return m_locals[m_indices[node]]; };
+    // Valid as of the last update()
+    auto                                getWorldTransform(NodeId node) const -> const glm::mat4& { return m_worlds[m_indices[node]]; };
+    auto                                getParent(NodeId node) const -> NodeId;
+
+    auto                                update() -> void;
+
+    auto                                getNodeCount() const -> uint32_t { return (uint32_t)m_nodes.size(); };
+    auto                                getUpdatedCount() const -> uint32_t { return m_updatedCount; };
+
+private:
+    // Dense arrays, indexed by position in the hierarchy order
+    std::vector<glm::mat4>              m_locals;
+    std::vector<glm::mat4>              m_worlds;
+    std::vector<uint32_t>               m_parents;          // Dense index of the parent, or _invalidNode
+    std::vector<uint8_t>                m_dirty;
+    std::vector<NodeId>                 m_nodes;            // Id of each dense entry
+
+    // Id to dense index, ids of destroyed nodes are reused
+    std::vector<uint32_t>               m_indices;
+    std::vector<NodeId>                 m_freeIds;
+
+    uint32_t                            m_firstDirty = ~0u;
+    uint32_t                            m_updatedCount = 0;
+};
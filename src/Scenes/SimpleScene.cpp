@@ -2,14 +2,18 @@
 #include "../Graphics/VulkanRenderer.h"
 #include "../Graphics/Utils/Samplers.h"
 #include "../Graphics/Utils/VulkanAllocators.h"
+#include "../Graphics/Utils/GpuProfiler.h"
 
 #include "../Core/Input.h"
 #include "../Core/Window.h"
+#include "../Core/CpuProfiler.h"
+
+#include <glm/gtc/matrix_transform.hpp>
 
 SimpleScene::SimpleScene()
 {
     createRenderPass();
-    createCommandPool();
+    createCommandPools();
     createPipeline();
     loadModels();
     //WindowObject::Get()->toggleMouse();
@@ -20,25 +24,37 @@ SimpleScene::~SimpleScene()
 {
     frameCleanup();
     m_overlay.reset();
-    m_textureLayout.reset();
     m_pipeline.reset();
+    m_equalPipeline.reset();
+    m_depthPipeline.reset();
+    m_depthLayout.reset();
+    m_textureLayout.reset();
+    m_overdrawCounter.reset();
+    m_assetLoader.reset();
+    m_gpuCulling.reset();
+    m_depthPyramid.reset();
     m_model.reset();
     m_testImage.reset();
-    if (m_graphicsCommandPool)
+    for (const auto it : m_graphicsCommandPools)
     {
-        m_vulkanDevice.m_logicalDevice.destroyCommandPool(m_graphicsCommandPool);
-        m_graphicsCommandPool = nullptr;
+        m_vulkanDevice.m_logicalDevice.destroyCommandPool(it);
     }
+    m_graphicsCommandPools.clear();
     if (m_renderPass)
     {
         m_vulkanDevice.m_logicalDevice.destroyRenderPass(m_renderPass);
         m_renderPass = nullptr;
     }
+    if (m_lateRenderPass)
+    {
+        m_vulkanDevice.m_logicalDevice.destroyRenderPass(m_lateRenderPass);
+        m_lateRenderPass = nullptr;
+    }
 }
 
 std::vector<vk::CommandBuffer> SimpleScene::getCommandBuffers(uint32_t currentFrame)
 {
-    return std::vector<vk::CommandBuffer>{m_commandBuffers[currentFrame]};
+    return std::vector<vk::CommandBuffer>{m_commandBuffers[VulkanRenderer::Get()->getInFlightFrame()]};
 }
 
 void SimpleScene::create(uint32_t totalFrames, uint32_t width, uint32_t height)
@@ -47,25 +63,49 @@ void SimpleScene::create(uint32_t totalFrames, uint32_t width, uint32_t height)
     m_camera->setAspectRatio(glm::radians(60.f), (float)4.f / 3.f, 0.1f, 1000.f);
     createFramebuffers(totalFrames, width, height);
     m_pipeline->create(totalFrames, width, height); 
-    m_textureLayout->setImage(m_testImage.get(), Samplers::Get()->getLinearAnisotropicSampler());
-    allocateCommandBuffers(totalFrames, width, height);
+    m_equalPipeline->create(totalFrames, width, height);
+    m_depthPipeline->create(totalFrames, width, height);
+    if (m_textureBound)
+        m_textureLayout->setImage(m_testImage.get(), Samplers::Get()->getLinearAnisotropicSampler());
+    allocateCommandBuffers();
 }
 
 void SimpleScene::render(uint32_t frameIndex)
 {
     m_pipeline->render(frameIndex);
+
+    // The renderer already waited on this in-flight frame's fence, so everything it used is free again
+    auto inFlightFrame = VulkanRenderer::Get()->getInFlightFrame();
+    m_overdrawCounter->collect(inFlightFrame);
+    m_vulkanDevice.m_logicalDevice.resetCommandPool(m_graphicsCommandPools[inFlightFrame], vk::CommandPoolResetFlags());
+    m_textureLayout->update();
+    updateInstances();
+    recordCommandBuffers(m_commandBuffers[inFlightFrame], frameIndex);
 }
 
 void SimpleScene::frameCleanup()
 {
     m_pipeline->frameCleanup();
+    m_equalPipeline->frameCleanup();
+    m_depthPipeline->frameCleanup();
     cleanupCommandBuffers();
     cleanupFramebuffers();
 }
 
 auto SimpleScene::update(float frameTime) -> void
 {
-    if (WindowObject::Get()->mouseEnabled())
+    m_assetLoader->update();
+    if (!m_textureBound && m_testImage.isReady())
+    {
+        m_textureLayout->setImage(m_testImage.get(), Samplers::Get()->getLinearAnisotropicSampler());
+        m_textureBound = true;
+    }
+
+    if (m_cameraPath)
+    { // Scripted runs ignore the input state completely
+        m_cameraPath->step(m_camera.get());
+    }
+    else if (VulkanRenderer::Get()->isHeadless() || WindowObject::Get()->mouseEnabled())
     {
 
     }
@@ -106,25 +146,37 @@ auto SimpleScene::update(float frameTime) -> void
         m_camera->rotateUp(frameTime, (float)Input::Get()->getMouseY());
     }
     m_camera->construct();
-    m_textureLayout->setWorld(glm::mat4(1.0f));
+    m_sceneGraph.update();
+    // Instances carry the world matrices, the uniform one only dequantizes the model
+    m_textureLayout->setWorld(m_model.isReady() ? m_model.get()->getVertexTransform() : glm::mat4(1.0f));
     m_textureLayout->setView(m_camera->getView());
     m_textureLayout->setProjection(m_camera->getProjection());
-    m_textureLayout->update();
 
-    if (m_overlay->update(frameTime))
-    { // Rerecord command buffers
-        Logger::printToConsole("\n\nImGui requested redraw\n\n");
-        recordCommandBuffers();
-    }
+    m_overlay->update(frameTime);
+}
+
+auto SimpleScene::setCameraPath(CameraPath* path) -> void
+{
+    m_cameraPath = path;
 }
 
 auto SimpleScene::createRenderPass() -> void
 {
+    m_renderPass = createRenderPass(false);
+    m_lateRenderPass = createRenderPass(true);
+}
+
+auto SimpleScene::createRenderPass(bool late) -> vk::RenderPass
+{
+    // Both passes have the same attachments, so they're compatible and share the framebuffers and pipelines.
+    // The early one clears and leaves the depth readable by the pyramid build, the late one carries on and resolves
     auto format = VulkanRenderer::Get()->getVulkanSwapchainCreateInfo().m_format.format;
     vk::AttachmentDescription colorDescription = {};
     colorDescription.setFormat(format).setSamples(m_vulkanDevice.m_bestSampling)
-        .setInitialLayout(vk::ImageLayout::eUndefined).setFinalLayout(vk::ImageLayout::eColorAttachmentOptimal)
-        .setLoadOp(vk::AttachmentLoadOp::eClear).setStoreOp(vk::AttachmentStoreOp::eStore)
+        .setInitialLayout(late ? vk::ImageLayout::eColorAttachmentOptimal : vk::ImageLayout::eUndefined)
+        .setFinalLayout(vk::ImageLayout::eColorAttachmentOptimal)
+        .setLoadOp(late ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear)
+        .setStoreOp(late ? vk::AttachmentStoreOp::eDontCare : vk::AttachmentStoreOp::eStore)
         .setStencilLoadOp(vk::AttachmentLoadOp::eDontCare).setStencilStoreOp(vk::AttachmentStoreOp::eDontCare);
 
     vk::AttachmentReference colorReference = {};
@@ -133,8 +185,10 @@ auto SimpleScene::createRenderPass() -> void
 
     vk::AttachmentDescription depthDescription = {};
     depthDescription.setFormat(vk::Format::eD32Sfloat).setSamples(m_vulkanDevice.m_bestSampling)
-        .setInitialLayout(vk::ImageLayout::eUndefined).setFinalLayout(vk::ImageLayout::eDepthStencilAttachmentOptimal)
-        .setLoadOp(vk::AttachmentLoadOp::eClear).setStoreOp(vk::AttachmentStoreOp::eStore)
+        .setInitialLayout(late ? vk::ImageLayout::eDepthStencilReadOnlyOptimal : vk::ImageLayout::eUndefined)
+        .setFinalLayout(late ? vk::ImageLayout::eDepthStencilAttachmentOptimal : vk::ImageLayout::eDepthStencilReadOnlyOptimal)
+        .setLoadOp(late ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear)
+        .setStoreOp(late ? vk::AttachmentStoreOp::eDontCare : vk::AttachmentStoreOp::eStore)
         .setStencilLoadOp(vk::AttachmentLoadOp::eDontCare).setStencilStoreOp(vk::AttachmentStoreOp::eDontCare);
 
     vk::AttachmentReference depthReference = {};
@@ -147,54 +201,122 @@ auto SimpleScene::createRenderPass() -> void
 
     vk::AttachmentDescription resolveDescription = {};
     resolveDescription.setFormat(format).setSamples(vk::SampleCountFlagBits::e1)
-        .setInitialLayout(vk::ImageLayout::eUndefined).setFinalLayout(vk::ImageLayout::ePresentSrcKHR)
-        .setLoadOp(vk::AttachmentLoadOp::eDontCare).setStoreOp(vk::AttachmentStoreOp::eStore)
+        .setInitialLayout(vk::ImageLayout::eUndefined)
+        .setFinalLayout(late ? VulkanRenderer::Get()->getPresentLayout() : vk::ImageLayout::eColorAttachmentOptimal)
+        .setLoadOp(vk::AttachmentLoadOp::eDontCare)
+        .setStoreOp(late ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare)
         .setStencilLoadOp(vk::AttachmentLoadOp::eDontCare).setStencilStoreOp(vk::AttachmentStoreOp::eDontCare);
 
-    vk::SubpassDescription subpassDescription;
-    subpassDescription.setPipelineBindPoint(vk::PipelineBindPoint::eGraphics)
+    // Subpass 0 is the depth pre-pass, it stays empty when the pre-pass is off. Subpass 1 shades
+    std::array<vk::SubpassDescription, 2> subpassDescriptions;
+    subpassDescriptions[0].setPipelineBindPoint(vk::PipelineBindPoint::eGraphics)
+        .setColorAttachmentCount(0).setPColorAttachments(nullptr)
+        .setInputAttachmentCount(0).setPInputAttachments(nullptr)
+        .setPreserveAttachmentCount(0).setPPreserveAttachments(nullptr)
+        .setPDepthStencilAttachment(&depthReference)
+        .setPResolveAttachments(nullptr);
+    subpassDescriptions[1].setPipelineBindPoint(vk::PipelineBindPoint::eGraphics)
         .setColorAttachmentCount(1).setPColorAttachments(&colorReference)
         .setInputAttachmentCount(0).setPInputAttachments(nullptr)
         .setPreserveAttachmentCount(0).setPPreserveAttachments(nullptr)
         .setPDepthStencilAttachment(&depthReference)
         .setPResolveAttachments(&resolveReference);
 
+    // The pyramid build reads the early depth, the late pass writes it again once the build is done
+    std::array<vk::SubpassDependency, 3> dependencies;
+    dependencies[0].setSrcSubpass(0).setDstSubpass(1)
+        .setSrcStageMask(vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests)
+        .setSrcAccessMask(vk::AccessFlagBits::eDepthStencilAttachmentWrite)
+        .setDstStageMask(vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests)
+        .setDstAccessMask(vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite)
+        .setDependencyFlags(vk::DependencyFlagBits::eByRegion);
+    if (late)
+    {
+        dependencies[1].setSrcSubpass(VK_SUBPASS_EXTERNAL).setDstSubpass(0)
+            .setSrcStageMask(vk::PipelineStageFlagBits::eComputeShader)
+            .setSrcAccessMask(vk::AccessFlags())
+            .setDstStageMask(vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests)
+            .setDstAccessMask(vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite);
+        dependencies[2].setSrcSubpass(VK_SUBPASS_EXTERNAL).setDstSubpass(1)
+            .setSrcStageMask(vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eColorAttachmentOutput)
+            .setSrcAccessMask(vk::AccessFlagBits::eColorAttachmentWrite)
+            .setDstStageMask(vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests |
+                vk::PipelineStageFlagBits::eColorAttachmentOutput)
+            .setDstAccessMask(vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite |
+                vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite);
+    }
+    else
+    { // Depth written by subpass 0 reaches here through the first dependency
+        dependencies[1].setSrcSubpass(1).setDstSubpass(VK_SUBPASS_EXTERNAL)
+            .setSrcStageMask(vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests)
+            .setSrcAccessMask(vk::AccessFlagBits::eDepthStencilAttachmentWrite)
+            .setDstStageMask(vk::PipelineStageFlagBits::eComputeShader)
+            .setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+    }
+    uint32_t dependencyCount = late ? 3 : 2;
+
     std::array<vk::AttachmentDescription, 3> attachments = { colorDescription, depthDescription, resolveDescription };
     vk::RenderPassCreateInfo renderPassInfo;
     renderPassInfo.setAttachmentCount((uint32_t)attachments.size()).setPAttachments(attachments.data())
-        .setDependencyCount(0).setPDependencies(nullptr)
-        .setSubpassCount(1).setPSubpasses(&subpassDescription);
+        .setDependencyCount(dependencyCount).setPDependencies(dependencies.data())
+        .setSubpassCount((uint32_t)subpassDescriptions.size()).setPSubpasses(subpassDescriptions.data());
 
-    m_renderPass = m_vulkanDevice.m_logicalDevice.createRenderPass(renderPassInfo);
-    EVALUATE(m_renderPass, nullptr, == , "Couldn't create a render pass");
+    vk::RenderPass renderPass = m_vulkanDevice.m_logicalDevice.createRenderPass(renderPassInfo);
+    EVALUATE(renderPass, nullptr, == , "Couldn't create a render pass");
+    return renderPass;
 }
 
-auto SimpleScene::createCommandPool() -> void
+auto SimpleScene::createCommandPools() -> void
 {
     vk::CommandPoolCreateInfo poolInfo = {};
     poolInfo.setQueueFamilyIndex(m_vulkanDevice.m_families.graphicsIndex)
-        .setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer);
-    m_graphicsCommandPool = m_vulkanDevice.m_logicalDevice.createCommandPool(poolInfo);
-    EVALUATE(m_graphicsCommandPool, nullptr, == , "Couldn't create a graphics command pool");
+        .setFlags(vk::CommandPoolCreateFlagBits::eTransient);
+    for (uint32_t i = 0; i < VulkanRenderer::getMaxInFlightFrames(); ++i)
+    {
+        vk::CommandPool commandPool = m_vulkanDevice.m_logicalDevice.createCommandPool(poolInfo);
+        EVALUATE(commandPool, nullptr, == , "Couldn't create graphics command pool %d", i);
+        m_graphicsCommandPools.push_back(commandPool);
+    }
 }
 
 auto SimpleScene::createPipeline() -> void
 {
-    m_textureLayout = std::make_unique<TextureLayout>();
+    m_textureLayout = std::make_unique<TextureLayout>("Shaders/instanced.vert.spv");
     m_pipeline = std::make_unique<Pipeline>(m_textureLayout.get(),
-        m_renderPass, 0);
+        m_renderPass, 1);
+    // The pre-pass pipelines compile on the workers, the scene draws without the pre-pass until they're in
+    m_equalPipeline = std::make_unique<Pipeline>(m_textureLayout.get(),
+        m_renderPass, 1, DepthMode::eEqual, true);
+    m_depthLayout = std::make_unique<DepthOnlyLayout>(m_textureLayout.get());
+    m_depthPipeline = std::make_unique<DepthPipeline>(m_depthLayout.get(),
+        m_renderPass, 0, DepthMode::eDepthOnly, true);
+    m_overdrawCounter = std::make_unique<OverdrawCounter>();
+    m_gpuCulling = std::make_unique<GpuCulling>();
+    m_depthPyramid = std::make_unique<DepthPyramid>();
 }
 
 auto SimpleScene::loadModels() -> void
 {
-    m_testImage = std::make_unique<Image>("Resources/test.jpg",
+    m_assetLoader = std::make_unique<AssetLoader>();
+    m_testImage = m_assetLoader->loadImage("Resources/test.jpg",
         vk::ImageUsageFlagBits::eSampled,
         vk::MemoryPropertyFlagBits::eDeviceLocal, vk::MemoryPropertyFlagBits());
 
-    m_model = std::make_unique<Model>("Resources/Cube.obj");
+    m_model = m_assetLoader->loadModel("Resources/Cube.obj", Model::VertexFormat::ePackedPositionUV);
+
+    const int32_t gridSize = 32;
+    const float gridSpacing = 4.0f;
+    m_sceneGraph.reserve(1 + gridSize + gridSize * gridSize);
+    auto root = m_sceneGraph.createNode();
+    for (int32_t z = 0; z < gridSize; ++z)
+    {
+        auto row = m_sceneGraph.createNode(root, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, z * gridSpacing)));
+        for (int32_t x = 0; x < gridSize; ++x)
+            m_instances.push_back(m_sceneGraph.createNode(row, glm::translate(glm::mat4(1.0f), glm::vec3(x * gridSpacing, 0.0f, 0.0f))));
+    }
     m_camera = std::make_unique<FirstPersonCamera>(glm::radians(60.f), (float)4.f/3.f, 0.1f, 1000.f);
 
-    m_overlay = std::make_unique<UIOverlay>(m_renderPass);
+    m_overlay = std::make_unique<UIOverlay>(m_renderPass, 1);
     m_overlay->setUICallback(std::bind(&SimpleScene::renderUI, this, std::placeholders::_1));
 }
 
@@ -204,15 +326,17 @@ auto SimpleScene::createFramebuffers(uint32_t totalFrames, uint32_t width, uint3
     auto swapchainInfo = VulkanRenderer::Get()->getVulkanSwapchainInfo();
     // Create depth image
     m_depthImage = std::make_unique<Image>(width, height,
-        vk::Format::eD32Sfloat, vk::ImageUsageFlagBits::eDepthStencilAttachment,
+        vk::Format::eD32Sfloat, vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled,
         vk::ImageLayout::eDepthStencilAttachmentOptimal,
         vk::MemoryPropertyFlagBits::eDeviceLocal, vk::MemoryPropertyFlagBits(),
         m_vulkanDevice.m_bestSampling);
+    m_depthPyramid->create(*m_depthImage, width, height, m_vulkanDevice.m_bestSampling);
+    m_gpuCulling->setDepthPyramid(m_depthPyramid.get());
 
-    // Create color image
+    // Create color image, not transient: the early pass stores it and the late pass loads it
     m_colorImage = std::make_unique<Image>(width, height,
         swapchainCreateInfo.m_format.format,
-        vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransientAttachment,
+        vk::ImageUsageFlagBits::eColorAttachment,
         vk::ImageLayout::eColorAttachmentOptimal,
         vk::MemoryPropertyFlagBits::eDeviceLocal, vk::MemoryPropertyFlagBits(),
         m_vulkanDevice.m_bestSampling);
@@ -241,6 +365,7 @@ auto SimpleScene::createFramebuffers(uint32_t totalFrames, uint32_t width, uint3
 
 auto SimpleScene::cleanupFramebuffers() -> void
 {
+    m_depthPyramid->cleanup();
     m_depthImage.reset();
     m_colorImage.reset();
 
@@ -251,77 +376,171 @@ auto SimpleScene::cleanupFramebuffers() -> void
     m_framebuffers.clear();
 }
 
-auto SimpleScene::allocateCommandBuffers(uint32_t totalFrames, uint32_t width, uint32_t height) -> void
+auto SimpleScene::allocateCommandBuffers() -> void
+{
+    for (const auto commandPool : m_graphicsCommandPools)
+    {
+        vk::CommandBufferAllocateInfo allocationInfo = {};
+        allocationInfo.setCommandBufferCount(1);
+        allocationInfo.setCommandPool(commandPool);
+        allocationInfo.setLevel(vk::CommandBufferLevel::ePrimary);
+        auto commandBuffers = m_vulkanDevice.m_logicalDevice.allocateCommandBuffers(allocationInfo);
+        EVALUATE(commandBuffers.size(), 0, == , "Couldn't create command buffers");
+        m_commandBuffers.push_back(commandBuffers[0]);
+    }
+}
+
+auto SimpleScene::updateInstances() -> void
 {
-    vk::CommandBufferAllocateInfo allocationInfo = {};
-    allocationInfo.setCommandBufferCount(totalFrames);
-    allocationInfo.setCommandPool(m_graphicsCommandPool);
-    allocationInfo.setLevel(vk::CommandBufferLevel::ePrimary);
-    m_commandBuffers = m_vulkanDevice.m_logicalDevice.allocateCommandBuffers(allocationInfo);
-    EVALUATE(m_commandBuffers.size(), 0, == , "Couldn't create command buffers");
-    recordCommandBuffers();
+    m_instancesCulled = false;
+    if (!m_model.isReady() || m_instances.empty())
+        return;
+
+    CPU_PROFILE_ZONE("SimpleScene::updateInstances");
+    auto extent = VulkanRenderer::Get()->getVulkanSwapchainCreateInfo().m_extent;
+    float pixelsPerUnit = std::abs(m_camera->getProjection()[1][1]) * extent.height * 0.5f;
+
+    auto transforms = m_gpuCulling->mapInstances((uint32_t)m_instances.size());
+    for (uint32_t i = 0; i < m_instances.size(); ++i)
+        transforms[i] = m_sceneGraph.getWorldTransform(m_instances[i]);
+    m_gpuCulling->update(*m_model.get(), m_camera->getView(), m_camera->getProjection(), m_camera->getFrustum(), pixelsPerUnit);
+    m_textureLayout->setInstanceBuffer(m_gpuCulling->getInstanceBuffer());
+    m_instancesCulled = true;
 }
 
-auto SimpleScene::recordCommandBuffers() -> void
+auto SimpleScene::recordCommandBuffers(vk::CommandBuffer commandBuffer, uint32_t frameIndex) -> void
 {
-    VulkanRenderer::Get()->wait();
+    CPU_PROFILE_ZONE("SimpleScene::recordCommandBuffers");
     auto swapchainCreateInfo = VulkanRenderer::Get()->getVulkanSwapchainCreateInfo();
     vk::CommandBufferBeginInfo beginInfo;
-    beginInfo.setFlags(vk::CommandBufferUsageFlagBits::eSimultaneousUse);
+    beginInfo.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
     std::array<vk::ClearValue, 2> clearValues;
     clearValues[0].color.setFloat32({ 0.0f,0.0f,0.0f,1.0f });
     clearValues[1].depthStencil.setDepth(1.0f);
     clearValues[1].depthStencil.setStencil(0);
-    vk::ImageSubresourceRange range;
-    range.setAspectMask(vk::ImageAspectFlagBits::eColor);
-    range.setBaseArrayLayer(0);
-    range.setBaseMipLevel(0);
-    range.setLayerCount(1);
-    range.setLevelCount(1);
-    for (size_t i = 0; i < m_commandBuffers.size(); ++i)
+
+    commandBuffer.begin(beginInfo);
+    GpuProfiler::Get()->beginFrame(commandBuffer);
+    m_overdrawCounter->beginFrame(commandBuffer, swapchainCreateInfo.m_extent.width * swapchainCreateInfo.m_extent.height);
+
+    // Dynamic in every pipeline of both passes, so it stays set across them
+    auto extent = swapchainCreateInfo.m_extent;
+    vk::Viewport viewport(0.0f, 0.0f, (float)extent.width, (float)extent.height, 0.0f, 1.0f);
+    vk::Rect2D scissor({ 0, 0 }, extent);
+    commandBuffer.setViewport(0, 1, &viewport);
+    commandBuffer.setScissor(0, 1, &scissor);
+
+    // Decided once, both subpasses of both passes must agree
+    m_usePrePass = m_depthPrePass && m_depthPipeline->getPipeline() && m_equalPipeline->getPipeline();
     {
-        m_commandBuffers[i].begin(beginInfo);
+        GpuProfiler::Scope frameScope(commandBuffer, "SimpleScene");
+        if (m_instancesCulled)
+        {
+            GpuProfiler::Scope cullingScope(commandBuffer, "Culling");
+            m_gpuCulling->dispatch(commandBuffer, GpuCulling::eEarly);
+        }
 
         vk::RenderPassBeginInfo renderPassBeginInfo;
         renderPassBeginInfo.setClearValueCount((uint32_t)clearValues.size()).setPClearValues(clearValues.data())
             .setRenderPass(m_renderPass).setRenderArea({ {0u, 0u}, swapchainCreateInfo.m_extent })
-            .setFramebuffer(m_framebuffers[i]);
+            .setFramebuffer(m_framebuffers[frameIndex]);
 
-        m_commandBuffers[i].beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eInline);
-        m_commandBuffers[i].bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipeline->getPipeline());
+        // Copies visible last frame, as far as last frame's depth can tell
+        commandBuffer.beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eInline);
+        drawModelDepth(commandBuffer, GpuCulling::eEarly);
+        commandBuffer.nextSubpass(vk::SubpassContents::eInline);
+        drawModel(commandBuffer, GpuCulling::eEarly);
+        commandBuffer.endRenderPass();
 
-        m_textureLayout->bindDescriptorSets(m_commandBuffers[i]);
-        m_model->bind(m_commandBuffers[i]);
+        if (m_instancesCulled)
+        {
+            GpuProfiler::Scope occlusionScope(commandBuffer, "Occlusion");
+            m_depthPyramid->build(commandBuffer);
+            m_gpuCulling->dispatch(commandBuffer, GpuCulling::eLate);
+        }
 
-        m_commandBuffers[i].drawIndexed(m_model->getIndexCount(), 1, 0, 0, 0);
+        // Copies the early phase wrongly took as occluded, then the overlay
+        renderPassBeginInfo.setRenderPass(m_lateRenderPass);
+        commandBuffer.beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eInline);
+        drawModelDepth(commandBuffer, GpuCulling::eLate);
+        commandBuffer.nextSubpass(vk::SubpassContents::eInline);
+        drawModel(commandBuffer, GpuCulling::eLate);
+        {
+            GpuProfiler::Scope overlayScope(commandBuffer, "UIOverlay");
+            renderOverlay(commandBuffer);
+        }
+        commandBuffer.endRenderPass();
+    }
+    commandBuffer.end();
+}
 
-        renderOverlay(m_commandBuffers[i]);
+auto SimpleScene::drawModel(vk::CommandBuffer commandBuffer, GpuCulling::Phase phase) -> void
+{
+    if (!m_model.isReady() || !m_textureBound || !m_instancesCulled)
+        return;
+
+    GpuProfiler::Scope modelScope(commandBuffer, phase == GpuCulling::eEarly ? "Model (early)" : "Model (late)");
+    auto pipeline = m_usePrePass ? m_equalPipeline.get() : m_pipeline.get();
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline->getPipeline());
+
+    m_textureLayout->bindDescriptorSets(commandBuffer);
+    m_model.get()->bind(commandBuffer);
+    m_overdrawCounter->begin(commandBuffer);
+    m_gpuCulling->draw(commandBuffer, Vertex::getInstanceBinding(), phase);
+    m_overdrawCounter->end(commandBuffer);
+}
 
-        m_commandBuffers[i].endRenderPass();
+auto SimpleScene::drawModelDepth(vk::CommandBuffer commandBuffer, GpuCulling::Phase phase) -> void
+{
+    if (!m_usePrePass || !m_model.isReady() || !m_textureBound || !m_instancesCulled)
+        return;
 
-        m_commandBuffers[i].end();
+    // Same vertex buffer and instance ranges as drawModel, only the packed positions are fetched
+    GpuProfiler::Scope depthScope(commandBuffer, phase == GpuCulling::eEarly ? "Depth (early)" : "Depth (late)");
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_depthPipeline->getPipeline());
 
-    }
+    m_depthLayout->bindDescriptorSets(commandBuffer);
+    m_model.get()->bind(commandBuffer);
+    m_gpuCulling->draw(commandBuffer, DepthVertex::getInstanceBinding(), phase);
 }
 
 auto SimpleScene::cleanupCommandBuffers() -> void
 {
-    if (m_commandBuffers.size())
+    for (uint32_t i = 0; i < m_commandBuffers.size(); ++i)
     {
-        m_vulkanDevice.m_logicalDevice.freeCommandBuffers(m_graphicsCommandPool, m_commandBuffers);
-        m_commandBuffers.clear();
+        m_vulkanDevice.m_logicalDevice.freeCommandBuffers(m_graphicsCommandPools[i], 1, &m_commandBuffers[i]);
     }
+    m_commandBuffers.clear();
 }
 
 auto SimpleScene::renderOverlay(vk::CommandBuffer cmd) -> void
 {
-    auto width = WindowObject::Get()->getWindowWidth(), height = WindowObject::Get()->getWindowHeight();
-    m_overlay->render(cmd, width, height);
+    auto extent = VulkanRenderer::Get()->getVulkanSwapchainCreateInfo().m_extent;
+    m_overlay->render(cmd, (float)extent.width, (float)extent.height);
 }
 
 auto SimpleScene::renderUI(float frameTime) -> void
 {
     m_overlay->begin("SimpleScene");
     m_overlay->text(appendToString("SimpleScene: framtime = ", frameTime));
+    if (m_model.isReady())
+    {
+        m_overlay->text(appendToString("Visible instances: ", m_gpuCulling->getVisibleCount(), "/", m_instances.size(),
+            " (", m_gpuCulling->getVisibleCount(GpuCulling::eLate), " found by the late phase)"));
+        for (uint32_t lod = 0; lod < m_model.get()->getLodCount(); ++lod)
+        {
+            m_overlay->text(appendToString("LOD ", lod, ": ", m_gpuCulling->getLodInstanceCount(lod), " instances of ",
+                m_model.get()->getLod(lod).m_indexCount / 3, " triangles"));
+        }
+    }
+    m_overlay->checkbox("Depth pre-pass", &m_depthPrePass);
+    m_overlay->text(appendToString("Pipelines: ", PipelineRegistry::Get()->getPipelineCount()));
+    if (m_overdrawCounter->isSupported())
+    {
+        m_overlay->text(appendToString("Overdraw: ", m_overdrawCounter->getOverdraw(), " shaded fragments per pixel (",
+            m_overdrawCounter->getFragmentCount(), ")"));
+    }
     m_overlay->end();
+
+    m_overlay->gpuProfilerPanel();
 }
\ No newline at end of file
@@ -4,18 +4,29 @@
 #include "../Graphics/Interfaces/IGraphicsScene.h"
 #include "../Graphics/Interfaces/IFrameDependent.h"
 #include "../Graphics/Pipeline/Layout/TextureLayout.h"
-#include "../Graphics/Vertex/PositionColorVertex.h"
+#include "../Graphics/Pipeline/Layout/DepthOnlyLayout.h"
+#include "../Graphics/Vertex/PackedPositionUVVertex.h"
+#include "../Graphics/Vertex/PackedPositionVertex.h"
+#include "../Graphics/Vertex/InstanceIndex.h"
 #include "../Graphics/Pipeline/SimplePipeline.h"
 #include "../Graphics/Utils/Image.h"
 #include "../Graphics/Model.h"
 #include "../Graphics/UIOverlay.h"
+#include "../Graphics/Utils/AssetLoader.h"
+#include "../Graphics/Utils/GpuCulling.h"
+#include "../Graphics/Utils/OverdrawCounter.h"
+#include "SceneGraph.h"
 
 #include "../Gameplay/FirstPersonCamera.h"
+#include "../Gameplay/CameraPath.h"
 
 class SimpleScene :
     public IGraphicsScene, public IFrameDependent
 {
-    using Pipeline = SimplePipeline<TextureLayout, PositionColorVertex>;
+    using Vertex = InstancedVertex<PackedPositionUVVertex, InstanceIndex>;
+    using Pipeline = SimplePipeline<TextureLayout, Vertex>;
+    using DepthVertex = InstancedVertex<PackedPositionVertex, InstanceIndex>;
+    using DepthPipeline = SimplePipeline<DepthOnlyLayout, DepthVertex>;
 public:
     SimpleScene();
     ~SimpleScene();
@@ -24,6 +35,8 @@ public:
     virtual std::vector<vk::CommandBuffer>  getCommandBuffers(uint32_t currentFrame) override;
 
     auto                                    update(float frametime) -> void;
+    auto                                    setCameraPath(CameraPath* path) -> void;
+    auto                                    isLoading() const -> bool { return m_assetLoader->getPendingCount() != 0; };
 
     // Inherited via IFrameDependent
     virtual void create(uint32_t totalFrames, uint32_t width, uint32_t height) override;
@@ -32,15 +45,19 @@ public:
 
 private:
     auto                            createRenderPass() -> void;
-    auto                            createCommandPool() -> void;
+    auto                            createRenderPass(bool late) -> vk::RenderPass;
+    auto                            createCommandPools() -> void;
     auto                            createPipeline() -> void;
     auto                            loadModels() -> void;
 
     auto                            createFramebuffers(uint32_t totalFrames, uint32_t width, uint32_t height) -> void;
     auto                            cleanupFramebuffers() -> void;
 
-    auto                            allocateCommandBuffers(uint32_t totalFrames, uint32_t width, uint32_t height) -> void;
-    auto                            recordCommandBuffers() -> void;
+    auto                            allocateCommandBuffers() -> void;
+    auto                            updateInstances() -> void;
+    auto                            recordCommandBuffers(vk::CommandBuffer commandBuffer, uint32_t frameIndex) -> void;
+    auto                            drawModel(vk::CommandBuffer commandBuffer, GpuCulling::Phase phase) -> void;
+    auto                            drawModelDepth(vk::CommandBuffer commandBuffer, GpuCulling::Phase phase) -> void;
     auto                            cleanupCommandBuffers() -> void;
 
     auto                            renderOverlay(vk::CommandBuffer) -> void;
@@ -48,29 +65,50 @@ private:
 
 public:
     // TODO: Make wrapper over RenderPass and framebuffers
-    vk::RenderPass                  m_renderPass;
+    vk::RenderPass                  m_renderPass;       // Early phase, clears
+    vk::RenderPass                  m_lateRenderPass;   // Late phase and overlay, resolves
     std::unique_ptr<Image>          m_depthImage;
     std::unique_ptr<Image>          m_colorImage;
     std::vector<vk::Framebuffer>    m_framebuffers;
 
 
-    // Command pool and buffers
-    vk::CommandPool                 m_graphicsCommandPool;
+    // Command pools and buffers, one per in-flight frame. A pool is reset as a whole before its frame is recorded
+    std::vector<vk::CommandPool>    m_graphicsCommandPools;
     std::vector<vk::CommandBuffer>  m_commandBuffers;
 
-    // Models
-    std::unique_ptr<Model>          m_model;
-    std::unique_ptr<Image>          m_testImage;
+    // Models, loaded in the background. The model is drawn once it and its texture are in
+    std::unique_ptr<AssetLoader>    m_assetLoader;
+    AssetHandle<Model>              m_model;
+    AssetHandle<Image>              m_testImage;
+    bool                            m_textureBound = false;
+
+    // Copies of the model, nodes of the scene graph. Each frame the GPU culls them against the frustum and the
+    // depth pyramid, and groups the visible ones by level of detail, one indirect draw per level and phase
+    SceneGraph                      m_sceneGraph;
+    std::vector<SceneGraph::NodeId> m_instances;
+    std::unique_ptr<GpuCulling>     m_gpuCulling;
+    std::unique_ptr<DepthPyramid>   m_depthPyramid;
+    bool                            m_instancesCulled = false;
 
     std::unique_ptr<UIOverlay>      m_overlay;
 
 
-    // Pipeline info
+    // Pipeline info. With the depth pre-pass on, the model's depth is laid down by m_depthPipeline in subpass 0,
+    // and m_equalPipeline shades each covered pixel once in subpass 1. Off, m_pipeline does both in subpass 1
     std::unique_ptr<TextureLayout>  m_textureLayout;
     std::unique_ptr<Pipeline>       m_pipeline;
+    std::unique_ptr<Pipeline>       m_equalPipeline;
+    std::unique_ptr<DepthOnlyLayout>
+                                    m_depthLayout;
+    std::unique_ptr<DepthPipeline>  m_depthPipeline;
+    bool                            m_depthPrePass = true;
+    bool                            m_usePrePass = false;   // m_depthPrePass, once its pipelines are ready
+    std::unique_ptr<OverdrawCounter>
+                                    m_overdrawCounter;
 
 
     std::unique_ptr<FirstPersonCamera>
                                     m_camera;
+    CameraPath*                     m_cameraPath = nullptr;
 };
 
@@ -0,0 +1,26 @@
+#version 450
+
+
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in uint inInstance;     // Index into instances, of a copy culling.comp kept
+
+
+layout(binding = 0) uniform UniformBufferObject
+{
+    mat4 world;         // Shared by every instance, the model's own vertex transform
+    mat4 view;
+    mat4 projection;
+} ubo;
+
+layout(std430, binding = 2) readonly buffer Instances
+{
+    mat4 instances[];   // World matrices of every copy, visible or not
+};
+
+// Same expression as instanced.vert, the colour pass tests its depth for equality against this one
+invariant gl_Position;
+
+void main()
+{
+    gl_Position = ubo.projection * ubo.view * instances[inInstance] * ubo.world * inPosition;
+}
@@ -0,0 +1,31 @@
+#version 450
+
+
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec4 inColor;
+layout(location = 2) in uint inInstance;     // Index into instances, of a copy culling.comp kept
+
+layout(location = 0) out vec4 outColor;
+
+
+layout(binding = 0) uniform UniformBufferObject
+{
+    mat4 world;         // Shared by every instance, the model's own vertex transform
+    mat4 view;
+    mat4 projection;
+} ubo;
+
+layout(std430, binding = 2) readonly buffer Instances
+{
+    mat4 instances[];   // World matrices of every copy, visible or not
+};
+
+// Must match depthonly.vert bit for bit, the depth pre-pass is tested with eEqual
+invariant gl_Position;
+
+void main()
+{
+    vec4 finalPosition = inPosition;
+    gl_Position = ubo.projection * ubo.view * instances[inInstance] * ubo.world * finalPosition;
+    outColor = inColor;
+}
@@ -1,14 +1,26 @@
 #include "Game.h"
+#include "Core/CpuProfiler.h"
 #include <stdio.h>
 
 #include <HasMethod.h>
 
+constexpr const uint32_t HEADLESS_DEFAULT_FRAMES = 1000;
 
-int main()
+int main(int argc, char** argv)
 {
+    bool headless = false;
+    uint32_t headlessFrames = HEADLESS_DEFAULT_FRAMES;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--headless"))
+            headless = true;
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+            headlessFrames = (uint32_t)std::stoul(argv[++i]);
+    }
+
     try
     {
-        auto joc = Game::Get();
+        auto joc = Game::Get(headless, headlessFrames);
         joc->run();
         joc->reset();
     }
@@ -26,9 +38,13 @@ int main()
     Logger::dumpJson(logs);
 
     logs.close();
+
+    std::ofstream trace("trace.json");
+    CpuProfiler::dumpChromeTrace(trace);
+    trace.close();
 #if DEBUG || _DEBUG
     Logger::dumpJson(std::cout);
 #endif
     return 0;
 
-}
\ No newline at end of file
+}